@@ -31,7 +31,8 @@ void canvas_setgraph(t_glist* x, int flag, int nogoprect);
 }
 
 Canvas::Canvas(PluginEditor* parent, pd::Patch::Ptr p, Component* parentGraph)
-    : NVGComponent(this)
+    : SettingsFileListener({ "grid_size", "border", "edit", "lock", "run", "alt", "alt_mode", "hvcc_mode", "patch_downwards_only" })
+    , NVGComponent(this)
     , editor(parent)
     , pd(parent->pd)
     , refCountedPatch(p)
@@ -124,6 +125,9 @@ Canvas::Canvas(PluginEditor* parent, pd::Patch::Ptr p, Component* parentGraph)
     // init border for testing
     settingsChanged("border", SettingsFile::getInstance()->getPropertyAsValue("border"));
 
+    hvccMode = SettingsFile::getInstance()->getProperty<bool>("hvcc_mode");
+    patchDownwardsOnly = SettingsFile::getInstance()->getProperty<bool>("patch_downwards_only");
+
     // Add draggable border for setting graph position
     if (getValue<bool>(isGraphChild) && !isGraph) {
         graphArea = std::make_unique<GraphArea>(this);
@@ -152,7 +156,7 @@ Canvas::Canvas(PluginEditor* parent, pd::Patch::Ptr p, Component* parentGraph)
     performSynchronise();
 
     // Start in unlocked mode if the patch is empty
-    if (objects.empty()) {
+    if (objects.empty() && !isLoadingObjects) {
         locked = false;
         if (auto patchPtr = patch.getPointer())
             patchPtr->gl_edit = false;
@@ -185,6 +189,8 @@ Canvas::Canvas(PluginEditor* parent, pd::Patch::Ptr p, Component* parentGraph)
         patch.setVisible(true);
     }
 
+    lastShownTime = Time::getMillisecondCounter();
+
     lookAndFeelChanged();
 }
 
@@ -504,15 +510,39 @@ void Canvas::performRender(NVGcontext* nvg, Rectangle<int> invalidRegion)
         drawBorder(true, false);
 
     // Render objects like [drawcurve], [fillcurve] etc. at the back
+    // Scalars that share a template usually have the same style, so we batch those into one draw call
+    NVGComponent* batchOwner = nullptr;
+    hash32 batchStyle = 0;
     for (auto drawable : drawables) {
-        if (drawable) {
-            auto* component = dynamic_cast<Component*>(drawable.get());
-            if (invalidRegion.intersects(component->getBounds())) {
-                drawable->render(nvg);
-            }
+        if (!drawable)
+            continue;
+
+        auto* component = dynamic_cast<Component*>(drawable.get());
+        if (!invalidRegion.intersects(component->getBounds()))
+            continue;
+
+        auto style = drawable->getBatchStyle();
+        if (batchOwner && style != batchStyle) {
+            batchOwner->finishBatch(nvg);
+            batchOwner = nullptr;
         }
+
+        if (!style) {
+            drawable->render(nvg);
+            continue;
+        }
+
+        if (!batchOwner) {
+            nvgBeginPath(nvg);
+            batchOwner = drawable.get();
+            batchStyle = style;
+        }
+        drawable->addToBatch(nvg);
     }
 
+    if (batchOwner)
+        batchOwner->finishBatch(nvg);
+
     if (::getValue<bool>(presentationMode) || isGraph) {
         renderAllObjects(nvg, invalidRegion);
         // render presentation mode as clipped 'virtual' plugin view
@@ -690,6 +720,17 @@ void Canvas::settingsChanged(String const& name, var const& value)
         updateOverlays();
         break;
     }
+    case hash("hvcc_mode"): {
+        hvccMode = static_cast<bool>(value);
+        for (auto* object : objects) {
+            object->updateHvccCompatibility();
+        }
+        break;
+    }
+    case hash("patch_downwards_only"):
+        patchDownwardsOnly = static_cast<bool>(value);
+        repaint();
+        break;
     }
 }
 
@@ -779,6 +820,51 @@ void Canvas::saveViewportState()
     }
 }
 
+// Throw away all objects, connections and images of a canvas in a background tab
+// The patch stays open in pd, and the components are recreated from it by rehydrate()
+void Canvas::hibernate()
+{
+    if (isHibernated || isGraph)
+        return;
+
+    saveViewportState();
+    deselectAll();
+
+    // Set this before deleting the objects, so subpatch objects won't close the tabs of their subpatches
+    isHibernated = true;
+    isLoadingObjects = false;
+
+    connections.clear_and_release();
+    objects.clear_and_release();
+
+    dotsLargeImage = NVGImage();
+    resizeHandleImage = NVGImage();
+    presentationShadowImage = NVGImage();
+    lastObjectGridSize = -1;
+}
+
+void Canvas::rehydrate()
+{
+    if (!isHibernated)
+        return;
+
+    isHibernated = false;
+
+    performSynchronise();
+    updateOverlays();
+    orderConnections();
+    restoreViewportState();
+}
+
+size_t Canvas::getEstimatedMemoryUsage() const
+{
+    auto getImageSize = [](NVGImage const& image) {
+        return static_cast<size_t>(image.imageWidth) * image.imageHeight * 4;
+    };
+
+    return objects.size() * estimatedObjectMemory + connections.size() * estimatedConnectionMemory + getImageSize(dotsLargeImage) + getImageSize(resizeHandleImage) + getImageSize(presentationShadowImage);
+}
+
 void Canvas::zoomToFitAll()
 {
     if (objects.empty() || !viewport)
@@ -881,11 +967,15 @@ void Canvas::saveAs(std::function<void()> const& nestedCallback)
 
 void Canvas::handleAsyncUpdate()
 {
-    performSynchronise();
+    if (isLoadingObjects && !needsSynchronise)
+        loadNextObjectBatch();
+    else
+        performSynchronise();
 }
 
 void Canvas::synchronise()
 {
+    needsSynchronise = true;
     triggerAsyncUpdate();
 }
 
@@ -911,6 +1001,14 @@ void Canvas::synchroniseSplitCanvas()
 // Used for loading and for complicated actions like undo/redo
 void Canvas::performSynchronise()
 {
+    needsSynchronise = false;
+
+    // Hibernated canvases will synchronise when they are shown again
+    if (isHibernated) {
+        needsSearchUpdate = true;
+        return;
+    }
+
     if (auto patchPtr = patch.getPointer()) {
         patch.setCurrent();
         pd->sendMessagesFromQueue();
@@ -946,37 +1044,170 @@ void Canvas::performSynchronise()
     auto pdObjects = patch.getObjects();
     objects.reserve(pdObjects.size());
 
-    for (auto object : pdObjects) {
-        auto* it = std::find_if(objects.begin(), objects.end(), [&object](Object const* b) { return b->getPointer() && b->getPointer() == object.getRawUnchecked<void>(); });
-        if (!object.isValid())
+    UnorderedMap<void*, Object*> existingObjects;
+    for (auto* object : objects) {
+        if (auto* ptr = object->getPointer())
+            existingObjects[ptr] = object;
+    }
+
+    SmallArray<int> missingObjects;
+    for (int i = 0; i < pdObjects.size(); i++) {
+        if (!pdObjects[i].isValid())
             continue;
 
-        if (it == objects.end()) {
-            auto* newObject = objects.add(object, this);
-            newObject->toFront(false);
+        auto it = existingObjects.find(pdObjects[i].getRawUnchecked<void>());
+        if (it == existingObjects.end()) {
+            missingObjects.add(i);
+            continue;
+        }
 
-            if (newObject->gui && newObject->gui->getLabel())
-                newObject->gui->getLabel()->toFront(false);
-        } else {
-            auto* object = *it;
+        auto* object = it->second;
 
-            // Check if number of inlets/outlets is correct
-            object->updateIolets();
-            object->updateBounds();
+        // Check if number of inlets/outlets is correct
+        object->updateIolets();
+        object->updateBounds();
+
+        if (object->gui)
+            object->gui->update();
+    }
+
+    createObjects(pdObjects, missingObjects, false);
+    sortObjects(pdObjects, true);
+    synchroniseConnections();
+
+    if (!isGraph) {
+        setTransform(AffineTransform().scaled(getValue<float>(zoomScale)));
+    }
+
+    if (graphArea)
+        graphArea->updateBounds();
+
+    editor->updateCommandStatus();
+    repaint();
+
+    needsSearchUpdate = true;
+
+    pd->updateObjectImplementations();
+    pd->invalidateParameterObjectIndex();
+}
+
+// Creates components for pd objects that don't have one yet
+// Large patches are loaded progressively: objects that are visible or selected in pd are created right away, the rest is created in time-sliced batches
+void Canvas::createObjects(HeapArray<pd::WeakReference>& pdObjects, SmallArray<int>& missingObjects, bool loadEverything)
+{
+    auto const loadProgressively = !isGraph && !loadEverything && static_cast<int>(missingObjects.size()) > progressiveLoadingThreshold;
+    int numPrioritised = missingObjects.size();
+
+    if (loadProgressively) {
+        auto viewArea = viewport ? viewport->getViewArea() : getLocalBounds();
+
+        // The viewport might not have been laid out yet when opening a patch, assume it will fill the editor
+        if (viewArea.isEmpty())
+            viewArea.setSize(editor->getWidth(), editor->getHeight());
+
+        auto visibleArea = viewArea.transformedBy(getTransform().inverted()) - canvasOrigin;
 
-            object->toFront(false);
-            if (object->gui && object->gui->getLabel())
-                object->gui->getLabel()->toFront(false);
-            if (object->gui)
-                object->gui->update();
+        if (auto patchPtr = patch.getPointer()) {
+            auto it = std::stable_partition(missingObjects.begin(), missingObjects.end(), [&pdObjects, &patchPtr, visibleArea](int index) {
+                auto* object = pdObjects[index].getRawUnchecked<t_gobj>();
+
+                int x, y, w, h;
+                pd::Interface::getObjectBounds(patchPtr.get(), object, &x, &y, &w, &h);
+                return visibleArea.intersects(Rectangle<int>(x, y, std::max(w, 1), std::max(h, 1))) || glist_isselected(patchPtr.get(), object);
+            });
+            numPrioritised = static_cast<int>(it - missingObjects.begin());
         }
     }
 
-    // Make sure objects have the same order
-    std::sort(objects.begin(), objects.end(),
-        [&pdObjects](Object* first, Object* second) mutable {
-            return pdObjects.index_of(first->getPointer()) < pdObjects.index_of(second->getPointer());
-        });
+    auto startTime = Time::getMillisecondCounter();
+    int numCreated = 0;
+    for (auto index : missingObjects) {
+        if (loadProgressively && numCreated >= numPrioritised && Time::getMillisecondCounter() - startTime >= loadingTimeSlice)
+            break;
+
+        objects.add(pdObjects[index], this);
+        numCreated++;
+    }
+
+    isLoadingObjects = numCreated < static_cast<int>(missingObjects.size());
+    if (isLoadingObjects)
+        triggerAsyncUpdate();
+}
+
+// Continue loading a patch that is loaded progressively, without updating the objects that already exist
+void Canvas::loadNextObjectBatch(bool loadEverything)
+{
+    if (!isLoadingObjects || isHibernated || !patch.getPointer())
+        return;
+
+    auto pdObjects = patch.getObjects();
+
+    UnorderedSet<void*> existingObjects;
+    for (auto* object : objects) {
+        existingObjects.insert(object->getPointer());
+    }
+
+    SmallArray<int> missingObjects;
+    for (int i = 0; i < pdObjects.size(); i++) {
+        if (pdObjects[i].isValid() && !existingObjects.contains(pdObjects[i].getRawUnchecked<void>()))
+            missingObjects.add(i);
+    }
+
+    createObjects(pdObjects, missingObjects, loadEverything);
+
+    // Objects are created out of order, so we restore the stacking order once everything is there
+    sortObjects(pdObjects, !isLoadingObjects);
+    synchroniseConnections();
+
+    repaint();
+}
+
+// Make sure all objects are loaded, for when we need to find or select objects in a patch that might still be loading
+void Canvas::loadAllObjects()
+{
+    rehydrate();
+    loadNextObjectBatch(true);
+}
+
+// Make sure objects have the same order as in pd
+void Canvas::sortObjects(HeapArray<pd::WeakReference>& pdObjects, bool updateStackingOrder)
+{
+    UnorderedMap<void*, int> pdObjectIndices;
+    for (int i = 0; i < pdObjects.size(); i++) {
+        pdObjectIndices[pdObjects[i].getRawUnchecked<void>()] = i;
+    }
+
+    auto getIndex = [&pdObjectIndices](Object const* object) {
+        auto it = pdObjectIndices.find(object->getPointer());
+        return it != pdObjectIndices.end() ? it->second : -1;
+    };
+
+    std::stable_sort(objects.begin(), objects.end(), [&getIndex](Object const* first, Object const* second) {
+        return getIndex(first) < getIndex(second);
+    });
+
+    if (!updateStackingOrder)
+        return;
+
+    for (auto* object : objects) {
+        object->toFront(false);
+        if (object->gui && object->gui->getLabel())
+            object->gui->getLabel()->toFront(false);
+    }
+}
+
+void Canvas::synchroniseConnections()
+{
+    UnorderedMap<void*, Object*> objectsByPointer;
+    for (auto* object : objects) {
+        if (auto* ptr = object->getPointer())
+            objectsByPointer[ptr] = object;
+    }
+
+    UnorderedMap<void*, Connection*> existingConnections;
+    for (auto* connection : connections) {
+        existingConnections[connection->getPointer()] = connection;
+    }
 
     auto pdConnections = patch.getConnections();
     connections.reserve(pdConnections.size());
@@ -984,71 +1215,48 @@ void Canvas::performSynchronise()
     for (auto& connection : pdConnections) {
         auto& [ptr, inno, inobj, outno, outobj] = connection;
 
-        Iolet *inlet = nullptr, *outlet = nullptr;
-
         // Find the objects that this connection is connected to
-        for (auto* obj : objects) {
-            if (outobj && &outobj->te_g == obj->getPointer()) {
-
-                // Check if we have enough outlets, should never return false
-                if (isPositiveAndBelow(obj->numInputs + outno, obj->iolets.size())) {
-                    outlet = obj->iolets[obj->numInputs + outno];
-                } else {
-                    break;
-                }
-            }
-            if (inobj && &inobj->te_g == obj->getPointer()) {
+        auto outObject = objectsByPointer.find(outobj ? &outobj->te_g : nullptr);
+        auto inObject = objectsByPointer.find(inobj ? &inobj->te_g : nullptr);
 
-                // Check if we have enough inlets, should never return false
-                if (isPositiveAndBelow(inno, obj->iolets.size())) {
-                    inlet = obj->iolets[inno];
-                } else {
-                    break;
-                }
-            }
+        // When a patch is loaded progressively, the objects might not exist yet
+        if (outObject == objectsByPointer.end() || inObject == objectsByPointer.end()) {
+            jassert(isLoadingObjects);
+            continue;
         }
 
-        // This shouldn't be necessary, but just to be sure...
-        if (!inlet || !outlet) {
+        auto* outObj = outObject->second;
+        auto* inObj = inObject->second;
+
+        // Check if we have enough iolets, should never return false
+        if (!isPositiveAndBelow(outObj->numInputs + outno, outObj->iolets.size()) || !isPositiveAndBelow(inno, inObj->iolets.size())) {
             jassertfalse;
             continue;
         }
 
-        auto* it = std::find_if(connections.begin(), connections.end(),
-            [c_ptr = ptr](auto* c) {
-                return c_ptr == c->getPointer();
-            });
+        auto* outlet = outObj->iolets[outObj->numInputs + outno];
+        auto* inlet = inObj->iolets[inno];
 
-        if (it == connections.end()) {
+        auto it = existingConnections.find(ptr);
+        if (it == existingConnections.end()) {
             connections.add(this, inlet, outlet, ptr);
         } else {
-            auto& c = *(*it);
+            auto& c = *it->second;
 
             // This is necessary to make resorting a subpatchers iolets work
             // And it can't hurt to check if the connection is valid anyway
             if (c.inlet != inlet || c.outlet != outlet) {
-                int idx = connections.index_of(*it);
-                connections.remove_one(*it);
+                int idx = connections.index_of(&c);
+                connections.remove_one(&c);
                 connections.insert(idx, this, inlet, outlet, ptr);
             } else {
+                // The iolets stay the same when the objects renumber them, so the indices have to be refreshed
+                c.outIdx = outno;
+                c.inIdx = inno;
                 c.popPathState();
             }
         }
     }
-
-    if (!isGraph) {
-        setTransform(AffineTransform().scaled(getValue<float>(zoomScale)));
-    }
-
-    if (graphArea)
-        graphArea->updateBounds();
-
-    editor->updateCommandStatus();
-    repaint();
-
-    needsSearchUpdate = true;
-
-    pd->updateObjectImplementations();
 }
 
 void Canvas::updateDrawables()
@@ -1605,11 +1813,12 @@ void Canvas::pasteSelection()
     for (auto* object : objects) {
         auto* objectPtr = static_cast<t_gobj*>(object->getPointer());
         if (objectPtr && glist_isselected(patchPtr, objectPtr)) {
-            setSelected(object, true);
+            setSelected(object, true, false);
             pastedObjects.emplace_back(objectPtr);
         }
     }
     pd->unlockAudioThread();
+    editor->updateCommandStatus();
 
     patch.deselectAll();
     pastedObjects.clear();
@@ -1681,16 +1890,20 @@ void Canvas::duplicateSelection()
 
     patch.moveObjects(moveObjects, dragState.duplicateOffset.x, dragState.duplicateOffset.y);
 
-    for (auto* object : objects) {
+    // Only the duplicated objects have moved
+    pd->lockAudioThread();
+    for (auto* object : duplicated) {
         object->updateBounds();
     }
+    pd->unlockAudioThread();
 
     // Select the newly duplicated objects, and calculate new viewport position
     Rectangle<int> selectionBounds;
     for (auto* obj : duplicated) {
-        setSelected(obj, true);
+        setSelected(obj, true, false);
         selectionBounds = selectionBounds.getUnion(obj->getBounds());
     }
+    editor->updateCommandStatus();
 
     selectionBounds = selectionBounds.transformedBy(getTransform());
 
@@ -1975,6 +2188,9 @@ void Canvas::encapsulateSelection()
     if (!patchPtr)
         return;
 
+    // Removing, pasting and reconnecting will rebuild DSP once, after the whole encapsulation
+    pd::Instance::ScopedDSPRebuild dspRebuild(pd);
+
     // Apply the changed on Pd's thread
     pd->lockAudioThread();
 
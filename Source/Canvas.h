@@ -115,6 +115,9 @@ public:
     void performSynchronise();
     void handleAsyncUpdate() override;
 
+    void loadNextObjectBatch(bool loadEverything = false);
+    void loadAllObjects();
+
     void updateDrawables();
 
     bool keyPressed(KeyPress const& key) override;
@@ -148,6 +151,11 @@ public:
     void restoreViewportState();
     void saveViewportState();
 
+    // Release the components and images of a canvas that isn't shown, while keeping its patch open
+    void hibernate();
+    void rehydrate();
+    size_t getEstimatedMemoryUsage() const;
+
     void zoomToFitAll();
 
     float getRenderScale() const;
@@ -231,6 +239,13 @@ public:
     bool isGraph : 1 = false;
     bool isDraggingLasso : 1 = false;
     bool needsSearchUpdate : 1 = false;
+    bool isHibernated : 1 = false;
+    bool isLoadingObjects : 1 = false;
+    bool needsSynchronise : 1 = false;
+
+    // Settings that objects and iolets read from their canvas, so they don't have to listen to the settings file themselves
+    bool hvccMode : 1 = false;
+    bool patchDownwardsOnly : 1 = false;
 
     Value isGraphChild = SynchronousValue(var(false));
     Value hideNameAndArgs = SynchronousValue(var(false));
@@ -245,6 +260,9 @@ public:
 
     int lastObjectGridSize = -1;
 
+    // Last time this canvas was shown in a split, used to decide when to hibernate it
+    uint32 lastShownTime = 0;
+
     NVGImage dotsLargeImage;
 
     Point<int> const canvasOrigin;
@@ -264,6 +282,14 @@ public:
 
     inline static constexpr int infiniteCanvasSize = 128000;
 
+    // Patches with more new objects than this are loaded progressively, in batches that take about loadingTimeSlice milliseconds
+    inline static constexpr int progressiveLoadingThreshold = 500;
+    inline static constexpr uint32 loadingTimeSlice = 12;
+
+    // Rough GUI memory cost of a single object (including iolets, text and framebuffers) and connection
+    inline static constexpr size_t estimatedObjectMemory = 64 * 1024;
+    inline static constexpr size_t estimatedConnectionMemory = 8 * 1024;
+
     Component objectLayer;
     Component connectionLayer;
 
@@ -323,6 +349,10 @@ private:
 
     void parentHierarchyChanged() override;
 
+    void createObjects(HeapArray<pd::WeakReference>& pdObjects, SmallArray<int>& missingObjects, bool loadEverything);
+    void sortObjects(HeapArray<pd::WeakReference>& pdObjects, bool updateStackingOrder);
+    void synchroniseConnections();
+
     GlobalMouseListener globalMouseListener;
 
     bool dimensionsAreBeingEdited = false;
@@ -14,12 +14,14 @@ String MainToolbarButton::getTooltip()
         if (auto* cnv = editor->getCurrentCanvas()) {
             if (isUndo) {
                 setTooltip = "Undo";
-                if (cnv->patch.canUndo() && cnv->patch.lastUndoSequence != "")
-                    setTooltip += ": " /* + cnv->patch.getTitle() + ": " */ + cnv->patch.lastUndoSequence;
+                auto undoState = cnv->patch.getUndoRedoState();
+                if (undoState.canUndo && undoState.undoName != "")
+                    setTooltip += ": " /* + cnv->patch.getTitle() + ": " */ + undoState.undoName;
             } else if (isRedo) {
                 setTooltip = "Redo";
-                if (cnv->patch.canRedo() && cnv->patch.lastRedoSequence != "")
-                    setTooltip += ": " /* + cnv->patch.getTitle() + ": " */ + cnv->patch.lastRedoSequence;
+                auto redoState = cnv->patch.getUndoRedoState();
+                if (redoState.canRedo && redoState.redoName != "")
+                    setTooltip += ": " /* + cnv->patch.getTitle() + ": " */ + redoState.redoName;
             }
         }
     }
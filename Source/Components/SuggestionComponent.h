@@ -650,7 +650,7 @@ public:
             }
 
             // When hvcc mode is enabled, show only hvcc compatible objects
-            if (_this->currentObject->hvccMode.get()) {
+            if (_this->currentObject->cnv->hvccMode) {
 
                 StringArray hvccObjectsFound;
                 for (auto& object : toFilter) {
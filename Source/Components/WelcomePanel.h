@@ -8,10 +8,12 @@
 #include "Utility/Autosave.h"
 #include "Utility/CachedTextRender.h"
 #include "Utility/NanoVGGraphicsContext.h"
+#include "Utility/PatchThumbnailCache.h"
 #include "Components/BouncingViewport.h"
 
 class WelcomePanel : public Component
     , public NVGComponent
+    , public ChangeListener
     , public AsyncUpdater {
 
     class TopFillAllRect : public Component {
@@ -251,9 +253,15 @@ public:
         topFillAllRect.setBGColour(findColour(PlugDataColour::panelBackgroundColourId));
 
         setCachedComponentImage(new NVGSurface::InvalidationListener(editor->nvgSurface, this));
+        PatchThumbnailCache::getInstance()->addChangeListener(this);
         triggerAsyncUpdate();
     }
 
+    ~WelcomePanel() override
+    {
+        PatchThumbnailCache::getInstance()->removeChangeListener(this);
+    }
+
     void drawShadow(NVGcontext* nvg, int width, int height)
     {
         // We only need one shadow image, because all tiles have the same size
@@ -347,12 +355,14 @@ public:
         auto recentlyOpenedTree = settingsTree.getChildWithName("RecentlyOpened");
 
         if (recentlyOpenedTree.isValid()) {
+            StringArray recentlyOpenedPaths;
+
             // Place favourited patches at the top
             for (int i = 0; i < recentlyOpenedTree.getNumChildren(); i++) {
 
                 auto subTree = recentlyOpenedTree.getChild(i);
                 auto patchFile = File(subTree.getProperty("Path").toString());
-                auto patchThumbnailBase = File(patchFile.getParentDirectory().getFullPathName() + "\\" + patchFile.getFileNameWithoutExtension() + "_thumb");
+                recentlyOpenedPaths.add(patchFile.getFullPathName());
 
                 auto favourited = subTree.hasProperty("Pinned") && static_cast<bool>(subTree.getProperty("Pinned"));
                 auto snapshotColour = LookAndFeel::getDefaultLookAndFeel().findColour(PlugDataColour::objectSelectedOutlineColourId).withAlpha(0.3f);
@@ -360,22 +370,10 @@ public:
                 String silhoutteSvg;
                 Image thumbImage;
 
-                StringArray possibleExtensions { ".png", ".jpg", ".jpeg", ".gif" };
-
-                for (auto& ext : possibleExtensions) {
-                    auto patchThumbnail = patchThumbnailBase.withFileExtension(ext);
-                    if (patchThumbnail.existsAsFile()) {
-                        FileInputStream fileStream(patchThumbnail);
-                        if (fileStream.openedOk()) {
-                            thumbImage = ImageFileFormat::loadFrom(fileStream).convertedToFormat(Image::ARGB);
-                            break;
-                        }
-                    }
-                }
-                if (thumbImage.isNull()) {
-                    if (patchFile.existsAsFile()) {
-                        silhoutteSvg = OfflineObjectRenderer::patchToSVG(patchFile.loadFileAsString());
-                    }
+                // Don't read or parse the patch here, the thumbnail cache will notify us when its data is ready
+                if (auto cachedEntry = PatchThumbnailCache::getInstance()->getEntry(patchFile)) {
+                    silhoutteSvg = cachedEntry->silhouetteSvg;
+                    thumbImage = cachedEntry->thumbnailImage;
                 }
 
                 auto openTime = Time(static_cast<int64>(subTree.getProperty("Time")));
@@ -413,11 +411,18 @@ public:
                 };
                 recentlyOpenedComponent.addAndMakeVisible(tile);
             }
+
+            PatchThumbnailCache::getInstance()->requestEntries(recentlyOpenedPaths);
         }
 
         resized();
     }
 
+    void changeListenerCallback(ChangeBroadcaster* source) override
+    {
+        triggerAsyncUpdate();
+    }
+
     void show()
     {
         triggerAsyncUpdate();
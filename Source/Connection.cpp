@@ -1315,56 +1315,55 @@ void ConnectionPathUpdater::timerCallback()
 {
     stopTimer();
 
-    std::pair<Component::SafePointer<Connection>, t_symbol*> currentConnection;
-
-    canvas->patch.startUndoSequence("SetConnectionPaths");
+    // Connections can push their path state many times before the timer fires, only the last state has to be sent to pd
+    SmallArray<Component::SafePointer<Connection>> connectionsToUpdate;
+    UnorderedMap<Connection*, t_symbol*> newPathStates;
 
+    std::pair<Component::SafePointer<Connection>, t_symbol*> currentConnection;
     while (connectionUpdateQueue.try_dequeue(currentConnection)) {
-
         auto& [connection, newPathState] = currentConnection;
-
         if (!connection)
             continue;
 
-        bool found = false;
-        t_linetraverser t;
-
-        t_object* outObj;
-        int outIdx;
-        t_object* inObj;
-        int inIdx;
+        if (!newPathStates.contains(connection.getComponent()))
+            connectionsToUpdate.add(connection);
 
-        if (auto patch = connection->cnv->patch.getPointer()) {
+        newPathStates[connection.getComponent()] = newPathState;
+    }
 
-            // Get connections from pd
-            linetraverser_start(&t, patch.get());
+    if (connectionsToUpdate.empty())
+        return;
 
-            while (auto* oc = linetraverser_next_nosize(&t)) {
+    canvas->pd->lockAudioThread();
+    canvas->patch.startUndoSequence("SetConnectionPaths");
 
-                if (oc == connection->ptr.getRaw<t_outconnect>()) {
+    for (auto& connection : connectionsToUpdate) {
+        if (!connection || !connection->outobj || !connection->inobj)
+            continue;
 
-                    outObj = t.tr_ob;
-                    outIdx = t.tr_outno;
-                    inObj = t.tr_ob2;
-                    inIdx = t.tr_inno;
+        // The connection already knows its endpoints, so there's no need to search for it in pd's connection list
+        // Its iolet indices can change when objects are renumbered, so those are looked up in pd
+        auto* outObj = pd::Interface::checkObject(connection->outobj->getPointer());
+        auto* inObj = pd::Interface::checkObject(connection->inobj->getPointer());
+        if (!outObj || !inObj)
+            continue;
 
-                    found = true;
-                    break;
-                }
-            }
+        if (auto oc = connection->ptr.get<t_outconnect>()) {
+            t_symbol* oldPathState = outconnect_get_path_data(oc.get());
+            auto* newPathState = newPathStates[connection.getComponent()];
+            if (oldPathState == newPathState)
+                continue;
 
-            if (!found)
+            if (!pd::Interface::getConnectionIndices(outObj, oc.get(), &connection->outIdx, &connection->inIdx))
                 continue;
 
-            if (auto oc = connection->ptr.get<t_outconnect>()) {
-                t_symbol* oldPathState = outconnect_get_path_data(oc.get());
-                auto* newConnection = connection->cnv->patch.setConnctionPath(outObj, outIdx, inObj, inIdx, oldPathState, newPathState);
-                connection->setPointer(newConnection);
-            }
+            auto* newConnection = canvas->patch.setConnctionPath(outObj, connection->outIdx, inObj, connection->inIdx, oldPathState, newPathState);
+            connection->setPointer(newConnection);
         }
     }
 
     canvas->patch.endUndoSequence("SetConnectionPaths");
+    canvas->pd->unlockAudioThread();
 }
 
 void Connection::receiveMessage(t_symbol* symbol, SmallArray<pd::Atom> const& atoms)
@@ -72,34 +72,163 @@ struct PackageSorter {
     }
 };
 
+// Search index over the deken catalog, built on the package manager thread whenever the package list is parsed
+// Trigrams of the case-folded fields point to the packages that contain them, so a query only looks at packages that contain all of its trigrams
+class PackageIndex {
+public:
+    static constexpr int maxResults = 250;
+
+    PackageIndex() = default;
+
+    explicit PackageIndex(PackageList const& packages)
+    {
+        entries.reserve(packages.size());
+        for (int i = 0; i < static_cast<int>(packages.size()); i++) {
+            auto const& package = packages[i];
+
+            Entry entry;
+            entry.name = package.name.toLowerCase();
+            entry.description = package.description.toLowerCase();
+            entry.author = package.author.toLowerCase();
+            for (auto const& object : package.objects)
+                entry.objects.add(object.toLowerCase());
+
+            auto addPosting = [this, i](uint64 trigram) {
+                auto& packagesWithTrigram = postings[trigram];
+                if (packagesWithTrigram.empty() || packagesWithTrigram.back() != i)
+                    packagesWithTrigram.add(i);
+            };
+
+            forEachTrigram(entry.name, addPosting);
+            forEachTrigram(entry.description, addPosting);
+            forEachTrigram(entry.author, addPosting);
+            for (auto const& object : entry.objects)
+                forEachTrigram(object, addPosting);
+
+            entries.add(std::move(entry));
+        }
+    }
+
+    // Returns indices into the package list, ordered by how well they match the query
+    HeapArray<int> search(String const& query) const
+    {
+        auto const needle = query.toLowerCase();
+
+        HeapArray<int> candidates;
+        if (needle.length() >= 3) {
+            SmallArray<HeapArray<int> const*> trigramPostings;
+            bool missingTrigram = false;
+            forEachTrigram(needle, [this, &trigramPostings, &missingTrigram](uint64 trigram) {
+                auto it = postings.find(trigram);
+                if (it == postings.end())
+                    missingTrigram = true;
+                else
+                    trigramPostings.add(&it->second);
+            });
+
+            if (missingTrigram)
+                return {};
+
+            // Start with the rarest trigram, and drop packages that don't contain the others
+            std::sort(trigramPostings.begin(), trigramPostings.end(), [](auto const* a, auto const* b) {
+                return a->size() < b->size();
+            });
+
+            candidates = *trigramPostings[0];
+            for (int i = 1; i < trigramPostings.size() && candidates.not_empty(); i++) {
+                auto const& packagesWithTrigram = *trigramPostings[i];
+                candidates.remove_if([&packagesWithTrigram](int index) {
+                    return !std::binary_search(packagesWithTrigram.begin(), packagesWithTrigram.end(), index);
+                });
+            }
+        } else {
+            candidates.resize(entries.size());
+            std::iota(candidates.begin(), candidates.end(), 0);
+        }
+
+        // Trigrams can match across words, so the candidates still need to be checked
+        HeapArray<std::pair<int, int>> ranked;
+        for (auto index : candidates) {
+            if (auto score = getScore(entries[index], needle))
+                ranked.add({ score, index });
+        }
+
+        auto numResults = std::min<int>(ranked.size(), maxResults);
+        std::partial_sort(ranked.begin(), ranked.begin() + numResults, ranked.end(), [](auto const& a, auto const& b) {
+            return a.first != b.first ? a.first > b.first : a.second < b.second;
+        });
+
+        HeapArray<int> result;
+        result.reserve(numResults);
+        for (int i = 0; i < numResults; i++)
+            result.add(ranked[i].second);
+
+        return result;
+    }
+
+private:
+    struct Entry {
+        String name, description, author;
+        StringArray objects;
+    };
+
+    // Name matches rank highest, then description, exact object name, author and partial object name
+    static int getScore(Entry const& entry, String const& needle)
+    {
+        if (entry.name.contains(needle))
+            return 5;
+        if (entry.description.contains(needle))
+            return 4;
+        if (entry.objects.contains(needle))
+            return 3;
+        if (entry.author.contains(needle))
+            return 2;
+
+        for (auto const& object : entry.objects) {
+            if (object.contains(needle))
+                return 1;
+        }
+
+        return 0;
+    }
+
+    template<typename Callback>
+    static void forEachTrigram(String const& text, Callback&& callback)
+    {
+        uint64 first = 0, second = 0;
+        int count = 0;
+        for (auto ptr = text.getCharPointer(); !ptr.isEmpty(); count++) {
+            auto const third = static_cast<uint64>(ptr.getAndAdvance());
+            if (count >= 2)
+                callback((first << 42) | (second << 21) | third);
+
+            first = second;
+            second = third;
+        }
+    }
+
+    HeapArray<Entry> entries;
+    UnorderedMap<uint64, HeapArray<int>> postings;
+};
+
 class PackageManager : public Thread
     , public ActionBroadcaster
     , public ValueTree::Listener
     , public DeletedAtShutdown {
 
 public:
+    // Downloads a package to a file in the externals folder, so interrupted downloads can be resumed
+    // The package is then extracted by the workers of the extraction pool, and moved into place once everything succeeded
     struct DownloadTask : public Thread {
         PackageManager& manager;
         PackageInfo packageInfo;
 
-        std::unique_ptr<InputStream> instream;
-
         DownloadTask(PackageManager& m, PackageInfo& info)
             : Thread("Download Thread")
             , manager(m)
             , packageInfo(info)
         {
-            int statusCode = 0;
-            instream = URL(info.url).createInputStream(URL::InputStreamOptions(URL::ParameterHandling::inAddress)
-                    .withConnectionTimeoutMs(10000)
-                    .withStatusCode(&statusCode));
-
-            if (instream != nullptr && statusCode == 200) {
-                startThread();
-            } else {
-                finish(Result::fail("Failed to start download"));
-                return;
-            }
+            startThread();
         }
 
         ~DownloadTask() override
@@ -109,75 +238,296 @@ public:
 
         void run() override
         {
-            MemoryBlock dekData;
+            auto const downloadDirectory = manager.filesystem.getChildFile(".downloads");
+            auto const key = String::toHexString(packageInfo.packageId.hashCode64());
+            auto const downloadFile = downloadDirectory.getChildFile(key + ".partial");
+            auto const stagingDirectory = downloadDirectory.getChildFile(key);
+
+            auto result = download(downloadFile);
+            if (result.wasOk())
+                result = extract(downloadFile, stagingDirectory);
+            if (result.wasOk())
+                result = moveIntoPlace(stagingDirectory);
+
+            stagingDirectory.deleteRecursively();
+
+            if (!result.wasOk()) {
+                finish(result);
+                return;
+            }
+
+            downloadFile.deleteFile();
+
+            // Tell deken about the newly installed package
+            manager.addPackageToRegister(packageInfo, manager.filesystem.getChildFile(packageInfo.name).getFullPathName());
+
+            finish(Result::ok());
+        }
+
+        Result download(File const& downloadFile)
+        {
+            downloadFile.getParentDirectory().createDirectory();
+
+            // If a previous download was interrupted, we continue where it left off
+            auto resumeFrom = downloadFile.getSize();
+            auto url = URL(packageInfo.url);
+
+            std::unique_ptr<InputStream> instream;
+            if (url.isLocalFile()) {
+                instream = url.getLocalFile().createInputStream();
+                if (instream && resumeFrom > 0 && (resumeFrom > instream->getTotalLength() || !instream->setPosition(resumeFrom)))
+                    instream.reset();
+            } else {
+                int statusCode = 0;
+                auto options = URL::InputStreamOptions(URL::ParameterHandling::inAddress)
+                                   .withConnectionTimeoutMs(10000)
+                                   .withStatusCode(&statusCode);
+
+                if (resumeFrom > 0)
+                    options = options.withExtraHeaders("Range: bytes=" + String(resumeFrom) + "-");
+
+                instream = url.createInputStream(options);
+
+                // Servers that don't support range requests will send the whole file again
+                if (statusCode == 200)
+                    resumeFrom = 0;
+                else if (statusCode != 206)
+                    instream.reset();
+            }
+
+            if (instream == nullptr) {
+                // Maybe the partial download is outdated, try again from the start
+                if (resumeFrom > 0 && downloadFile.deleteFile())
+                    return download(downloadFile);
+
+                return Result::fail("Failed to start download");
+            }
+
+            FileOutputStream output(downloadFile);
+            if (output.failedToOpen())
+                return output.getStatus();
+
+            if (resumeFrom == 0) {
+                output.setPosition(0);
+                output.truncate();
+            }
 
-            int64 totalBytes = instream->getTotalLength();
-            int64 bytesDownloaded = 0;
+            auto totalBytes = instream->getTotalLength();
+            if (totalBytes >= 0)
+                totalBytes += resumeFrom;
 
-            MemoryOutputStream mo(dekData, true);
+            auto bytesDownloaded = resumeFrom;
 
             while (true) {
-                if (threadShouldExit()) {
-                    finish(Result::fail("Download cancelled"));
-                    return;
-                }
+                if (threadShouldExit())
+                    return Result::fail("Download cancelled");
 
-                auto written = mo.writeFromInputStream(*instream, 8192);
+                auto written = output.writeFromInputStream(*instream, 65536);
 
-                if (written == 0)
+                if (written <= 0)
                     break;
 
                 bytesDownloaded += written;
 
-                float progress = static_cast<long double>(bytesDownloaded) / static_cast<long double>(totalBytes);
+                if (totalBytes > 0)
+                    setProgress(static_cast<float>(static_cast<long double>(bytesDownloaded) / static_cast<long double>(totalBytes)) * 0.8f);
+            }
 
-                MessageManager::callAsync([this, progress]() mutable {
-                    onProgress(progress);
+            output.flush();
+            if (output.getStatus().failed())
+                return output.getStatus();
+
+            // Keep the partial download, so we can resume it next time
+            if (totalBytes > 0 && bytesDownloaded < totalBytes)
+                return Result::fail("Download was interrupted");
+
+            return Result::ok();
+        }
+
+        // Extracts the downloaded package with the extraction pool, while another job verifies the checksum of the package
+        Result extract(File const& downloadFile, File const& stagingDirectory)
+        {
+            stagingDirectory.deleteRecursively();
+            stagingDirectory.createDirectory();
+
+            ZipFile zip(downloadFile);
+            auto const numEntries = zip.getNumEntries();
+
+            // Don't try to resume from a corrupted download
+            if (numEntries == 0) {
+                downloadFile.deleteFile();
+                return Result::fail("The downloaded package is not a valid archive");
+            }
+
+            // Create all directories up front, so the workers don't race to create the same directories
+            for (int i = 0; i < numEntries; i++) {
+                auto target = stagingDirectory.getChildFile(zip.getEntry(i)->filename);
+                if (!target.isAChildOf(stagingDirectory))
+                    continue;
+
+                if (zip.getEntry(i)->filename.endsWithChar('/'))
+                    target.createDirectory();
+                else
+                    target.getParentDirectory().createDirectory();
+            }
+
+            auto const expectedChecksum = getExpectedChecksum();
+            auto const numWorkers = std::clamp(numEntries / 8, 1, manager.extractionPool.getNumThreads());
+
+            std::atomic<int> remainingJobs = numWorkers + expectedChecksum.isNotEmpty();
+            std::atomic<int> numExtracted = 0;
+            std::atomic<bool> cancelled = false;
+            std::atomic<bool> checksumMismatch = false;
+            WaitableEvent jobsFinished;
+
+            CriticalSection resultLock;
+            auto result = Result::ok();
+
+            auto fail = [&](Result const& failure) {
+                ScopedLock lock(resultLock);
+                if (result.wasOk())
+                    result = failure;
+                cancelled = true;
+            };
+
+            auto jobFinished = [&]() {
+                if (--remainingJobs == 0)
+                    jobsFinished.signal();
+            };
+
+            if (expectedChecksum.isNotEmpty()) {
+                manager.extractionPool.addJob([&]() {
+                    if (SHA256(downloadFile).toHexString() != expectedChecksum) {
+                        checksumMismatch = true;
+                        fail(Result::fail("The downloaded package doesn't match its checksum"));
+                    }
+                    jobFinished();
                 });
             }
 
-            MemoryInputStream input(dekData, false);
-            ZipFile zip(input);
+            for (int worker = 0; worker < numWorkers; worker++) {
+                manager.extractionPool.addJob([&, worker]() {
+                    // Every worker reads from its own file handle
+                    ZipFile workerZip(downloadFile);
+                    for (int i = worker; i < numEntries && !cancelled; i += numWorkers) {
+                        auto entryResult = workerZip.uncompressEntry(i, stagingDirectory);
+                        if (entryResult.failed())
+                            fail(entryResult);
 
-            /* This check produces false positives sometimes, so I've disabled it
-             if (zip.getNumEntries() == 0) {
-             finish(Result::fail("The downloaded file was not a valid Deken package"));
-             return;
-             } */
+                        numExtracted++;
+                    }
+                    jobFinished();
+                });
+            }
 
-            auto extractedPath = filesystem.getChildFile(packageInfo.name).getFullPathName();
-            auto result = zip.uncompressTo(filesystem);
+            // The jobs refer to our local variables, so we have to wait for all of them, even when cancelled
+            while (!jobsFinished.wait(50)) {
+                if (threadShouldExit())
+                    cancelled = true;
 
-            if (!result.wasOk()) {
-                finish(result);
-                return;
+                setProgress(0.8f + 0.2f * static_cast<float>(numExtracted) / static_cast<float>(std::max(numEntries, 1)));
             }
 
-            // Tell deken about the newly installed package
-            manager.addPackageToRegister(packageInfo, extractedPath);
+            // Don't try to resume from a corrupted download
+            if (checksumMismatch)
+                downloadFile.deleteFile();
 
-            finish(Result::ok());
+            if (threadShouldExit())
+                return Result::fail("Download cancelled");
+
+            return result;
+        }
+
+        // Deken repositories provide a .sha256 file next to every package, returns an empty string if there is none
+        String getExpectedChecksum() const
+        {
+            auto checksumURL = URL(packageInfo.url + ".sha256");
+
+            String checksumFile;
+            if (checksumURL.isLocalFile()) {
+                checksumFile = checksumURL.getLocalFile().loadFileAsString();
+            } else {
+                int statusCode = 0;
+                auto instream = checksumURL.createInputStream(URL::InputStreamOptions(URL::ParameterHandling::inAddress)
+                        .withConnectionTimeoutMs(5000)
+                        .withStatusCode(&statusCode));
+
+                if (instream && statusCode == 200)
+                    checksumFile = instream->readEntireStreamAsString();
+            }
+
+            auto checksum = checksumFile.trim().upToFirstOccurrenceOf(" ", false, false).toLowerCase();
+            return checksum.length() == 64 && checksum.containsOnly("0123456789abcdef") ? checksum : String();
+        }
+
+        // Moves the extracted files into the externals folder with a rename, an older version of the package is only removed once the new one is in place
+        Result moveIntoPlace(File const& stagingDirectory)
+        {
+            for (auto const& item : stagingDirectory.findChildFiles(File::findFilesAndDirectories, false)) {
+                auto target = manager.filesystem.getChildFile(item.getFileName());
+                auto previous = manager.filesystem.getChildFile("." + item.getFileName() + ".previous");
+
+                previous.deleteRecursively();
+                if (target.exists() && !target.moveFileTo(previous))
+                    return Result::fail("Failed to replace " + target.getFullPathName());
+
+                if (!item.moveFileTo(target)) {
+                    previous.moveFileTo(target);
+                    return Result::fail("Failed to install " + target.getFullPathName());
+                }
+
+                previous.deleteRecursively();
+            }
+
+            return Result::ok();
+        }
+
+        // Progress updates are throttled, and we only post a new one when the last one has been handled
+        void setProgress(float newProgress)
+        {
+            progress = newProgress;
+
+            auto now = Time::getMillisecondCounter();
+            if (now - lastProgressUpdate < 50 || progressUpdatePending.exchange(true))
+                return;
+
+            lastProgressUpdate = now;
+            MessageManager::callAsync([this]() {
+                progressUpdatePending = false;
+                if (onProgress)
+                    onProgress(progress);
+            });
         }
 
         void finish(Result result)
         {
             MessageManager::callAsync(
-                [this, result, finishCopy = onFinish]() mutable {
+                [this, result]() mutable {
                     waitForThreadToExit(-1);
 
+                    auto finishCopy = onFinish;
+
                     // Self-destruct
                     manager.downloads.removeObject(this);
 
-                    finishCopy(result);
+                    if (finishCopy)
+                        finishCopy(result);
                 });
         }
 
+        std::atomic<float> progress = 0.0f;
+        std::atomic<bool> progressUpdatePending = false;
+        uint32 lastProgressUpdate = 0;
+
         std::function<void(float)> onProgress;
         std::function<void(Result)> onFinish;
     };
 
-    PackageManager()
+    // Packages are installed into the externals folder, unless another directory is given
+    explicit PackageManager(File installDirectory = ProjectInfo::appDataDir.getChildFile("Externals"))
         : Thread("Deken thread")
+        , filesystem(std::move(installDirectory))
+        , extractionPool(std::max(SystemStats::getNumCpus() - 1, 2), Thread::osDefaultStackSize, Thread::Priority::background)
     {
         if (!filesystem.exists()) {
             filesystem.createDirectory();
@@ -214,8 +564,19 @@ public:
 #ifndef _MSC_VER
         signal(SIGPIPE, SIG_IGN);
 #endif
-        allPackages = getAvailablePackages();
-        sendActionMessage("");
+        auto packages = getAvailablePackages();
+        auto index = PackageIndex(packages);
+
+        // The list and its index are read on the message thread, so publish them there together
+        MessageManager::callAsync([packages = std::move(packages), index = std::move(index)]() mutable {
+            if (auto* manager = PackageManager::getInstanceWithoutCreating()) {
+                // The thread is about to exit, listeners check if it's still running to see if the update is done
+                manager->waitForThreadToExit(-1);
+                manager->allPackages = std::move(packages);
+                manager->packageIndex = std::move(index);
+                manager->sendActionMessage("");
+            }
+        });
     }
 
     PackageList getAvailablePackages()
@@ -225,24 +586,67 @@ public:
         // This will pre-parse the deken repo information to a faster and smaller format
         // This saves a lot of work that plugdata would have to do on startup!
 
+        // The repository can be set to a local mirror or a file:// URL, for offline use
+        auto repository = SettingsFile::getInstance()->getProperty<String>("deken_repository");
+        if (repository.isEmpty())
+            repository = "https://raw.githubusercontent.com/plugdata-team/plugdata-deken/main/bin";
+
         auto triplet = os + "-" + machine + "-" + floatsize;
-        auto repoForArchitecture = "https://raw.githubusercontent.com/plugdata-team/plugdata-deken/main/bin/" + triplet + ".bin";
+        auto repoForArchitecture = URL(repository.trimCharactersAtEnd("/") + "/" + triplet + ".bin");
+
+        // The catalog is cached, so we don't need to download it every time plugdata starts
+        // The cache is keyed on the catalog URL, so switching to another repository doesn't show the old one's packages
+        auto cacheFile = filesystem.getChildFile(".catalog_" + String::toHexString(repoForArchitecture.toString(false).hashCode64()) + ".bin");
+        auto cacheIsRecent = cacheFile.existsAsFile() && Time::getCurrentTime() - cacheFile.getLastModificationTime() < RelativeTime::hours(1);
+        auto shouldRefresh = forceRefresh.exchange(false);
+
+        MemoryBlock block;
+        PackageList packages;
+
+        // If the cache can't be parsed, download the catalog again instead of using a broken cache until it expires
+        if (cacheIsRecent && !shouldRefresh && cacheFile.loadFileAsData(block) && parsePackageList(block, packages))
+            return packages;
 
-        webstream = std::make_unique<WebInputStream>(URL(repoForArchitecture), false);
+        block.reset();
+        if (repoForArchitecture.isLocalFile()) {
+            if (!repoForArchitecture.getLocalFile().loadFileAsData(block) || !parsePackageList(block, packages)) {
+                sendActionMessage("Failed to read repository");
+                return {};
+            }
+            return packages;
+        }
+
+        webstream = std::make_unique<WebInputStream>(repoForArchitecture, false);
         webstream->connect(nullptr);
 
         if (webstream->isError()) {
-            sendActionMessage("Failed to connect to server");
-            return {};
+            // Fall back to an older catalog when we're offline
+            if (!cacheFile.loadFileAsData(block) || !parsePackageList(block, packages)) {
+                sendActionMessage("Failed to connect to server");
+                return {};
+            }
+            return packages;
         }
 
-        MemoryBlock block;
         webstream->readIntoMemoryBlock(block);
+        if (!parsePackageList(block, packages)) {
+            sendActionMessage("Failed to read repository");
+            return {};
+        }
 
-        // Parse tree that was downloaded
-        auto tree = ValueTree::readFromData(block.getData(), block.getSize());
+        // Only cache catalogs that we could parse
+        cacheFile.replaceWithData(block.getData(), block.getSize());
+        return packages;
+    }
 
-        PackageList packages;
+    // Parses a catalog in plugdata's pre-parsed deken format, returns false if the data isn't a valid catalog
+    static bool parsePackageList(MemoryBlock const& block, PackageList& packages)
+    {
+        packages.clear();
+
+        auto tree = ValueTree::readFromData(block.getData(), block.getSize());
+        if (!tree.isValid())
+            return false;
 
         for (auto package : tree) {
             auto name = package.getProperty("Name").toString();
@@ -264,7 +668,7 @@ public:
             }
         }
 
-        return packages;
+        return true;
     }
 
     // When a property in our pkginfo changes, save it immediately
@@ -336,8 +740,12 @@ public:
     }
 
     PackageList allPackages;
+    PackageIndex packageIndex;
+
+    // Skip the catalog cache on the next update
+    std::atomic<bool> forceRefresh = false;
 
-    static inline File const filesystem = ProjectInfo::appDataDir.getChildFile("Externals");
+    File const filesystem;
 
     // Package info file
     File pkgInfo = filesystem.getChildFile(".pkg_info");
@@ -345,6 +753,9 @@ public:
     // Package state tree, keeps track of which packages are installed and saves it to pkgInfo
     ValueTree packageState = ValueTree("pkg_info");
 
+    // Workers for extracting packages and verifying their checksums
+    ThreadPool extractionPool;
+
     // Thread for unzipping and installing packages
     OwnedArray<DownloadTask> downloads;
 
@@ -401,8 +812,6 @@ public:
     JUCE_DECLARE_SINGLETON(PackageManager, false)
 };
 
-JUCE_IMPLEMENT_SINGLETON(PackageManager)
-
 class Deken : public Component
     , public ListBoxModel
     , public ActionListener {
@@ -434,6 +843,7 @@ public:
         refreshButton.setTooltip("Refresh packages");
         addAndMakeVisible(refreshButton);
         refreshButton.onClick = [this]() {
+            packageManager->forceRefresh = true;
             packageManager->startThread();
             packageManager->sendActionMessage("");
         };
@@ -444,7 +854,8 @@ public:
         input.setText("Updating Packages...");
         updateSpinner.startSpinning();
 
-        if (!packageManager->isThreadRunning()) {
+        // The package manager outlives the dialog, so the catalog only needs to be loaded once
+        if (!packageManager->isThreadRunning() && packageManager->allPackages.empty()) {
             packageManager->startThread();
         }
 
@@ -477,6 +888,10 @@ public:
         };
 
         filterResults();
+
+        if (!packageManager->isThreadRunning()) {
+            actionListenerCallback("");
+        }
     }
 
     ~Deken()
@@ -605,44 +1020,11 @@ public:
             return;
         }
 
-        PackageList allPackages = packageManager->allPackages;
+        auto const& allPackages = packageManager->allPackages;
 
         if (isSearching && !query.isEmpty()) {
-            // First check for name match
-            for (auto const& result : allPackages) {
-                if (result.name.contains(query)) {
-                    newResult.add_unique(result);
-                }
-            }
-
-            // Then check for description match
-            for (auto const& result : allPackages) {
-                if (result.description.contains(query)) {
-                    newResult.add_unique(result);
-                }
-            }
-
-            // Then check for object match
-            for (auto const& result : allPackages) {
-                if (result.objects.contains(query)) {
-                    newResult.add_unique(result);
-                }
-            }
-
-            // Then check for author match
-            for (auto const& result : allPackages) {
-                if (result.author.contains(query)) {
-                    newResult.add_unique(result);
-                }
-            }
-
-            // Then check for object close match
-            for (auto const& result : allPackages) {
-                for (auto const& obj : result.objects) {
-                    if (obj.contains(query)) {
-                        newResult.add_unique(result);
-                    }
-                }
+            for (auto index : packageManager->packageIndex.search(query)) {
+                newResult.add(allPackages[index]);
             }
         } else if (!isSearching) {
             newResult = allPackages;
@@ -7,6 +7,7 @@
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_gui_extra/juce_gui_extra.h>
 #include <juce_audio_devices/juce_audio_devices.h>
+#include <juce_cryptography/juce_cryptography.h>
 
 #include <utility>
 #include "Utility/Config.h"
@@ -38,6 +39,8 @@
 #include "Deken.h"
 #include "Standalone/PlugDataWindow.h"
 
+JUCE_IMPLEMENT_SINGLETON(PackageManager)
+
 Dialog::Dialog(std::unique_ptr<Dialog>* ownerPtr, Component* editor, int childWidth, int childHeight, bool showCloseButton, int margin)
     : height(childHeight)
     , width(childWidth)
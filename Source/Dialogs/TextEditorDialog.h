@@ -849,15 +849,20 @@ private:
 
 /**
  This class wraps a StringArray and memoizes the evaluation of glyph
- arrangements derived from the associated strings.
+ arrangements, widths and syntax tokens derived from the associated strings.
+ Everything is evaluated lazily per line, so only the lines that are visible
+ or were edited are ever laid out or tokenised.
  */
 class GlyphArrangementArray {
 public:
+    using TokenRun = std::pair<Range<int>, int>;
+
     int size() const { return lines.size(); }
-    void clear() { lines.clear(); }
-    void add(String const& string) { lines.add(string); }
-    void insert(int index, String const& string) { lines.insert(index, string); }
-    void removeRange(int startIndex, int numberToRemove) { lines.remove_range(startIndex, startIndex + numberToRemove); }
+    void clear();
+    void add(String const& string);
+    void set(int index, String const& string);
+    void insert(int index, StringArray const& strings);
+    void removeRange(int startIndex, int numberToRemove);
     String const& operator[](int index) const;
 
     int getToken(int row, int col, int defaultIfOutOfBounds) const;
@@ -868,6 +873,12 @@ public:
         int token,
         bool withTrailingSpace = false) const;
 
+    /** Return the ranges of columns on a line and their Lua token types. */
+    SmallArray<TokenRun> const& getTokenRuns(int index) const;
+
+    /** Return the width of the widest line. */
+    float getMaximumWidth() const;
+
 private:
     friend class TextDocument;
     friend class PlugDataTextEditor;
@@ -876,6 +887,8 @@ private:
 
     void ensureValid(int index) const;
     void invalidateAll();
+    float getWidth(int index) const;
+    void lineWillBeRemoved(int index);
 
     struct Entry {
         Entry() = default;
@@ -887,10 +900,16 @@ private:
         GlyphArrangement glyphsWithTrailingSpace;
         GlyphArrangement glyphs;
         SmallArray<int> tokens;
+        SmallArray<TokenRun> tokenRuns;
+        float width = -1.f;
         bool glyphsAreDirty = true;
         bool tokensAreDirty = true;
     };
     mutable SmallArray<Entry> lines;
+
+    // Width of the widest line, only recalculated from the cached line widths when the widest line was edited or removed
+    mutable float maximumWidth = 0.f;
+    mutable bool maximumWidthIsValid = false;
 };
 
 class TextDocument {
@@ -989,6 +1008,7 @@ public:
     {
         font = fontToUse;
         lines.font = fontToUse;
+        lines.invalidateAll();
     }
 
     StringArray getText() const;
@@ -1106,6 +1126,9 @@ public:
     /** Return a line in the document. */
     String const& getLine(int lineIndex) const { return lines[lineIndex]; }
 
+    /** Return the Lua tokens on a line, these are only recalculated when the line changes. */
+    SmallArray<GlyphArrangementArray::TokenRun> const& getTokenRuns(int lineIndex) const { return lines.getTokenRuns(lineIndex); }
+
     /** Return one of the current selections. */
     Selection const& getSelection(int index) const;
 
@@ -1142,7 +1165,6 @@ private:
     friend class PlugDataTextEditor;
 
     float lineSpacing = 1.25f;
-    mutable Rectangle<float> cachedBounds;
     GlyphArrangementArray lines;
     Font font;
     SmallArray<Selection> selections;
@@ -1302,1580 +1324,6 @@ private:
     UndoManager undo;
 };
 
-// IMPLEMENTATIONS
-
-Caret::Caret(TextDocument const& document)
-    : document(document)
-{
-    setInterceptsMouseClicks(false, false);
-#if ENABLE_CARET_BLINK
-    startTimerHz(20);
-#endif
-}
-
-void Caret::setViewTransform(AffineTransform const& transformToUse)
-{
-    transform = transformToUse;
-    repaint();
-}
-
-void Caret::updateSelections()
-{
-    phase = 0.f;
-    repaint();
-}
-
-void Caret::paint(Graphics& g)
-{
-    g.setColour(getParentComponent()->findColour(CaretComponent::caretColourId).withAlpha(squareWave(phase)));
-
-    for (auto const& r : getCaretRectangles())
-        g.fillRect(r);
-}
-
-float Caret::squareWave(float wt)
-{
-    float const delta = 0.222f;
-    float const A = 1.0;
-    return 0.5f + A / 3.14159f * std::atan(std::cos(wt) / delta);
-}
-
-void Caret::timerCallback()
-{
-    phase += 3.2e-1;
-
-    for (auto const& r : getCaretRectangles())
-        repaint(r.getSmallestIntegerContainer());
-}
-
-SmallArray<Rectangle<float>> Caret::getCaretRectangles() const
-{
-    SmallArray<Rectangle<float>> rectangles;
-
-    for (auto const& selection : document.getSelections()) {
-        if (selection.head == selection.tail) {
-            rectangles.add(document
-                    .getGlyphBounds(selection.head)
-                    .removeFromLeft(CURSOR_WIDTH)
-                    .translated(selection.head.y == 0 ? 0 : -0.5f * CURSOR_WIDTH, 0.f)
-                    .transformedBy(transform)
-                    .expanded(0.f, 1.f));
-        }
-    }
-    return rectangles;
-}
-
-GutterComponent::GutterComponent(TextDocument const& document)
-    : document(document)
-    , memoizedGlyphArrangements([this](int row) { return getLineNumberGlyphs(row); })
-{
-    setInterceptsMouseClicks(false, false);
-}
-
-void GutterComponent::setViewTransform(AffineTransform const& transformToUse)
-{
-    transform = transformToUse;
-    repaint();
-}
-
-void GutterComponent::updateSelections()
-{
-    repaint();
-}
-
-void GutterComponent::paint(Graphics& g)
-{
-    /*
-     Draw the gutter background, shadow, and outline
-     ------------------------------------------------------------------
-     */
-    auto ln = getParentComponent()->findColour(PlugDataColour::sidebarBackgroundColourId);
-
-    g.setColour(ln);
-    g.fillRect(getLocalBounds().removeFromLeft(GUTTER_WIDTH));
-
-    if (transform.getTranslationX() < GUTTER_WIDTH) {
-        auto shadowRect = getLocalBounds().withLeft(GUTTER_WIDTH).withWidth(12);
-
-        auto gradient = ColourGradient::horizontal(ln.contrasting().withAlpha(0.3f),
-            Colours::transparentBlack, shadowRect);
-        g.setFillType(gradient);
-        g.fillRect(shadowRect);
-    } else {
-        g.setColour(findColour(PlugDataColour::toolbarOutlineColourId));
-        g.drawVerticalLine(GUTTER_WIDTH - 1.f, 0.f, getHeight());
-    }
-
-    /*
-     Draw the line numbers and selected rows
-     ------------------------------------------------------------------
-     */
-    auto area = g.getClipBounds().toFloat().transformedBy(transform.inverted());
-    auto rowData = document.findRowsIntersecting(area);
-    auto verticalTransform = transform.withAbsoluteTranslation(0.f, transform.getTranslationY());
-
-    g.setColour(findColour(PlugDataColour::sidebarActiveBackgroundColourId));
-
-    for (auto const& r : rowData) {
-        if (r.isRowSelected) {
-            auto A = r.bounds
-                         .transformedBy(transform)
-                         .withX(0)
-                         .withWidth(GUTTER_WIDTH);
-
-            g.fillRoundedRectangle(A.reduced(4, 1), Corners::defaultCornerRadius);
-        }
-    }
-
-    for (auto const& r : rowData) {
-        g.setColour(getParentComponent()->findColour(PlugDataColour::panelTextColourId));
-        memoizedGlyphArrangements(r.rowNumber).draw(g, verticalTransform);
-    }
-}
-
-GlyphArrangement GutterComponent::getLineNumberGlyphs(int row) const
-{
-    GlyphArrangement glyphs;
-    glyphs.addLineOfText(document.getFont().withHeight(12.f),
-        String(row + 1),
-        8.f, document.getVerticalPosition(row, TextDocument::Metric::baseline));
-    return glyphs;
-}
-
-HighlightComponent::HighlightComponent(TextDocument const& document)
-    : document(document)
-{
-    setInterceptsMouseClicks(false, false);
-}
-
-void HighlightComponent::setViewTransform(AffineTransform const& transformToUse, SmallArray<Selection> const& selections)
-{
-    transform = transformToUse;
-
-    outlinePath.clear();
-    auto clip = getLocalBounds().toFloat().transformedBy(transform.inverted());
-
-    for (auto const& s : selections) {
-        outlinePath.addPath(getOutlinePath(document.getSelectionRegion(s, clip)));
-    }
-    repaint(outlinePath.getBounds().getSmallestIntegerContainer());
-}
-
-void HighlightComponent::updateSelections(SmallArray<Selection> const& selections)
-{
-    outlinePath.clear();
-    auto clip = getLocalBounds().toFloat().transformedBy(transform.inverted());
-
-    for (auto const& s : selections) {
-        outlinePath.addPath(getOutlinePath(document.getSelectionRegion(s, clip)));
-    }
-
-    repaint(outlinePath.getBounds().getSmallestIntegerContainer());
-}
-
-void HighlightComponent::paint(Graphics& g)
-{
-    g.addTransform(transform);
-
-    g.setColour(highlightColour);
-    g.fillPath(outlinePath);
-
-    g.setColour(highlightColour.darker());
-    g.strokePath(outlinePath, PathStrokeType(1.f));
-}
-
-Path HighlightComponent::getOutlinePath(SmallArray<Rectangle<float>> const& rectangles)
-{
-    auto p = Path();
-    auto rect = rectangles.begin();
-
-    if (rect == rectangles.end())
-        return p;
-
-    p.startNewSubPath(rect->getTopLeft());
-    p.lineTo(rect->getBottomLeft());
-
-    while (++rect != rectangles.end()) {
-        p.lineTo(rect->getTopLeft());
-        p.lineTo(rect->getBottomLeft());
-    }
-
-    while (rect-- != rectangles.begin()) {
-        p.lineTo(rect->getBottomRight());
-        p.lineTo(rect->getTopRight());
-    }
-
-    p.closeSubPath();
-    return p.createPathWithRoundedCorners(4.f);
-}
-
-Selection::Selection(String const& content)
-{
-    int rowSpan = 0;
-    int n = 0, lastLineStart = 0;
-    auto c = content.getCharPointer();
-
-    while (*c != '\0') {
-        if (*c == '\n') {
-            ++rowSpan;
-            lastLineStart = n + 1;
-        }
-        ++c;
-        ++n;
-    }
-
-    head = { 0, 0 };
-    tail = { rowSpan, content.length() - lastLineStart };
-}
-
-bool Selection::isOriented() const
-{
-    return !(head.x > tail.x || (head.x == tail.x && head.y > tail.y));
-}
-
-Selection Selection::oriented() const
-{
-    if (!isOriented())
-        return swapped();
-
-    return *this;
-}
-
-Selection Selection::swapped() const
-{
-    Selection s = *this;
-    std::swap(s.head, s.tail);
-    return s;
-}
-
-Selection Selection::horizontallyMaximized(TextDocument const& document) const
-{
-    Selection s = *this;
-
-    if (isOriented()) {
-        s.head.y = 0;
-        s.tail.y = document.getNumColumns(s.tail.x);
-    } else {
-        s.head.y = document.getNumColumns(s.head.x);
-        s.tail.y = 0;
-    }
-    return s;
-}
-
-Selection Selection::measuring(String const& content) const
-{
-    Selection s(content);
-
-    if (isOriented()) {
-        return Selection(content).startingFrom(head);
-    } else {
-        return Selection(content).startingFrom(tail).swapped();
-    }
-}
-
-Selection Selection::startingFrom(Point<int> index) const
-{
-    Selection s = *this;
-
-    /*
-     Pull the whole selection back to the origin.
-     */
-    s.pullBy(Selection({}, isOriented() ? head : tail));
-
-    /*
-     Then push it forward to the given index.
-     */
-    s.pushBy(Selection({}, index));
-
-    return s;
-}
-
-void Selection::pullBy(Selection disappearingSelection)
-{
-    disappearingSelection.pull(head);
-    disappearingSelection.pull(tail);
-}
-
-void Selection::pushBy(Selection appearingSelection)
-{
-    appearingSelection.push(head);
-    appearingSelection.push(tail);
-}
-
-void Selection::pull(Point<int>& index) const
-{
-    auto const S = oriented();
-
-    /*
-     If the selection tail is on index's row, then shift its column back,
-     either by the difference between our head and tail column indexes if
-     our head and tail are on the same row, or otherwise by our tail's
-     column index.
-     */
-    if (S.tail.x == index.x && S.head.y <= index.y) {
-        if (S.head.x == S.tail.x) {
-            index.y -= S.tail.y - S.head.y;
-        } else {
-            index.y -= S.tail.y;
-        }
-    }
-
-    /*
-     If this selection starts on the same row or an earlier one,
-     then shift the row index back by our row span.
-     */
-    if (S.head.x <= index.x) {
-        index.x -= S.tail.x - S.head.x;
-    }
-}
-
-void Selection::push(Point<int>& index) const
-{
-    auto const S = oriented();
-
-    /*
-     If our head is on index's row, then shift its column forward, either
-     by our head to tail distance if our head and tail are on the
-     same row, or otherwise by our tail's column index.
-     */
-    if (S.head.x == index.x && S.head.y <= index.y) {
-        if (S.head.x == S.tail.x) {
-            index.y += S.tail.y - S.head.y;
-        } else {
-            index.y += S.tail.y;
-        }
-    }
-
-    /*
-     If this selection starts on the same row or an earlier one,
-     then shift the row index forward by our row span.
-     */
-    if (S.head.x <= index.x) {
-        index.x += S.tail.x - S.head.x;
-    }
-}
-
-String const& GlyphArrangementArray::operator[](int index) const
-{
-    if (isPositiveAndBelow(index, lines.size())) {
-        return lines[index].string;
-    }
-
-    static String empty;
-    return empty;
-}
-
-int GlyphArrangementArray::getToken(int row, int col, int defaultIfOutOfBounds) const
-{
-    if (!isPositiveAndBelow(row, lines.size())) {
-        return defaultIfOutOfBounds;
-    }
-    return lines[row].tokens[col];
-}
-
-void GlyphArrangementArray::clearTokens(int index)
-{
-    if (!isPositiveAndBelow(index, lines.size()))
-        return;
-
-    auto& entry = lines[index];
-
-    ensureValid(index);
-
-    for (int col = 0; col < entry.tokens.size(); ++col) {
-        entry.tokens[col] = 0;
-    }
-}
-
-void GlyphArrangementArray::applyTokens(int index, Selection zone)
-{
-    if (!isPositiveAndBelow(index, lines.size()))
-        return;
-
-    auto& entry = lines[index];
-    auto range = zone.getColumnRangeOnRow(index, entry.tokens.size());
-
-    ensureValid(index);
-
-    for (int col = range.getStart(); col < range.getEnd(); ++col) {
-        entry.tokens[col] = zone.token;
-    }
-}
-
-GlyphArrangement GlyphArrangementArray::getGlyphs(int index,
-    float baseline,
-    int token,
-    bool withTrailingSpace) const
-{
-    if (!isPositiveAndBelow(index, lines.size())) {
-        GlyphArrangement glyphs;
-
-        if (withTrailingSpace) {
-            glyphs.addLineOfText(font, " ", TEXT_INDENT, baseline);
-        }
-        return glyphs;
-    }
-    ensureValid(index);
-
-    auto& entry = lines[index];
-    auto glyphSource = withTrailingSpace ? entry.glyphsWithTrailingSpace : entry.glyphs;
-    auto glyphs = GlyphArrangement();
-
-    for (int n = 0; n < glyphSource.getNumGlyphs(); ++n) {
-        if (token == -1 || entry.tokens[n] == token) {
-            auto glyph = glyphSource.getGlyph(n);
-            glyph.moveBy(TEXT_INDENT, baseline);
-            glyphs.addGlyph(glyph);
-        }
-    }
-    return glyphs;
-}
-
-void GlyphArrangementArray::ensureValid(int index) const
-{
-    if (!isPositiveAndBelow(index, lines.size()))
-        return;
-
-    auto& entry = lines[index];
-
-    if (entry.glyphsAreDirty) {
-        entry.tokens.resize(entry.string.length());
-        entry.glyphs.addLineOfText(font, entry.string, 0.f, 0.f);
-        entry.glyphsWithTrailingSpace.addLineOfText(font, entry.string + " ", 0.f, 0.f);
-        entry.glyphsAreDirty = !cacheGlyphArrangement;
-    }
-}
-
-void GlyphArrangementArray::invalidateAll()
-{
-    for (auto& entry : lines) {
-        entry.glyphsAreDirty = true;
-        entry.tokensAreDirty = true;
-    }
-}
-
-void TextDocument::replaceAll(String const& content)
-{
-    lines.clear();
-
-    for (auto const& line : StringArray::fromLines(content)) {
-        lines.add(line);
-    }
-}
-
-StringArray TextDocument::getText() const
-{
-    StringArray text;
-    for (int i = 0; i < lines.size(); i++) {
-        text.add(lines[i]);
-    }
-
-    return text;
-}
-
-int TextDocument::getNumRows() const
-{
-    return lines.size();
-}
-
-int TextDocument::getNumColumns(int row) const
-{
-    return lines[row].length();
-}
-
-float TextDocument::getVerticalPosition(int row, Metric metric) const
-{
-    float lineHeight = font.getHeight() * lineSpacing;
-    float gap = font.getHeight() * (lineSpacing - 1.f) * 0.5f;
-
-    switch (metric) {
-    case Metric::top:
-        return lineHeight * row;
-    case Metric::ascent:
-        return lineHeight * row + gap;
-    case Metric::baseline:
-        return lineHeight * row + gap + font.getAscent();
-    case Metric::descent:
-        return lineHeight * row + gap + font.getAscent() + font.getDescent();
-    case Metric::bottom:
-        return lineHeight * row + lineHeight;
-    default:
-        return lineHeight * row;
-    }
-}
-
-Point<float> TextDocument::getPosition(Point<int> index, Metric metric) const
-{
-    return { getGlyphBounds(index).getX(), getVerticalPosition(index.x, metric) };
-}
-
-SmallArray<Rectangle<float>> TextDocument::getSelectionRegion(Selection selection, Rectangle<float> clip) const
-{
-    SmallArray<Rectangle<float>> patches;
-    Selection s = selection.oriented();
-
-    if (s.head.x == s.tail.x) {
-        int c0 = s.head.y;
-        int c1 = s.tail.y;
-        patches.add(getBoundsOnRow(s.head.x, Range<int>(c0, c1)));
-    } else {
-        int r0 = s.head.x;
-        int c0 = s.head.y;
-        int r1 = s.tail.x;
-        int c1 = s.tail.y;
-
-        for (int n = r0; n <= r1; ++n) {
-            if (!clip.isEmpty() && !clip.getVerticalRange().intersects({ getVerticalPosition(n, Metric::top), getVerticalPosition(n, Metric::bottom) }))
-                continue;
-
-            if (n == r1 && c1 == 0)
-                continue;
-            else if (n == r0)
-                patches.add(getBoundsOnRow(r0, Range<int>(c0, getNumColumns(r0) + 1)));
-            else if (n == r1)
-                patches.add(getBoundsOnRow(r1, Range<int>(0, c1)));
-            else
-                patches.add(getBoundsOnRow(n, Range<int>(0, getNumColumns(n) + 1)));
-        }
-    }
-    return patches;
-}
-
-Rectangle<float> TextDocument::getBounds() const
-{
-    if (cachedBounds.isEmpty()) {
-        auto bounds = Rectangle<float>();
-
-        for (int n = 0; n < getNumRows(); ++n) {
-            bounds = bounds.getUnion(getBoundsOnRow(n, Range<int>(0, std::max(1, getNumColumns(n)))));
-        }
-        return cachedBounds = bounds;
-    }
-    return cachedBounds;
-}
-
-Rectangle<float> TextDocument::getBoundsOnRow(int row, Range<int> columns) const
-{
-    return getGlyphsForRow(row, -1, true)
-        .getBoundingBox(columns.getStart(), columns.getLength(), true)
-        .withTop(getVerticalPosition(row, Metric::top))
-        .withBottom(getVerticalPosition(row, Metric::bottom));
-}
-
-Rectangle<float> TextDocument::getGlyphBounds(Point<int> index) const
-{
-    index.y = jlimit(0, getNumColumns(index.x), index.y);
-    return getBoundsOnRow(index.x, Range<int>(index.y, index.y + 1));
-}
-
-GlyphArrangement TextDocument::getGlyphsForRow(int row, int token, bool withTrailingSpace) const
-{
-    return lines.getGlyphs(row,
-        getVerticalPosition(row, Metric::baseline),
-        token,
-        withTrailingSpace);
-}
-
-GlyphArrangement TextDocument::findGlyphsIntersecting(Rectangle<float> area, int token) const
-{
-    auto range = getRangeOfRowsIntersecting(area);
-    auto rows = SmallArray<RowData>();
-    auto glyphs = GlyphArrangement();
-
-    for (int n = range.getStart(); n < range.getEnd(); ++n) {
-        glyphs.addGlyphArrangement(getGlyphsForRow(n, token));
-    }
-    return glyphs;
-}
-
-Range<int> TextDocument::getRangeOfRowsIntersecting(Rectangle<float> area) const
-{
-    auto lineHeight = font.getHeight() * lineSpacing;
-    auto row0 = jlimit(0, jmax(getNumRows() - 1, 0), int(area.getY() / lineHeight));
-    auto row1 = jlimit(0, jmax(getNumRows() - 1, 0), int(area.getBottom() / lineHeight));
-    return { row0, row1 + 1 };
-}
-
-SmallArray<TextDocument::RowData> TextDocument::findRowsIntersecting(Rectangle<float> area,
-    bool computeHorizontalExtent) const
-{
-    auto range = getRangeOfRowsIntersecting(area);
-    auto rows = SmallArray<RowData>();
-
-    for (int n = range.getStart(); n < range.getEnd(); ++n) {
-        RowData data;
-        data.rowNumber = n;
-
-        if (computeHorizontalExtent) // slower
-        {
-            data.bounds = getBoundsOnRow(n, Range<int>(0, getNumColumns(n)));
-        } else // faster
-        {
-            data.bounds.setY(getVerticalPosition(n, Metric::top));
-            data.bounds.setBottom(getVerticalPosition(n, Metric::bottom));
-        }
-
-        for (auto const& s : selections) {
-            if (s.intersectsRow(n)) {
-                data.isRowSelected = true;
-                break;
-            }
-        }
-        rows.add(data);
-    }
-    return rows;
-}
-
-Point<int> TextDocument::findIndexNearestPosition(Point<float> position) const
-{
-    auto lineHeight = font.getHeight() * lineSpacing;
-    auto row = jlimit(0, jmax(getNumRows() - 1, 0), int(position.y / lineHeight));
-    auto col = 0;
-    auto glyphs = getGlyphsForRow(row);
-
-    if (position.x > 0.f) {
-        col = glyphs.getNumGlyphs();
-
-        for (int n = 0; n < glyphs.getNumGlyphs(); ++n) {
-            if (glyphs.getBoundingBox(n, 1, true).getHorizontalRange().contains(position.x)) {
-                col = n;
-                break;
-            }
-        }
-    }
-    return { row, col };
-}
-
-Point<int> TextDocument::getEnd() const
-{
-    return { getNumRows(), 0 };
-}
-
-bool TextDocument::next(Point<int>& index) const
-{
-    if (index.y < getNumColumns(index.x)) {
-        index.y += 1;
-        return true;
-    } else if (index.x < getNumRows()) {
-        index.x += 1;
-        index.y = 0;
-        return true;
-    }
-    return false;
-}
-
-bool TextDocument::prev(Point<int>& index) const
-{
-    if (index.y > 0) {
-        index.y -= 1;
-        return true;
-    } else if (index.x > 0) {
-        index.x -= 1;
-        index.y = getNumColumns(index.x);
-        return true;
-    }
-    return false;
-}
-
-bool TextDocument::nextRow(Point<int>& index) const
-{
-    if (index.x < getNumRows()) {
-        index.x += 1;
-        index.y = jmin(index.y, getNumColumns(index.x));
-        return true;
-    }
-    return false;
-}
-
-bool TextDocument::prevRow(Point<int>& index) const
-{
-    if (index.x > 0) {
-        index.x -= 1;
-        index.y = jmin(index.y, getNumColumns(index.x));
-        return true;
-    }
-    return false;
-}
-
-void TextDocument::navigate(Point<int>& i, Target target, Direction direction) const
-{
-    std::function<bool(Point<int>&)> advance;
-    std::function<juce_wchar(Point<int>&)> get;
-
-    using CF = CharacterFunctions;
-    static String punctuation = "{}<>()[],.;:";
-
-    switch (direction) {
-    case Direction::forwardRow:
-        advance = [this](Point<int>& i) { return nextRow(i); };
-        get = [this](Point<int> i) { return getCharacter(i); };
-        break;
-    case Direction::backwardRow:
-        advance = [this](Point<int>& i) { return prevRow(i); };
-        get = [this](Point<int> i) { prev (i); return getCharacter (i); };
-        break;
-    case Direction::forwardCol:
-        advance = [this](Point<int>& i) { return next(i); };
-        get = [this](Point<int> i) { return getCharacter(i); };
-        break;
-    case Direction::backwardCol:
-        advance = [this](Point<int>& i) { return prev(i); };
-        get = [this](Point<int> i) { prev (i); return getCharacter (i); };
-        break;
-    }
-
-    switch (target) {
-    case Target::whitespace:
-        while (!CF::isWhitespace(get(i)) && advance(i)) { }
-        break;
-    case Target::punctuation:
-        while (!punctuation.containsChar(get(i)) && advance(i)) { }
-        break;
-    case Target::character:
-        advance(i);
-        break;
-    case Target::subword:
-        jassertfalse;
-        break; // IMPLEMENT ME
-    case Target::word:
-        while (CF::isWhitespace(get(i)) && advance(i)) { }
-        break;
-    case Target::token: {
-        int s = lines.getToken(i.x, i.y, -1);
-        int t = s;
-
-        while (s == t && advance(i)) {
-            if (getNumColumns(i.x) > 0) {
-                s = t;
-                t = lines.getToken(i.x, i.y, s);
-            }
-        }
-        break;
-    }
-    case Target::line:
-        while (get(i) != '\n' && advance(i)) { }
-        break;
-    case Target::paragraph:
-        while (getNumColumns(i.x) > 0 && advance(i)) { }
-        break;
-    case Target::scope:
-        jassertfalse;
-        break; // IMPLEMENT ME
-    case Target::document:
-        while (advance(i)) { }
-        break;
-    }
-}
-
-void TextDocument::navigateSelections(Target target, Direction direction, Selection::Part part)
-{
-    auto isHeadBeforeTail = [](Point<int> head, Point<int> tail) -> int {
-        if (head.x == tail.x)
-            return head.y == tail.y ? -1 : head.y < tail.y;
-        return head.x < tail.x;
-    };
-
-    for (auto& selection : selections) {
-        if (target == Target::character && ((isHeadBeforeTail(selection.head, selection.tail) == 1 && direction == Direction::forwardCol) || (isHeadBeforeTail(selection.head, selection.tail) == 0 && direction == Direction::backwardCol))) {
-            selection.head = selection.tail;
-            continue;
-        } else if (target == Target::character && ((isHeadBeforeTail(selection.head, selection.tail) == 0 && direction == Direction::forwardCol) || (isHeadBeforeTail(selection.head, selection.tail) == 1 && direction == Direction::backwardCol))) {
-            selection.tail = selection.head;
-            continue;
-        }
-        switch (part) {
-        case Selection::Part::head:
-            navigate(selection.head, target, direction);
-            break;
-        case Selection::Part::tail:
-            navigate(selection.tail, target, direction);
-            break;
-        case Selection::Part::both:
-            navigate(selection.head, target, direction);
-            selection.tail = selection.head;
-            break;
-        }
-    }
-}
-
-void TextDocument::search(String const& text)
-{
-    selections.clear();
-    searchSelections.clear();
-
-    for (int i = 0; i < lines.size(); i++) {
-        auto idx = lines[i].indexOf(text);
-        if (idx >= 0) {
-            searchSelections.add(Selection(Point<int>(i, idx), Point<int>(i, idx + text.length())));
-        }
-    }
-}
-
-juce_wchar TextDocument::getCharacter(Point<int> index) const
-{
-    jassert(0 <= index.x && index.x <= lines.size());
-    jassert(0 <= index.y && index.y <= lines[index.x].length());
-
-    if (index == getEnd() || index.y == lines[index.x].length()) {
-        return '\n';
-    }
-    return lines[index.x].getCharPointer()[index.y];
-}
-
-Selection const& TextDocument::getSelection(int index) const
-{
-    return selections[index];
-}
-
-SmallArray<Selection> const& TextDocument::getSelections() const
-{
-    return selections;
-}
-
-SmallArray<Selection> const& TextDocument::getSearchSelections() const
-{
-    return searchSelections;
-}
-
-String TextDocument::getSelectionContent(Selection s) const
-{
-    s = s.oriented();
-
-    if (s.isSingleLine()) {
-        return lines[s.head.x].substring(s.head.y, s.tail.y);
-    } else {
-        String content = lines[s.head.x].substring(s.head.y) + "\n";
-
-        for (int row = s.head.x + 1; row < s.tail.x; ++row) {
-            content += lines[row] + "\n";
-        }
-        content += lines[s.tail.x].substring(0, s.tail.y);
-        return content;
-    }
-}
-
-Transaction TextDocument::fulfill(Transaction const& transaction)
-{
-    cachedBounds = {}; // invalidate the bounds
-
-    auto const t = transaction.accountingForSpecialCharacters(*this);
-    auto const s = t.selection.oriented();
-    auto const L = getSelectionContent(s.horizontallyMaximized(*this));
-    auto const i = s.head.y;
-    auto const j = L.lastIndexOf("\n") + s.tail.y + 1;
-    auto const M = L.substring(0, i) + t.content + L.substring(j);
-
-    for (auto& existingSelection : selections) {
-        existingSelection.pullBy(s);
-        existingSelection.pushBy(Selection(t.content).startingFrom(s.head));
-    }
-
-    lines.removeRange(s.head.x, s.tail.x - s.head.x + 1);
-    int row = s.head.x;
-
-    if (M.isEmpty()) {
-        lines.insert(row++, String());
-    }
-    for (auto const& line : StringArray::fromLines(M)) {
-        lines.insert(row++, line);
-    }
-
-    using D = Transaction::Direction;
-    auto inf = std::numeric_limits<float>::max();
-
-    Transaction r;
-    r.selection = Selection(t.content).startingFrom(s.head);
-    r.content = L.substring(i, j);
-    r.affectedArea = Rectangle<float>(0, 0, inf, inf);
-    r.direction = t.direction == D::forward ? D::reverse : D::forward;
-
-    return r;
-}
-
-void TextDocument::clearTokens(Range<int> rows)
-{
-    for (int n = rows.getStart(); n < rows.getEnd(); ++n) {
-        lines.clearTokens(n);
-    }
-}
-
-void TextDocument::applyTokens(Range<int> rows, SmallArray<Selection> const& zones)
-{
-    for (int n = rows.getStart(); n < rows.getEnd(); ++n) {
-        for (auto const& zone : zones) {
-            if (zone.intersectsRow(n)) {
-                lines.applyTokens(n, zone);
-            }
-        }
-    }
-}
-
-class Transaction::Undoable : public UndoableAction {
-public:
-    Undoable(TextDocument& document, Callback callback, Transaction forward)
-        : document(document)
-        , callback(std::move(callback))
-        , forward(std::move(forward))
-    {
-    }
-
-    bool perform() override
-    {
-        callback(reverse = document.fulfill(forward));
-        return true;
-    }
-
-    bool undo() override
-    {
-        callback(forward = document.fulfill(reverse));
-        return true;
-    }
-
-    TextDocument& document;
-    Callback callback;
-    Transaction forward;
-    Transaction reverse;
-};
-
-Transaction Transaction::accountingForSpecialCharacters(TextDocument const& document) const
-{
-    Transaction t = *this;
-    auto& s = t.selection;
-
-    if (content.getLastCharacter() == KeyPress::tabKey) {
-        t.content = "    ";
-    }
-    if (content.getLastCharacter() == KeyPress::backspaceKey) {
-        if (s.head.y == s.tail.y) {
-            document.prev(s.head);
-        }
-        t.content.clear();
-    } else if (content.getLastCharacter() == KeyPress::deleteKey) {
-        if (s.head.y == s.tail.y) {
-            document.next(s.head);
-        }
-        t.content.clear();
-    }
-    return t;
-}
-
-UndoableAction* Transaction::on(TextDocument& document, Callback callback)
-{
-    return new Undoable(document, std::move(callback), *this);
-}
-
-PlugDataTextEditor::PlugDataTextEditor()
-    : caret(document)
-    , gutter(document)
-    , highlight(document)
-    , searchHighlight(document)
-{
-    lastTransactionTime = Time::getApproximateMillisecondCounter();
-    document.setSelections({ Selection() });
-
-    setFont(Font(Fonts::getMonospaceFont().withHeight(15.5f)));
-
-    translateView(GUTTER_WIDTH, 0);
-    setWantsKeyboardFocus(true);
-
-    addAndMakeVisible(highlight);
-    addAndMakeVisible(searchHighlight);
-    addAndMakeVisible(caret);
-    addAndMakeVisible(gutter);
-
-    lookAndFeelChanged();
-}
-
-void PlugDataTextEditor::lookAndFeelChanged()
-{
-    highlight.setHighlightColour(findColour(CodeEditorComponent::highlightColourId));
-    searchHighlight.setHighlightColour(Colours::yellow.withAlpha(0.5f));
-}
-
-void PlugDataTextEditor::paintOverChildren(Graphics& g)
-{
-    g.setColour(findColour(PlugDataColour::toolbarOutlineColourId));
-    g.drawHorizontalLine(0, 0, getWidth());
-    g.drawHorizontalLine(getHeight() - 1, 0, getWidth());
-}
-
-void PlugDataTextEditor::setFont(Font const& font)
-{
-    document.setFont(font);
-    repaint();
-}
-
-void PlugDataTextEditor::setText(String const& text)
-{
-    document.replaceAll(text);
-    repaint();
-}
-
-String PlugDataTextEditor::getText() const
-{
-    return document.getText().joinIntoString("\r");
-}
-
-void PlugDataTextEditor::translateView(float dx, float dy)
-{
-    auto W = viewScaleFactor * document.getBounds().getWidth();
-    auto H = viewScaleFactor * document.getBounds().getHeight();
-
-    translation.x = jlimit(jmin(GUTTER_WIDTH, -W + getWidth()), GUTTER_WIDTH, translation.x + dx);
-    translation.y = jlimit(jmin(-0.f, -H + (getHeight() - 10)), 0.0f, translation.y + dy);
-
-    updateViewTransform();
-}
-
-void PlugDataTextEditor::scaleView(float scaleFactorMultiplier, float verticalCenter)
-{
-    auto newS = viewScaleFactor * scaleFactorMultiplier;
-    auto fixedy = Point<float>(0, verticalCenter).transformedBy(transform.inverted()).y;
-
-    translation.y = -newS * fixedy + verticalCenter;
-    viewScaleFactor = newS;
-    updateViewTransform();
-}
-
-void PlugDataTextEditor::updateViewTransform()
-{
-    transform = AffineTransform::scale(viewScaleFactor).translated(translation.x, translation.y);
-    highlight.setViewTransform(transform, document.getSelections());
-    searchHighlight.setViewTransform(transform, document.getSearchSelections());
-    caret.setViewTransform(transform);
-    gutter.setViewTransform(transform);
-    repaint();
-}
-
-void PlugDataTextEditor::updateSelections()
-{
-    highlight.updateSelections(document.getSelections());
-    searchHighlight.updateSelections(document.getSearchSelections());
-    caret.updateSelections();
-    gutter.updateSelections();
-}
-
-void PlugDataTextEditor::translateToEnsureCaretIsVisible()
-{
-    auto i = document.getSelections().back().head;
-    auto t = Point<float>(0.f, document.getVerticalPosition(i.x, TextDocument::Metric::top)).transformedBy(transform);
-    auto b = Point<float>(0.f, document.getVerticalPosition(i.x, TextDocument::Metric::bottom)).transformedBy(transform);
-
-    if (t.y < 0.f) {
-        translateView(0.f, -t.y);
-    } else if (b.y > getHeight()) {
-        translateView(0.f, -b.y + getHeight());
-    }
-}
-
-void PlugDataTextEditor::translateToEnsureSearchIsVisible(int index)
-{
-    auto selections = document.getSearchSelections();
-    if (index >= selections.size())
-        return;
-
-    auto i = selections[index].head;
-    auto t = Point<float>(0.f, document.getVerticalPosition(i.x, TextDocument::Metric::top)).transformedBy(transform);
-    auto b = Point<float>(0.f, document.getVerticalPosition(i.x, TextDocument::Metric::bottom)).transformedBy(transform);
-
-    if (t.y < 0.f) {
-        translateView(0.f, -t.y);
-    } else if (b.y > getHeight()) {
-        translateView(0.f, -b.y + getHeight());
-    }
-}
-
-void PlugDataTextEditor::resized()
-{
-    highlight.setBounds(getLocalBounds());
-    searchHighlight.setBounds(getLocalBounds());
-    caret.setBounds(getLocalBounds());
-    gutter.setBounds(getLocalBounds());
-}
-
-void PlugDataTextEditor::paint(Graphics& g)
-{
-    g.fillAll(findColour(PlugDataColour::canvasBackgroundColourId));
-
-    String renderSchemeString;
-
-    switch (renderScheme) {
-    case RenderScheme::usingAttributedString:
-        renderTextUsingAttributedString(g);
-        renderSchemeString = "attr. str";
-        break;
-    case RenderScheme::usingGlyphArrangement:
-        renderTextUsingGlyphArrangement(g);
-        renderSchemeString = "glyph arr.";
-        break;
-    }
-
-    auto scrollBarBounds = getScrollBarBounds();
-    auto fadeWidth = jmap<float>(scrollbarFadePosition, 0.0f, 1.0f, 4.0f, 8.0f);
-
-    // Draw a scrollbar if content height exceeds visible height
-    if (!scrollBarBounds.isEmpty()) {
-        auto scrollbarColour = findColour(PlugDataColour::scrollbarThumbColourId);
-        auto canvasBgColour = findColour(PlugDataColour::canvasBackgroundColourId);
-        g.setColour(scrollbarColour.interpolatedWith(canvasBgColour, 0.7f + jmap(scrollbarFadePosition, 0.0f, 1.0f, 0.1f, 0.0f))); // Scrollbar background
-        g.fillRoundedRectangle(getWidth() - (fadeWidth + 2.0f), 2, fadeWidth, getHeight() - 4, fadeWidth / 2.0f);
-
-        auto scrollBarThumbCol = scrollBarClicked ? scrollbarColour : scrollbarColour.interpolatedWith(canvasBgColour.contrasting(0.6f), 0.7f);
-        g.setColour(scrollBarThumbCol); // Scrollbar thumb
-        g.fillRoundedRectangle(scrollBarBounds.withTrimmedLeft(8.0f - fadeWidth), fadeWidth / 2.0f);
-    }
-}
-
-Rectangle<float> PlugDataTextEditor::getScrollBarBounds() const
-{
-    auto contentHeight = document.getHeight();
-    auto visibleHeight = getHeight();
-    if (contentHeight <= visibleHeight)
-        return {};
-
-    auto scrollPosition = -translation.y;
-    float scrollbarHeight = (float)visibleHeight / contentHeight * visibleHeight;    // Height of the scrollbar
-    float scrollbarPosition = (float)scrollPosition / contentHeight * visibleHeight; // Y position of the scrollbar
-
-    return { getWidth() - 10.f, scrollbarPosition + 2, 8.0f, scrollbarHeight - 4 };
-}
-
-void PlugDataTextEditor::mouseDown(MouseEvent const& e)
-{
-    if (e.getNumberOfClicks() > 1) {
-        return;
-    }
-
-    auto selections = document.getSelections();
-    auto index = document.findIndexNearestPosition(e.position.transformedBy(transform.inverted()));
-
-    if (selections.contains(index)) {
-        return;
-    }
-
-    if (e.x > getWidth() - 10 && document.getHeight() > getHeight()) {
-        mouseDownViewPosition = translation.y + (e.y * (document.getHeight() / getHeight()));
-        scrollBarClicked = true;
-        repaint();
-        return;
-    }
-
-    if (e.mods.isShiftDown() && selections.size()) {
-        auto& selection = selections[selections.size() - 1];
-        bool wasOriented = selection.isOriented();
-        auto orientedSelection = selection.oriented();
-
-        auto isBeforeSelection = [](Point<int> index, Point<int> selection) -> int {
-            if (index.x == selection.x)
-                return index.y == selection.y ? -1 : index.y < selection.y;
-            return index.x < selection.x;
-        };
-
-        if (isBeforeSelection(index, orientedSelection.head))
-            orientedSelection.head = index;
-        else
-            orientedSelection.tail = index;
-
-        selection = wasOriented ? orientedSelection : orientedSelection.swapped();
-
-        document.setSelections(selections);
-        updateSelections();
-        return;
-    } else if (!e.mods.isCommandDown() || !TEST_MULTI_CARET_EDITING) {
-        selections.clear();
-    }
-
-    selections.add(index);
-    document.setSelections(selections);
-    updateSelections();
-}
-
-void PlugDataTextEditor::mouseDrag(MouseEvent const& e)
-{
-    // Check if the drag is happening within the scrollbar area (right 10px of the editor)
-    if (e.getMouseDownX() > getWidth() - 10 && document.getHeight() > getHeight()) {
-        translation.y = jlimit(jmin(-0.f, -(viewScaleFactor * document.getBounds().getHeight()) + (getHeight() - 10)), 0.0f, (mouseDownViewPosition - (e.y * (document.getHeight() / getHeight()))));
-        updateViewTransform();
-        return;
-    }
-    if (e.mouseWasDraggedSinceMouseDown()) {
-        auto selection = document.getSelections().front();
-        selection.head = document.findIndexNearestPosition(e.position.transformedBy(transform.inverted()));
-        document.setSelections({ selection });
-        translateToEnsureCaretIsVisible();
-        updateSelections();
-    }
-}
-
-void PlugDataTextEditor::mouseUp(MouseEvent const& e)
-{
-    scrollBarClicked = false;
-    repaint();
-}
-
-void PlugDataTextEditor::mouseMove(MouseEvent const& e)
-{
-    if (e.x > getWidth() - 10 && document.getHeight() > getHeight() && !isOverScrollBar) {
-        isOverScrollBar = true;
-        startTimerHz(60);
-    } else if ((e.x <= getWidth() - 10 || document.getHeight() < getHeight()) && isOverScrollBar) {
-        isOverScrollBar = false;
-        startTimerHz(60);
-    }
-}
-
-void PlugDataTextEditor::mouseDoubleClick(MouseEvent const& e)
-{
-    if (e.getNumberOfClicks() == 2) {
-        document.navigateSelections(TextDocument::Target::whitespace, TextDocument::Direction::backwardCol, Selection::Part::head);
-        document.navigateSelections(TextDocument::Target::whitespace, TextDocument::Direction::forwardCol, Selection::Part::tail);
-        updateSelections();
-    } else if (e.getNumberOfClicks() == 3) {
-        document.navigateSelections(TextDocument::Target::line, TextDocument::Direction::backwardCol, Selection::Part::head);
-        document.navigateSelections(TextDocument::Target::line, TextDocument::Direction::forwardCol, Selection::Part::tail);
-        updateSelections();
-    }
-    updateSelections();
-}
-
-void PlugDataTextEditor::mouseWheelMove(MouseEvent const& e, MouseWheelDetails const& d)
-{
-    float dx = d.deltaX;
-    /*
-     make scrolling away from the gutter just a little "sticky"
-     */
-    if (translation.x == GUTTER_WIDTH && -0.01f < dx && dx < 0.f) {
-        dx = 0.f;
-    }
-    translateView(dx * 400, d.deltaY * 800);
-}
-
-void PlugDataTextEditor::timerCallback()
-{
-    if (isOverScrollBar) {
-        scrollbarFadePosition += 0.1f;
-    } else {
-        scrollbarFadePosition -= 0.1f;
-    }
-
-    scrollbarFadePosition = std::clamp(scrollbarFadePosition, 0.0f, 1.0f);
-    if (!isOverScrollBar && scrollbarFadePosition == 0.0f)
-        stopTimer();
-    if (isOverScrollBar && scrollbarFadePosition == 1.0f)
-        stopTimer();
-
-    repaint();
-}
-
-void PlugDataTextEditor::mouseMagnify(MouseEvent const& e, float scaleFactor)
-{
-    scaleView(scaleFactor, e.position.y);
-}
-
-bool PlugDataTextEditor::keyPressed(KeyPress const& key)
-{
-    using Target = TextDocument::Target;
-    using Direction = TextDocument::Direction;
-    auto mods = key.getModifiers();
-    auto isTab = tabKeyUsed && key == KeyPress::tabKey;
-    auto isBackspace = key == KeyPress::backspaceKey;
-
-    auto nav = [this, mods](Target target, Direction direction) {
-        if (mods.isShiftDown())
-            document.navigateSelections(target, direction, Selection::Part::head);
-        else
-            document.navigateSelections(target, direction, Selection::Part::both);
-
-        translateToEnsureCaretIsVisible();
-        updateSelections();
-        return true;
-    };
-    auto expandBack = [this](Target target, Direction direction) {
-        document.navigateSelections(target, direction, Selection::Part::head);
-        translateToEnsureCaretIsVisible();
-        updateSelections();
-        return true;
-    };
-    auto expand = [this](Target target) {
-        document.navigateSelections(target, Direction::backwardCol, Selection::Part::head);
-        document.navigateSelections(target, Direction::forwardCol, Selection::Part::tail);
-        updateSelections();
-        return true;
-    };
-    auto addCaret = [this](Target target, Direction direction) {
-        auto s = document.getSelections().back();
-        document.navigate(s.head, target, direction);
-        document.addSelection(s);
-        translateToEnsureCaretIsVisible();
-        updateSelections();
-        return true;
-    };
-    if (key.isKeyCode(KeyPress::escapeKey)) {
-        document.setSelections({ document.getSelections().back() });
-        updateSelections();
-        return true;
-    }
-    if (mods.isCtrlDown() && mods.isAltDown()) {
-        if (key.isKeyCode(KeyPress::downKey))
-            return addCaret(Target::character, Direction::forwardRow);
-        if (key.isKeyCode(KeyPress::upKey))
-            return addCaret(Target::character, Direction::backwardRow);
-    }
-    if (mods.isCtrlDown()) {
-        if (key.isKeyCode(KeyPress::rightKey))
-            return nav(Target::whitespace, Direction::forwardCol) && nav(Target::word, Direction::forwardCol);
-        if (key.isKeyCode(KeyPress::leftKey))
-            return nav(Target::whitespace, Direction::backwardCol) && nav(Target::word, Direction::backwardCol);
-        if (key.isKeyCode(KeyPress::downKey))
-            return nav(Target::word, Direction::forwardCol) && nav(Target::paragraph, Direction::forwardRow);
-        if (key.isKeyCode(KeyPress::upKey))
-            return nav(Target::word, Direction::backwardCol) && nav(Target::paragraph, Direction::backwardRow);
-
-        if (key.isKeyCode(KeyPress::backspaceKey))
-            return (expandBack(Target::whitespace, Direction::backwardCol)
-                && expandBack(Target::word, Direction::backwardCol)
-                && insert(""));
-
-        if (key == KeyPress('e', ModifierKeys::ctrlModifier, 0) || key == KeyPress('e', ModifierKeys::ctrlModifier | ModifierKeys::shiftModifier, 0))
-            return nav(Target::line, Direction::forwardCol);
-
-        if (key == KeyPress('a', ModifierKeys::ctrlModifier, 0) || key == KeyPress('a', ModifierKeys::ctrlModifier | ModifierKeys::shiftModifier, 0))
-            return nav(Target::line, Direction::backwardCol);
-    }
-    if (mods.isCommandDown()) {
-        if (key.isKeyCode(KeyPress::downKey))
-            return nav(Target::document, Direction::forwardRow);
-        if (key.isKeyCode(KeyPress::upKey))
-            return nav(Target::document, Direction::backwardRow);
-    }
-
-    if (key.isKeyCode(KeyPress::rightKey))
-        return nav(Target::character, Direction::forwardCol);
-    if (key.isKeyCode(KeyPress::leftKey))
-        return nav(Target::character, Direction::backwardCol);
-    if (key.isKeyCode(KeyPress::downKey))
-        return nav(Target::character, Direction::forwardRow);
-    if (key.isKeyCode(KeyPress::upKey))
-        return nav(Target::character, Direction::backwardRow);
-
-    if (key == KeyPress('a', ModifierKeys::commandModifier, 0))
-        return expand(Target::document);
-    if (key == KeyPress('d', ModifierKeys::commandModifier, 0))
-        return expand(Target::whitespace);
-    if (key == KeyPress('e', ModifierKeys::commandModifier, 0))
-        return expand(Target::token);
-    if (key == KeyPress('l', ModifierKeys::commandModifier, 0))
-        return expand(Target::line);
-    if (key == KeyPress('z', ModifierKeys::commandModifier, 0))
-        return undo.undo();
-    if (key == KeyPress('r', ModifierKeys::commandModifier, 0))
-        return undo.redo();
-
-    if (key == KeyPress('x', ModifierKeys::commandModifier, 0)) {
-        SystemClipboard::copyTextToClipboard(document.getSelectionContent(document.getSelections().front()));
-        return insert("");
-    }
-    if (key == KeyPress('c', ModifierKeys::commandModifier, 0)) {
-        SystemClipboard::copyTextToClipboard(document.getSelectionContent(document.getSelections().front()));
-        return true;
-    }
-
-    if (key == KeyPress('v', ModifierKeys::commandModifier, 0))
-        return insert(SystemClipboard::getTextFromClipboard());
-    if (key == KeyPress('d', ModifierKeys::ctrlModifier, 0))
-        return insert(String::charToString(KeyPress::deleteKey));
-    if (key.isKeyCode(KeyPress::returnKey))
-        return insert("\n");
-    if (key.getTextCharacter() >= ' ' || isTab || isBackspace)
-        return insert(String::charToString(key.getTextCharacter()));
-
-    return false;
-}
-
-bool PlugDataTextEditor::insert(String const& content)
-{
-    double now = Time::getApproximateMillisecondCounter();
-
-    if (now > lastTransactionTime + 400) {
-        lastTransactionTime = Time::getApproximateMillisecondCounter();
-        undo.beginNewTransaction();
-    }
-
-    for (int n = 0; n < document.getNumSelections(); ++n) {
-        Transaction t;
-        t.content = content;
-        t.selection = document.getSelection(n);
-
-        auto callback = [this, n](Transaction const& r) {
-            switch (r.direction) // NB: switching on the direction of the reciprocal here
-            {
-            case Transaction::Direction::forward:
-                document.setSelection(n, r.selection);
-                break;
-            case Transaction::Direction::reverse:
-                document.setSelection(n, r.selection.tail);
-                break;
-            }
-
-            if (!r.affectedArea.isEmpty()) {
-                repaint(r.affectedArea.transformedBy(transform).getSmallestIntegerContainer());
-            }
-        };
-        undo.perform(t.on(document, callback));
-    }
-    updateSelections();
-    changed = true;
-
-    return true;
-}
-
-MouseCursor PlugDataTextEditor::getMouseCursor()
-{
-    if (isOverScrollBar)
-        return MouseCursor::NormalCursor;
-
-    return getMouseXYRelative().x < GUTTER_WIDTH && getMouseXYRelative().x > (getWidth() - 10) ? MouseCursor::NormalCursor : MouseCursor::IBeamCursor;
-}
-
-CodeEditorComponent::ColourScheme PlugDataTextEditor::getSyntaxColourScheme()
-{
-    auto textColour = findColour(PlugDataColour::canvasTextColourId);
-    if (findColour(PlugDataColour::canvasBackgroundColourId).getPerceivedBrightness() > 0.5f) {
-        static CodeEditorComponent::ColourScheme::TokenType const types[] = {
-            { "Error", Colour(0xffcc0000) },
-            { "Comment", Colour(0xff3c3c9c) },
-            { "Keyword", Colour(0xff0000cc) },
-            { "Operator", Colour(0xff225500) },
-            { "Identifier", Colour(0xff000000) },
-            { "Integer", Colour(0xff880000) },
-            { "Float", Colour(0xff885500) },
-            { "String", Colour(0xff990099) },
-            { "Bracket", Colour(0xff000055) },
-            { "Punctuation", textColour }
-        };
-
-        CodeEditorComponent::ColourScheme cs;
-
-        for (auto& t : types)
-            cs.set(t.name, Colour(t.colour));
-
-        return cs;
-    } else {
-        static CodeEditorComponent::ColourScheme::TokenType const types[] = {
-            { "Error", Colour(0xffff6666) },
-            { "Comment", Colour(0xff8888ff) },
-            { "Keyword", Colour(0xff66aaff) },
-            { "Operator", Colour(0xff77cc77) },
-            { "Identifier", Colour(0xffffffff) },
-            { "Integer", Colour(0xffffaa66) },
-            { "Float", Colour(0xffffcc88) },
-            { "String", Colour(0xffcc88ff) },
-            { "Bracket", Colour(0xff66aaff) },
-            { "Punctuation", textColour }
-        };
-
-        CodeEditorComponent::ColourScheme cs;
-
-        for (auto& t : types)
-            cs.set(t.name, Colour(t.colour));
-
-        return cs;
-    }
-}
-
-void PlugDataTextEditor::setSearchText(String const& searchText)
-{
-    document.search(searchText);
-    updateSelections();
-    translateToEnsureSearchIsVisible(0);
-}
-
-void PlugDataTextEditor::searchNext()
-{
-    auto next = document.searchNext();
-    updateSelections();
-    translateToEnsureSearchIsVisible(next);
-}
-
-void PlugDataTextEditor::renderTextUsingAttributedString(Graphics& g)
-{
-    /*
-     Credit to chrisboy2000 for this
-     */
-    auto colourScheme = getSyntaxColourScheme();
-    auto originalHeight = document.getFont().getHeight();
-
-    auto scaleFactor = std::sqrt(std::abs(transform.getDeterminant()));
-    auto font = document.getFont().withHeight(originalHeight * scaleFactor);
-    auto rows = document.findRowsIntersecting(g.getClipBounds().toFloat().transformedBy(transform.inverted()));
-
-    for (auto const& r : rows) {
-        auto line = document.getLine(r.rowNumber);
-        auto T = document.getVerticalPosition(r.rowNumber, TextDocument::Metric::ascent);
-        auto B = document.getVerticalPosition(r.rowNumber, TextDocument::Metric::bottom);
-        auto bounds = Rectangle<float>::leftTopRightBottom(0.f, T, 1000.f, B).transformedBy(transform).translated(4, 0);
-
-        AttributedString s;
-
-        if (!enableSyntaxHighlighting) {
-            s.append(line, font);
-        } else {
-            LuaTokeniserFunctions::StringIterator si(line);
-            auto previous = si.t;
-
-            while (!si.isEOF()) {
-                auto tokenType = LuaTokeniserFunctions::readNextToken(si);
-                auto colour = enableSyntaxHighlighting ? colourScheme.types[tokenType].colour : findColour(PlugDataColour::panelTextColourId);
-                auto token = String(previous, si.t);
-
-                previous = si.t;
-                s.append(token, font, colour);
-            }
-        }
-        if (allowCoreGraphics) {
-            s.draw(g, bounds);
-        } else {
-            TextLayout layout;
-            layout.createLayout(s, bounds.getWidth());
-            layout.draw(g, bounds);
-        }
-    }
-}
-
-void PlugDataTextEditor::renderTextUsingGlyphArrangement(Graphics& g)
-{
-    g.saveState();
-    g.addTransform(transform);
-
-    if (enableSyntaxHighlighting) {
-        auto colourScheme = getSyntaxColourScheme();
-        auto rows = document.getRangeOfRowsIntersecting(g.getClipBounds().toFloat());
-        auto index = Point<int>(rows.getStart(), 0);
-        document.navigate(index, TextDocument::Target::token, TextDocument::Direction::backwardRow);
-
-        auto it = TextDocument::Iterator(document, { 0, 0 });
-        auto previous = it.getIndex();
-        auto zones = SmallArray<Selection>();
-
-        while (it.getIndex().x < rows.getEnd() && !it.isEOF()) {
-            auto tokenType = LuaTokeniserFunctions::readNextToken(it);
-            zones.add(Selection(previous, it.getIndex()).withStyle(tokenType));
-            previous = it.getIndex();
-        }
-        document.clearTokens(rows);
-        document.applyTokens(rows, zones);
-
-        for (int n = 0; n < colourScheme.types.size(); ++n) {
-            g.setColour(colourScheme.types[n].colour);
-            document.findGlyphsIntersecting(g.getClipBounds().toFloat(), n).draw(g);
-        }
-    } else {
-        g.setColour(findColour(PlugDataColour::panelTextColourId));
-        document.findGlyphsIntersecting(g.getClipBounds().toFloat()).draw(g);
-    }
-    g.restoreState();
-}
-
 struct TextEditorDialog : public Component
     , public ChangeListener {
     ResizableBorderComponent resizer;
@@ -34,33 +34,14 @@ Iolet::Iolet(Object* parent, bool inlet)
     setAlwaysOnTop(true);
 
     parent->addAndMakeVisible(this);
-    cnv->locked.addListener(this);
-    cnv->commandLocked.addListener(this);
-    cnv->presentationMode.addListener(this);
 
     locked = getValue<bool>(cnv->locked);
     commandLocked = getValue<bool>(cnv->commandLocked);
     presentationMode = getValue<bool>(cnv->presentationMode);
 
-    patchDownwardsOnly = SettingsFile::getInstance()->getProperty<bool>("patch_downwards_only");
-
     setVisible(!presentationMode && !insideGraph);
 }
 
-Iolet::~Iolet()
-{
-    cnv->locked.removeListener(this);
-    cnv->commandLocked.removeListener(this);
-    cnv->presentationMode.removeListener(this);
-}
-
-void Iolet::settingsChanged(String const& name, var const& value)
-{
-    if (name == "patch_downwards_only") {
-        patchDownwardsOnly = static_cast<bool>(value);
-    }
-}
-
 Rectangle<int> Iolet::getCanvasBounds()
 {
     // Get bounds relative to canvas, used for positioning connections
@@ -98,7 +79,7 @@ bool Iolet::hitTest(int x, int y)
     if (locked || commandLocked)
         return false;
 
-    if (patchDownwardsOnly && isInlet && !cnv->connectingWithDrag)
+    if (cnv->patchDownwardsOnly && isInlet && !cnv->connectingWithDrag)
         return false;
 
     Path smallBounds;
@@ -122,7 +103,7 @@ bool Iolet::hitTest(int x, int y)
 void Iolet::mouseDrag(MouseEvent const& e)
 {
     // Ignore when locked or if middlemouseclick?
-    if (locked || e.mods.isMiddleButtonDown() || (patchDownwardsOnly && isInlet))
+    if (locked || e.mods.isMiddleButtonDown() || (cnv->patchDownwardsOnly && isInlet))
         return;
 
     if (!cnv->connectionCancelled && cnv->connectionsBeingCreated.empty() && e.getLengthOfMousePress() > 100) {
@@ -221,8 +202,8 @@ void Iolet::mouseEnter(MouseEvent const& e)
         cnv->editor->tooltipWindow.displayTip(getScreenPosition(), tooltip);
     }
 
-    for (auto& iolet : object->iolets)
-        iolet->repaint();
+    // The object draws all of its iolets, so one repaint is enough to update them
+    object->repaint();
 }
 
 void Iolet::mouseExit(MouseEvent const& e)
@@ -234,8 +215,7 @@ void Iolet::mouseExit(MouseEvent const& e)
         cnv->editor->tooltipWindow.hideTip();
     }
 
-    for (auto& iolet : object->iolets)
-        iolet->repaint();
+    object->repaint();
 }
 
 Iolet* Iolet::getNextIolet()
@@ -337,47 +317,42 @@ SmallArray<Connection*> Iolet::getConnections()
 
 Iolet* Iolet::findNearestIolet(Canvas* cnv, Point<int> position, bool inlet, Object* objectToExclude)
 {
-    // Find all potential iolets
-    SmallArray<Iolet*> allIolets;
+    Iolet* nearestIolet = nullptr;
+    float nearestDistance = std::numeric_limits<float>::max();
+
     for (auto* object : cnv->objects) {
-        for (auto& iolet : object->iolets) {
-            if (iolet->isInlet == inlet && iolet->object != objectToExclude) {
-                allIolets.add(iolet);
-            }
-        }
-    }
+        if (object == objectToExclude)
+            continue;
 
-    Iolet* nearestIolet = nullptr;
-    for (auto& iolet : allIolets) {
-        auto bounds = iolet->getCanvasBounds().expanded(20);
-        if (bounds.contains(position)) {
-            if (!nearestIolet)
-                nearestIolet = iolet;
+        // Iolets are always inside the bounds of their object, so we can skip objects that are too far away
+        if (!object->getBounds().expanded(20).contains(position))
+            continue;
+
+        for (auto* iolet : object->iolets) {
+            if (iolet->isInlet != inlet)
+                continue;
 
-            auto oldPos = nearestIolet->getCanvasBounds().getCentre();
-            auto newPos = bounds.getCentre();
-            nearestIolet = newPos.getDistanceFrom(position) < oldPos.getDistanceFrom(position) ? iolet : nearestIolet;
+            auto bounds = iolet->getCanvasBounds().expanded(20);
+            if (!bounds.contains(position))
+                continue;
+
+            auto distance = bounds.getCentre().getDistanceFrom(position);
+            if (distance < nearestDistance) {
+                nearestIolet = iolet;
+                nearestDistance = distance;
+            }
         }
     }
 
     return nearestIolet;
 }
 
-void Iolet::valueChanged(Value& v)
+void Iolet::updateCanvasState()
 {
-    if (v.refersToSameSourceAs(cnv->locked)) {
-        locked = getValue<bool>(v);
-        repaint();
-    } else if (v.refersToSameSourceAs(cnv->commandLocked)) {
-        commandLocked = getValue<bool>(v);
-        repaint();
-    } else if (v.refersToSameSourceAs(cnv->presentationMode)) {
-        presentationMode = getValue<bool>(v);
-        setVisible(!presentationMode && !insideGraph);
-        repaint();
-    } else { // patch_downards_only changed
-        patchDownwardsOnly = getValue<bool>(v);
-    }
+    locked = getValue<bool>(cnv->locked);
+    commandLocked = getValue<bool>(cnv->commandLocked);
+    presentationMode = getValue<bool>(cnv->presentationMode);
+    setVisible(!presentationMode && !insideGraph);
 }
 
 void Iolet::setHidden(bool hidden)
@@ -9,17 +9,16 @@ class Object;
 class Canvas;
 struct NVGcontext;
 
+// Iolets don't listen to the canvas themselves, their Object passes on lock and presentation changes
+// That keeps creating and deleting them cheap, which matters for patches with many thousands of iolets
 class Iolet : public Component
     , public SettableTooltipClient
-    , public Value::Listener
-    , public SettingsFileListener
     , public NVGComponent {
 public:
     Object* object;
     Canvas* cnv;
 
     Iolet(Object* parent, bool isInlet);
-    ~Iolet();
 
     void mouseDrag(MouseEvent const& e) override;
     void mouseUp(MouseEvent const& e) override;
@@ -33,8 +32,8 @@ public:
 
     void render(NVGcontext* nvg) override;
 
-    void valueChanged(Value& v) override;
-    void settingsChanged(String const& name, var const& value) override;
+    // Called by the object when the canvas is locked, unlocked or switched to presentation mode
+    void updateCanvasState();
 
     static Iolet* findNearestIolet(Canvas* cnv, Point<int> position, bool inlet, Object* boxToExclude = nullptr);
 
@@ -58,7 +57,6 @@ private:
     bool locked : 1 = false;
     bool commandLocked : 1 = false;
     bool presentationMode : 1 = false;
-    bool patchDownwardsOnly : 1 = false;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Iolet)
     JUCE_DECLARE_WEAK_REFERENCEABLE(Iolet)
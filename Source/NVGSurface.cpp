@@ -18,6 +18,7 @@ using namespace juce::gl;
 
 #include "PluginEditor.h"
 #include "PluginProcessor.h"
+#include "Utility/CachedTextRender.h"
 
 #define ENABLE_FPS_COUNT 0
 
@@ -172,6 +173,7 @@ void NVGSurface::detachContext()
         NVGFramebuffer::clearAll(nvg);
         NVGImage::clearAll(nvg);
         NVGCachedPath::clearAll(nvg);
+        TextAtlas::releaseContext(nvg);
 
         if (invalidFBO) {
             nvgDeleteFramebuffer(invalidFBO);
@@ -354,6 +356,7 @@ void NVGSurface::render()
 #endif
 
     updateBufferSize();
+    TextAtlas::beginFrame();
 
     invalidArea = invalidArea.getIntersection(getLocalBounds());
 
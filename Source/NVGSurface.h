@@ -195,6 +195,12 @@ public:
 
     virtual void render(NVGcontext*) { };
 
+    // Consecutive components that return the same non-zero style can share a single fill and stroke call
+    // addToBatch should only add sub-paths, finishBatch is called on the first component of the batch
+    virtual hash32 getBatchStyle() { return 0; }
+    virtual void addToBatch(NVGcontext*) { }
+    virtual void finishBatch(NVGcontext*) { }
+
 private:
     Component& component;
 
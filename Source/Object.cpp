@@ -101,9 +101,6 @@ void Object::initialise()
     commandLocked.referTo(cnv->pd->commandLocked);
     presentationMode.referTo(cnv->presentationMode);
 
-    hvccMode.referTo(SettingsFile::getInstance()->getValueTree(), Identifier("hvcc_mode"), nullptr, false);
-    patchDownwardsOnly.referTo(SettingsFile::getInstance()->getValueTree(), Identifier("patch_downwards_only"), nullptr);
-
     presentationMode.addListener(this);
     locked.addListener(this);
     commandLocked.addListener(this);
@@ -142,15 +139,13 @@ bool Object::isSelected() const
     return selectedFlag;
 }
 
-void Object::settingsChanged(String const& name, var const& value)
+void Object::updateHvccCompatibility()
 {
-    if (name == "hvcc_mode") {
-        isHvccCompatible = checkIfHvccCompatible();
-        if (gui && !isHvccCompatible) {
-            cnv->pd->logWarning(String("Warning: object \"" + gui->getType() + "\" is not supported in Compiled Mode").toRawUTF8());
-        }
-        repaint();
+    isHvccCompatible = checkIfHvccCompatible();
+    if (gui && !isHvccCompatible) {
+        cnv->pd->logWarning(String("Warning: object \"" + gui->getType() + "\" is not supported in Compiled Mode").toRawUTF8());
     }
+    repaint();
 }
 
 void Object::valueChanged(Value& v)
@@ -164,6 +159,11 @@ void Object::valueChanged(Value& v)
             gui->lock(cnv->isGraph || locked == var(true) || commandLocked == var(true));
         }
     }
+
+    for (auto* iolet : iolets) {
+        iolet->updateCanvasState();
+    }
+    repaint();
 }
 
 bool Object::checkIfHvccCompatible() const
@@ -173,7 +173,7 @@ bool Object::checkIfHvccCompatible() const
         // Check hvcc compatibility
         bool isSubpatch = gui->getPatch() != nullptr;
 
-        return !hvccMode.get() || isSubpatch || HeavyCompatibleObjects::getAllCompatibleObjects().contains(typeName);
+        return !cnv->hvccMode || isSubpatch || HeavyCompatibleObjects::getAllCompatibleObjects().contains(typeName);
     }
 
     return true;
@@ -1289,7 +1289,7 @@ void Object::renderIolets(NVGcontext* nvg)
     if (getValue<bool>(locked) || !drawIoletExpanded) {
         auto clipBounds = getLocalBounds().reduced(Object::margin);
         nvgIntersectScissor(nvg, clipBounds.getX(), clipBounds.getY(), clipBounds.getWidth(), clipBounds.getHeight());
-    } else if (patchDownwardsOnly) {
+    } else if (cnv->patchDownwardsOnly) {
         auto clipBounds = getLocalBounds().reduced(Object::margin);
         nvgIntersectScissor(nvg, clipBounds.getX(), clipBounds.getY(), clipBounds.getWidth(), clipBounds.getHeight() + Object::doubleMargin);
     }
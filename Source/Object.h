@@ -37,7 +37,6 @@ class Object : public Component
     , public Timer
     , public KeyListener
     , public NVGComponent
-    , public SettingsFileListener
     , private TextEditor::Listener {
 public:
     explicit Object(Canvas* parent, String const& name = "", Point<int> position = { 100, 100 });
@@ -46,9 +45,11 @@ public:
 
     ~Object() override;
 
-    void settingsChanged(String const& name, var const& value) override;
     void valueChanged(Value& v) override;
 
+    // Called by the canvas when compiled mode is toggled
+    void updateHvccCompatibility();
+
     void changeListenerCallback(ChangeBroadcaster* source) override;
     void timerCallback() override;
 
@@ -113,8 +114,6 @@ public:
     Value locked;
     Value commandLocked;
     Value presentationMode;
-    CachedValue<bool> hvccMode;
-    CachedValue<bool> patchDownwardsOnly;
 
     Canvas* cnv;
     PluginEditor* editor;
@@ -15,7 +15,8 @@
 #include "Connection.h"
 
 ObjectGrid::ObjectGrid(Canvas* cnv)
-    : cnv(cnv)
+    : SettingsFileListener({ "grid_enabled", "grid_type", "grid_size" })
+    , cnv(cnv)
 {
     gridEnabled = SettingsFile::getInstance()->getProperty<int>("grid_enabled");
     gridType = SettingsFile::getInstance()->getProperty<int>("grid_type");
@@ -10,6 +10,83 @@ extern "C" {
 void garray_arraydialog(t_fake_garray* x, t_symbol* name, t_floatarg fsize, t_floatarg fflags, t_floatarg deleteit);
 }
 
+// Min/max pyramid of the array contents, where every level halves the resolution of the level below
+// This lets us find the range of values behind a pixel column in O(log n), without going over all samples
+class ArrayPyramid {
+public:
+    void rebuild(HeapArray<float> const& samples)
+    {
+        minLevels.clear();
+        maxLevels.clear();
+
+        auto levelSize = samples.size();
+        while (levelSize > 1) {
+            levelSize = (levelSize + 1) / 2;
+            minLevels.emplace_back(levelSize);
+            maxLevels.emplace_back(levelSize);
+        }
+
+        update(samples, 0, samples.size());
+    }
+
+    // Recalculates the levels above the changed range of samples
+    void update(HeapArray<float> const& samples, size_t start, size_t end)
+    {
+        for (int level = 0; level < minLevels.size() && start < end; level++) {
+            auto lowerSize = level == 0 ? samples.size() : minLevels[level - 1].size();
+            auto& mins = minLevels[level];
+            auto& maxs = maxLevels[level];
+
+            start /= 2;
+            end = (end - 1) / 2 + 1;
+            for (auto i = start; i < end; i++) {
+                auto a = i * 2;
+                auto b = std::min(a + 1, lowerSize - 1);
+                if (level == 0) {
+                    mins[i] = std::min(samples[a], samples[b]);
+                    maxs[i] = std::max(samples[a], samples[b]);
+                } else {
+                    mins[i] = std::min(minLevels[level - 1][a], minLevels[level - 1][b]);
+                    maxs[i] = std::max(maxLevels[level - 1][a], maxLevels[level - 1][b]);
+                }
+            }
+        }
+    }
+
+    // Returns the minimum and maximum of the samples in range [start, end)
+    std::pair<float, float> getRange(HeapArray<float> const& samples, size_t start, size_t end) const
+    {
+        float low = std::numeric_limits<float>::max();
+        float high = std::numeric_limits<float>::lowest();
+
+        auto include = [&](int level, size_t index) {
+            if (level == 0) {
+                low = std::min(low, samples[index]);
+                high = std::max(high, samples[index]);
+            } else {
+                low = std::min(low, minLevels[level - 1][index]);
+                high = std::max(high, maxLevels[level - 1][index]);
+            }
+        };
+
+        for (int level = 0; start < end; level++) {
+            if (start & 1)
+                include(level, start++);
+            if (end & 1)
+                include(level, --end);
+
+            start /= 2;
+            end /= 2;
+        }
+
+        return { low, high };
+    }
+
+private:
+    HeapArray<HeapArray<float>> minLevels;
+    HeapArray<HeapArray<float>> maxLevels;
+};
+
 class GraphicalArray : public Component
     , public Value::Listener
     , public pd::MessageListener
@@ -40,7 +117,7 @@ public:
         , pd(instance)
     {
         vec.reserve(8192);
-        read(vec);
+        read();
 
         updateParameters();
 
@@ -60,41 +137,78 @@ public:
         pd->unregisterMessageListener(this);
     }
 
-    static HeapArray<float> rescale(HeapArray<float> const& v, unsigned const newSize)
+    // Draws the minimum and maximum of the samples behind every pixel column, so peaks don't get lost when zoomed out
+    static Path createDecimatedArrayPath(HeapArray<float> const& samples, ArrayPyramid const& pyramid, DrawType style, StackArray<float, 2> scale, float width, float height)
     {
-        if (v.empty()) {
-            return {};
+        bool invert = false;
+        if (scale[0] >= scale[1]) {
+            invert = true;
+            std::swap(scale[0], scale[1]);
         }
 
-        HeapArray<float> result(newSize);
-        std::size_t const oldSize = v.size();
-        for (unsigned i = 0; i < newSize; i++) {
-            auto const idx = i * (oldSize - 1) / newSize;
-            auto const mod = i * (oldSize - 1) % newSize;
+        float const dh = height / (scale[1] - scale[0]);
+        float const invh = invert ? 0 : height;
+        float const yscale = invert ? -1.0f : 1.0f;
+
+        auto const numSamples = samples.size();
+        auto const numColumns = std::max<size_t>(static_cast<size_t>(width), 2);
+        float const dw = width / static_cast<float>(numColumns - 1);
 
-            if (mod == 0)
-                result[i] = v[idx];
-            else {
-                float const part = float(mod) / float(newSize);
-                result[i] = v[idx] * (1.0 - part) + v[idx + 1] * part;
+        Path result;
+        float lastY = 0.0f;
+        for (size_t column = 0; column < numColumns; column++) {
+            auto const start = column * numSamples / numColumns;
+            auto const end = std::max(start + 1, (column + 1) * numSamples / numColumns);
+            auto [low, high] = pyramid.getRange(samples, start, end);
+
+            auto lowY = invh - (std::clamp(low, scale[0], scale[1]) - scale[0]) * dh * yscale;
+            auto highY = invh - (std::clamp(high, scale[0], scale[1]) - scale[0]) * dh * yscale;
+            auto const x = column * dw;
+            if (!std::isfinite(lowY) || !std::isfinite(highY))
+                continue;
+
+            if (style == Points) {
+                result.startNewSubPath(x, lowY);
+                if (lowY == highY)
+                    result.lineTo(x + dw, lowY);
+                else
+                    result.lineTo(x, highY);
+                continue;
             }
+
+            // Visit the extreme that's closest to the previous column first, to keep the line connected
+            if (std::abs(lastY - highY) < std::abs(lastY - lowY))
+                std::swap(lowY, highY);
+
+            if (result.isEmpty())
+                result.startNewSubPath(x, lowY);
+            else
+                result.lineTo(x, lowY);
+
+            if (highY != lowY)
+                result.lineTo(x, highY);
+
+            lastY = highY;
         }
+
         return result;
     }
 
-    static Path createArrayPath(HeapArray<float> points, DrawType style, StackArray<float, 2> scale, float width, float height)
+    static Path createArrayPath(HeapArray<float> const& samples, ArrayPyramid const& pyramid, DrawType style, StackArray<float, 2> scale, float width, float height)
     {
+        // More than a point per pixel will cause insane loads, and isn't actually helpful
+        // Instead, use the min/max pyramid to draw the envelope at a max size of width in pixels
+        if (samples.size() > width) {
+            return createDecimatedArrayPath(samples, pyramid, style, scale, width, height);
+        }
+
         bool invert = false;
         if (scale[0] >= scale[1]) {
             invert = true;
             std::swap(scale[0], scale[1]);
         }
 
-        // More than a point per pixel will cause insane loads, and isn't actually helpful
-        // Instead, linearly interpolate the vector to a max size of width in pixels
-        if (points.size() > width) {
-            points = rescale(points, width);
-        }
+        HeapArray<float> points = samples;
 
         // Need at least 4 points to draw a bezier curve
         if (points.size() <= 4 && style == Curve)
@@ -190,13 +304,29 @@ public:
         return result;
     }
 
+    // Only recreates the path when the contents or the way it's drawn has changed
+    Path const& getArrayPath(float width, float height)
+    {
+        auto const style = getDrawType();
+        auto const scale = getScale();
+        if (pathNeedsUpdate || style != lastPathStyle || scale[0] != lastPathScale[0] || scale[1] != lastPathScale[1] || width != lastPathSize.x || height != lastPathSize.y) {
+            arrayPath = createArrayPath(vec, pyramid, style, scale, width, height);
+            lastPathStyle = style;
+            lastPathScale = scale;
+            lastPathSize = { width, height };
+            pathNeedsUpdate = false;
+        }
+
+        return arrayPath;
+    }
+
     void paintGraph(Graphics& g)
     {
         auto const h = static_cast<float>(getHeight());
         auto const w = static_cast<float>(getWidth());
 
         if (vec.not_empty()) {
-            auto p = createArrayPath(vec, getDrawType(), getScale(), w, h);
+            auto const& p = getArrayPath(w, h);
             g.setColour(getContentColour());
             g.strokePath(p, PathStrokeType(getLineWidth()));
         }
@@ -211,8 +341,7 @@ public:
         nvgIntersectRoundedScissor(nvg, arrB.getX(), arrB.getY(), arrB.getWidth(), arrB.getHeight(), Corners::objectCornerRadius);
 
         if (vec.not_empty()) {
-            auto p = createArrayPath(vec, getDrawType(), getScale(), w, h);
-            setJUCEPath(nvg, p);
+            setJUCEPath(nvg, getArrayPath(w, h));
 
             auto contentColour = getContentColour();
 
@@ -381,6 +510,9 @@ public:
             vec[n] = jmap<float>(n, interpStart, interpEnd + 1, min, max);
         }
 
+        pyramid.update(vec, interpStart, interpEnd + 1);
+        pathNeedsUpdate = true;
+
         // Don't want to touch vec on the other thread, so we copy the vector into the lambda
         auto changed = HeapArray<float>(vec.begin() + interpStart, vec.begin() + interpEnd + 1);
 
@@ -416,7 +548,7 @@ public:
         size = getArraySize();
 
         if (!edited) {
-            bool changed = read(vec);
+            bool changed = read();
             if (changed)
                 repaint();
         }
@@ -617,20 +749,46 @@ public:
     }
 
     // Gets the values from the array.
-    bool read(HeapArray<float>& output) const
+    // Pd doesn't tell us which part of the array was written, so we compare against our copy in blocks,
+    // and only update the pyramid for the blocks that actually changed
+    bool read()
     {
         bool changed = false;
         if (auto ptr = arr.get<t_garray>()) {
-            int const size = garray_getarray(ptr.get())->a_n;
-            output.resize(static_cast<size_t>(size));
+            auto const size = static_cast<size_t>(garray_getarray(ptr.get())->a_n);
+            t_word* words = ((t_word*)garray_vec(ptr.get()));
 
-            t_word* vec = ((t_word*)garray_vec(ptr.get()));
-            for (int i = 0; i < size; i++) {
-                changed = changed || output[i] != vec[i].w_float;
-                output[i] = vec[i].w_float;
+            if (size != vec.size()) {
+                vec.resize(size);
+                for (size_t i = 0; i < size; i++) {
+                    vec[i] = words[i].w_float;
+                }
+                pyramid.rebuild(vec);
+                pathNeedsUpdate = true;
+                return true;
+            }
+
+            constexpr size_t blockSize = 4096;
+            for (size_t blockStart = 0; blockStart < size; blockStart += blockSize) {
+                auto const blockEnd = std::min(blockStart + blockSize, size);
+                auto firstChanged = blockEnd;
+                auto lastChanged = blockStart;
+                for (auto i = blockStart; i < blockEnd; i++) {
+                    if (vec[i] != words[i].w_float) {
+                        vec[i] = words[i].w_float;
+                        firstChanged = std::min(firstChanged, i);
+                        lastChanged = i;
+                    }
+                }
+
+                if (firstChanged < blockEnd) {
+                    pyramid.update(vec, firstChanged, lastChanged + 1);
+                    changed = true;
+                }
             }
         }
 
+        pathNeedsUpdate = pathNeedsUpdate || changed;
         return changed;
     }
 
@@ -646,7 +804,14 @@ public:
     pd::WeakReference arr;
 
     HeapArray<float> vec;
+    ArrayPyramid pyramid;
     std::atomic<bool> edited;
+
+    Path arrayPath;
+    bool pathNeedsUpdate = true;
+    DrawType lastPathStyle = Points;
+    StackArray<float, 2> lastPathScale = { 0.0f, 0.0f };
+    Point<float> lastPathSize;
     bool error = false;
     String const stringArray = "array";
 
@@ -48,7 +48,7 @@ public:
     {
         if (!editor) {
             auto textArea = border.subtractedFrom(getLocalBounds());
-            textRenderer.renderText(nvg, textArea, getImageScale());
+            textRenderer.renderText(nvg, textArea, getImageScale(), isZooming());
         } else {
             imageRenderer.renderJUCEComponent(nvg, *editor, getImageScale());
         }
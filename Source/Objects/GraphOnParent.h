@@ -296,7 +296,7 @@ public:
             } else {
                 auto text = getText();
                 if (text != "graph" && text.isNotEmpty()) {
-                    textRenderer.renderText(nvg, Rectangle<int>(5, 0, getWidth() - 5, 16), getImageScale());
+                    textRenderer.renderText(nvg, Rectangle<int>(5, 0, getWidth() - 5, 16), getImageScale(), isZooming());
                 }
             }
         }
@@ -29,42 +29,94 @@ class LuaObject final : public ObjectBase
 
     UnorderedMap<int, NVGFramebuffer> framebuffers;
 
-    struct LuaGuiMessage {
-        t_symbol* symbol;
-        SmallArray<t_atom> data;
-        int size;
+    // pdlua draw calls, with their selector resolved once instead of on every call
+    enum class DrawOp : uint8 {
+        Unknown,
+        StartPaint,
+        EndPaint,
+        Resized,
+        SetColour,
+        StrokeLine,
+        FillEllipse,
+        StrokeEllipse,
+        FillRect,
+        StrokeRect,
+        FillRoundedRect,
+        StrokeRoundedRect,
+        DrawLine,
+        DrawText,
+        FillPath,
+        StrokePath,
+        FillAll,
+        Translate,
+        Scale,
+        ResetTransform
+    };
 
-        LuaGuiMessage() { };
+    // The arguments of a command are stored as floats in the arena of the frame it belongs to
+    struct DrawCommand {
+        DrawOp op;
+        t_symbol* text; // Only used for drawing text
+        int argOffset;
+        int numArgs;
 
-        LuaGuiMessage(t_symbol* sym, int argc, t_atom* argv)
-            : symbol(sym)
+        bool operator==(DrawCommand const& other) const
         {
-            data = SmallArray<t_atom>(argv, argv + argc);
-            size = argc;
+            return op == other.op && text == other.text && argOffset == other.argOffset && numArgs == other.numArgs;
         }
+    };
+
+    // All commands of a layer from lua_start_paint up to and including lua_end_paint
+    struct DrawFrame {
+        HeapArray<DrawCommand> commands;
+        HeapArray<float> arena;
+        hash32 streamHash = EMPTY_HASH;
+        bool isNew = false;
 
-        LuaGuiMessage(LuaGuiMessage const& other) noexcept
+        // Keeps the allocated memory, so recording doesn't allocate anymore once the buffers are large enough
+        void clear()
         {
-            symbol = other.symbol;
-            size = other.size;
-            data = other.data;
+            commands.clear();
+            arena.clear();
+            streamHash = EMPTY_HASH;
         }
 
-        LuaGuiMessage& operator=(LuaGuiMessage const& other) noexcept
+        // The hash is only a quick check, equal hashes still need the commands and their arguments to be compared
+        bool hasSameCommands(DrawFrame const& other) const
         {
-            // Check for self-assignment
-            if (this != &other) {
-                symbol = other.symbol;
-                size = other.size;
-                data = other.data;
-            }
+            if (streamHash != other.streamHash || commands.size() != other.commands.size() || arena.size() != other.arena.size())
+                return false;
 
-            return *this;
+            return std::equal(commands.begin(), commands.end(), other.commands.begin()) && std::memcmp(arena.data(), other.arena.data(), arena.size() * sizeof(float)) == 0;
         }
     };
 
-    UnorderedSegmentedMap<int, HeapArray<LuaGuiMessage>> guiCommandBuffer;
-    UnorderedSegmentedMap<int, moodycamel::ReaderWriterQueue<LuaGuiMessage>> guiMessageQueue;
+    struct RecordingLayer {
+        DrawFrame frame;
+        bool isRecording = false;
+    };
+
+    struct RenderLayer {
+        DrawFrame frame;
+        DrawFrame renderedFrame; // Copy of the commands that are currently in the framebuffer
+        int renderedWidth = 0;
+        int renderedHeight = 0;
+        bool renderedSelected = false;
+        bool isRendered = false;
+        bool hasFrame = false;
+    };
+
+    // Frames are recorded on the pd thread, published when they are complete, and picked up by the message thread
+    // The three frames of a layer are swapped around, so their buffers are reused
+    UnorderedMap<int, RecordingLayer> recordingLayers;
+    UnorderedMap<int, DrawFrame> publishedFrames;
+    UnorderedMap<int, RenderLayer> renderLayers;
+    SpinLock publishLock;
+
+    moodycamel::ReaderWriterQueue<std::pair<float, float>> resizeQueue;
+
+    static inline UnorderedMap<t_symbol*, DrawOp> drawOps = UnorderedMap<t_symbol*, DrawOp>();
+    static inline SpinLock drawOpsLock;
 
     static inline UnorderedMap<t_pdlua*, SmallArray<LuaObject*>> allDrawTargets = UnorderedMap<t_pdlua*, SmallArray<LuaObject*>>();
 
@@ -212,6 +264,10 @@ public:
 
     void lookAndFeelChanged() override
     {
+        // Colours might have changed, so render the next frame even if its commands didn't change
+        for (auto& [layer, renderLayer] : renderLayers)
+            renderLayer.isRendered = false;
+
         sendRepaintMessage();
     }
 
@@ -227,23 +283,136 @@ public:
         sendRepaintMessage();
     }
 
-    void handleGuiMessage(int layer, t_symbol* sym, int argc, t_atom* argv)
+    static DrawOp getDrawOp(t_symbol* sym)
     {
-        NVGcontext* nvg = cnv->editor->nvgSurface.getRawContext();
-        if (!nvg)
+        // Selectors are interned by pd, so we only need to look at the name the first time we see a symbol
+        SpinLock::ScopedLockType lock(drawOpsLock);
+        auto it = drawOps.find(sym);
+        if (it != drawOps.end())
+            return it->second;
+
+        auto op = DrawOp::Unknown;
+        switch (hash(sym->s_name)) {
+        case hash("lua_start_paint"):
+            op = DrawOp::StartPaint;
+            break;
+        case hash("lua_end_paint"):
+            op = DrawOp::EndPaint;
+            break;
+        case hash("lua_resized"):
+            op = DrawOp::Resized;
+            break;
+        case hash("lua_set_color"):
+            op = DrawOp::SetColour;
+            break;
+        case hash("lua_stroke_line"):
+            op = DrawOp::StrokeLine;
+            break;
+        case hash("lua_fill_ellipse"):
+            op = DrawOp::FillEllipse;
+            break;
+        case hash("lua_stroke_ellipse"):
+            op = DrawOp::StrokeEllipse;
+            break;
+        case hash("lua_fill_rect"):
+            op = DrawOp::FillRect;
+            break;
+        case hash("lua_stroke_rect"):
+            op = DrawOp::StrokeRect;
+            break;
+        case hash("lua_fill_rounded_rect"):
+            op = DrawOp::FillRoundedRect;
+            break;
+        case hash("lua_stroke_rounded_rect"):
+            op = DrawOp::StrokeRoundedRect;
+            break;
+        case hash("lua_draw_line"):
+            op = DrawOp::DrawLine;
+            break;
+        case hash("lua_draw_text"):
+            op = DrawOp::DrawText;
+            break;
+        case hash("lua_fill_path"):
+            op = DrawOp::FillPath;
+            break;
+        case hash("lua_stroke_path"):
+            op = DrawOp::StrokePath;
+            break;
+        case hash("lua_fill_all"):
+            op = DrawOp::FillAll;
+            break;
+        case hash("lua_translate"):
+            op = DrawOp::Translate;
+            break;
+        case hash("lua_scale"):
+            op = DrawOp::Scale;
+            break;
+        case hash("lua_reset_transform"):
+            op = DrawOp::ResetTransform;
+            break;
+        default:
+            break;
+        }
+
+        drawOps[sym] = op;
+        return op;
+    }
+
+    // Called on the pd thread
+    void recordDrawCommand(int layer, DrawOp op, int argc, t_atom* argv)
+    {
+        if (op == DrawOp::Unknown)
             return;
 
-        auto hashsym = hash(sym->s_name);
-        // First check functions that don't need an active graphics context, of modify the active graphics context
-        switch (hashsym) {
-        case hash("lua_start_paint"): {
-            if (getLocalBounds().isEmpty())
-                break;
+        if (op == DrawOp::Resized) {
+            if (argc >= 2)
+                resizeQueue.enqueue({ atom_getfloat(argv), atom_getfloat(argv + 1) });
+            return;
+        }
+
+        auto& recording = recordingLayers[layer];
+        if (op == DrawOp::StartPaint) {
+            recording.frame.clear();
+            recording.isRecording = true;
+        }
+        if (!recording.isRecording)
+            return;
+
+        auto& frame = recording.frame;
+        DrawCommand command { op, nullptr, static_cast<int>(frame.arena.size()), argc };
+        for (int i = 0; i < argc; i++) {
+            if (argv[i].a_type == A_SYMBOL && !command.text)
+                command.text = atom_getsymbol(argv + i);
+            frame.arena.add(atom_getfloat(argv + i));
+        }
+        frame.commands.add(command);
+
+        frame.streamHash = hash(&command.op, sizeof(command.op), frame.streamHash);
+        frame.streamHash = hash(&command.text, sizeof(command.text), frame.streamHash);
+        frame.streamHash = hash(frame.arena.data() + command.argOffset, argc * sizeof(float), frame.streamHash);
+
+        if (op == DrawOp::EndPaint) {
+            recording.isRecording = false;
+
+            SpinLock::ScopedLockType lock(publishLock);
+            auto& published = publishedFrames[layer];
+            std::swap(published, frame);
+            published.isNew = true;
+        }
+    }
+
+    void handleDrawCommand(NVGcontext* nvg, int layer, DrawCommand const& command, float const* args)
+    {
+        auto arg = [&command, args](int idx) {
+            return idx < command.numArgs ? args[idx] : 0.0f;
+        };
+
+        auto argc = command.numArgs;
+        switch (command.op) {
+        case DrawOp::StartPaint: {
             auto scale = getValue<float>(zoomScale) * 2.0f; // Multiply by 2 for hi-dpi screens
             int imageWidth = std::ceil(getWidth() * scale);
             int imageHeight = std::ceil(getHeight() * scale);
-            if (!imageWidth || !imageHeight)
-                return;
 
             framebuffers[layer].bind(nvg, imageWidth, imageHeight);
 
@@ -251,9 +420,9 @@ public:
             nvgClear(nvg);
             nvgBeginFrame(nvg, getWidth(), getHeight(), scale);
             nvgSave(nvg);
-            return;
+            break;
         }
-        case hash("lua_end_paint"): {
+        case DrawOp::EndPaint: {
             if (!framebuffers[layer].isValid())
                 return;
 
@@ -262,50 +431,35 @@ public:
             nvgEndFrame(nvg);
             framebuffers[layer].unbind();
             repaint();
-            return;
-        }
-        case hash("lua_resized"): {
-            if (argc >= 2) {
-                if (auto pdlua = ptr.get<t_pdlua>()) {
-                    pdlua->gfx.width = atom_getfloat(argv);
-                    pdlua->gfx.height = atom_getfloat(argv + 1);
-                }
-                MessageManager::callAsync([_object = SafePointer(object)]() {
-                    if (_object)
-                        _object->updateBounds();
-                });
-            }
-            return;
-        }
+            break;
         }
-
-        switch (hashsym) {
-        case hash("lua_set_color"): {
+        case DrawOp::SetColour: {
             if (argc == 1) {
-                int colourID = atom_getfloat(argv);
+                int colourID = arg(0);
 
                 currentColour = StackArray<Colour, 3> { cnv->guiObjectBackgroundColJuce, cnv->canvasTextColJuce, cnv->guiObjectInternalOutlineColJuce }[colourID];
                 nvgFillColor(nvg, convertColour(currentColour));
                 nvgStrokeColor(nvg, convertColour(currentColour));
             }
             if (argc >= 3) {
-                Colour color(static_cast<uint8>(atom_getfloat(argv)),
-                    static_cast<uint8>(atom_getfloat(argv + 1)),
-                    static_cast<uint8>(atom_getfloat(argv + 2)));
+                Colour color(static_cast<uint8>(arg(0)),
+                    static_cast<uint8>(arg(1)),
+                    static_cast<uint8>(arg(2)));
 
-                currentColour = color.withAlpha(argc >= 4 ? atom_getfloat(argv + 3) : 1.0f);
+                currentColour = color.withAlpha(argc >= 4 ? arg(3) : 1.0f);
                 nvgFillColor(nvg, convertColour(currentColour));
                 nvgStrokeColor(nvg, convertColour(currentColour));
             }
             break;
         }
-        case hash("lua_stroke_line"): {
+        case DrawOp::StrokeLine:
+        case DrawOp::DrawLine: {
             if (argc >= 4) {
-                float x1 = atom_getfloat(argv);
-                float y1 = atom_getfloat(argv + 1);
-                float x2 = atom_getfloat(argv + 2);
-                float y2 = atom_getfloat(argv + 3);
-                float lineThickness = atom_getfloat(argv + 4);
+                float x1 = arg(0);
+                float y1 = arg(1);
+                float x2 = arg(2);
+                float y2 = arg(3);
+                float lineThickness = arg(4);
 
                 nvgStrokeWidth(nvg, lineThickness);
                 nvgBeginPath(nvg);
@@ -315,12 +469,12 @@ public:
             }
             break;
         }
-        case hash("lua_fill_ellipse"): {
+        case DrawOp::FillEllipse: {
             if (argc >= 3) {
-                float x = atom_getfloat(argv);
-                float y = atom_getfloat(argv + 1);
-                float w = atom_getfloat(argv + 2);
-                float h = atom_getfloat(argv + 3);
+                float x = arg(0);
+                float y = arg(1);
+                float w = arg(2);
+                float h = arg(3);
 
                 nvgBeginPath(nvg);
                 nvgEllipse(nvg, x + (w / 2), y + (h / 2), w / 2, h / 2);
@@ -328,13 +482,13 @@ public:
             }
             break;
         }
-        case hash("lua_stroke_ellipse"): {
+        case DrawOp::StrokeEllipse: {
             if (argc >= 4) {
-                float x = atom_getfloat(argv);
-                float y = atom_getfloat(argv + 1);
-                float w = atom_getfloat(argv + 2);
-                float h = atom_getfloat(argv + 3);
-                float lineThickness = atom_getfloat(argv + 4);
+                float x = arg(0);
+                float y = arg(1);
+                float w = arg(2);
+                float h = arg(3);
+                float lineThickness = arg(4);
 
                 nvgStrokeWidth(nvg, lineThickness);
                 nvgBeginPath(nvg);
@@ -343,51 +497,39 @@ public:
             }
             break;
         }
-        case hash("lua_fill_rect"): {
+        case DrawOp::FillRect: {
             if (argc >= 4) {
-                float x = atom_getfloat(argv);
-                float y = atom_getfloat(argv + 1);
-                float w = atom_getfloat(argv + 2);
-                float h = atom_getfloat(argv + 3);
-
-                nvgFillRect(nvg, x, y, w, h);
+                nvgFillRect(nvg, arg(0), arg(1), arg(2), arg(3));
             }
             break;
         }
-        case hash("lua_stroke_rect"): {
+        case DrawOp::StrokeRect: {
             if (argc >= 5) {
-                float x = atom_getfloat(argv);
-                float y = atom_getfloat(argv + 1);
-                float w = atom_getfloat(argv + 2);
-                float h = atom_getfloat(argv + 3);
-                float lineThickness = atom_getfloat(argv + 4);
-
-                nvgStrokeWidth(nvg, lineThickness);
-                nvgStrokeRect(nvg, x, y, w, h);
+                nvgStrokeWidth(nvg, arg(4));
+                nvgStrokeRect(nvg, arg(0), arg(1), arg(2), arg(3));
             }
             break;
         }
-        case hash("lua_fill_rounded_rect"): {
+        case DrawOp::FillRoundedRect: {
             if (argc >= 4) {
-                float x = atom_getfloat(argv);
-                float y = atom_getfloat(argv + 1);
-                float w = atom_getfloat(argv + 2);
-                float h = atom_getfloat(argv + 3);
-                float cornerRadius = atom_getfloat(argv + 4);
+                float x = arg(0);
+                float y = arg(1);
+                float w = arg(2);
+                float h = arg(3);
+                float cornerRadius = arg(4);
 
                 nvgFillRoundedRect(nvg, x, y, w, h, cornerRadius);
             }
             break;
         }
-
-        case hash("lua_stroke_rounded_rect"): {
+        case DrawOp::StrokeRoundedRect: {
             if (argc >= 6) {
-                float x = atom_getfloat(argv);
-                float y = atom_getfloat(argv + 1);
-                float w = atom_getfloat(argv + 2);
-                float h = atom_getfloat(argv + 3);
-                float cornerRadius = atom_getfloat(argv + 4);
-                float lineThickness = atom_getfloat(argv + 5);
+                float x = arg(0);
+                float y = arg(1);
+                float w = arg(2);
+                float h = arg(3);
+                float cornerRadius = arg(4);
+                float lineThickness = arg(5);
 
                 nvgStrokeWidth(nvg, lineThickness);
                 nvgBeginPath(nvg);
@@ -396,90 +538,65 @@ public:
             }
             break;
         }
-        case hash("lua_draw_line"): {
-            if (argc >= 4) {
-                float x1 = atom_getfloat(argv);
-                float y1 = atom_getfloat(argv + 1);
-                float x2 = atom_getfloat(argv + 2);
-                float y2 = atom_getfloat(argv + 3);
-                float lineThickness = atom_getfloat(argv + 4);
-
-                nvgStrokeWidth(nvg, lineThickness);
-                nvgBeginPath(nvg);
-                nvgMoveTo(nvg, x1, y1);
-                nvgLineTo(nvg, x2, y2);
-                nvgStroke(nvg);
-            }
-            break;
-        }
-        case hash("lua_draw_text"): {
-            if (argc >= 4) {
-                float x = atom_getfloat(argv + 1);
-                float y = atom_getfloat(argv + 2);
-                float w = atom_getfloat(argv + 3);
-                float fontHeight = atom_getfloat(argv + 4);
+        case DrawOp::DrawText: {
+            if (argc >= 4 && command.text) {
+                float x = arg(1);
+                float y = arg(2);
+                float w = arg(3);
+                float fontHeight = arg(4);
 
                 nvgBeginPath(nvg);
                 nvgFontSize(nvg, fontHeight);
                 nvgTextAlign(nvg, NVG_ALIGN_TOP | NVG_ALIGN_LEFT);
-                nvgTextBox(nvg, x, y, w, atom_getsymbol(argv)->s_name, nullptr);
+                nvgTextBox(nvg, x, y, w, command.text->s_name, nullptr);
             }
             break;
         }
-        case hash("lua_fill_path"): {
+        case DrawOp::FillPath: {
             nvgBeginPath(nvg);
-            nvgMoveTo(nvg, atom_getfloat(argv), atom_getfloat(argv + 1));
+            nvgMoveTo(nvg, arg(0), arg(1));
             for (int i = 1; i < argc / 2; i++) {
-                float x = atom_getfloat(argv + (i * 2));
-                float y = atom_getfloat(argv + (i * 2) + 1);
-                nvgLineTo(nvg, x, y);
+                nvgLineTo(nvg, arg(i * 2), arg(i * 2 + 1));
             }
 
             nvgClosePath(nvg);
             nvgFill(nvg);
             break;
         }
-        case hash("lua_stroke_path"): {
+        case DrawOp::StrokePath: {
             nvgBeginPath(nvg);
-            auto strokeWidth = atom_getfloat(argv);
+            auto strokeWidth = arg(0);
 
             int numPoints = (argc - 1) / 2;
-            nvgMoveTo(nvg, atom_getfloat(argv + 1), atom_getfloat(argv + 2));
+            nvgMoveTo(nvg, arg(1), arg(2));
             for (int i = 1; i < numPoints; i++) {
-                float x = atom_getfloat(argv + (i * 2) + 1);
-                float y = atom_getfloat(argv + (i * 2) + 2);
-                nvgLineTo(nvg, x, y);
+                nvgLineTo(nvg, arg(i * 2 + 1), arg(i * 2 + 2));
             }
 
             nvgStrokeWidth(nvg, strokeWidth);
             nvgStroke(nvg);
             break;
         }
-        case hash("lua_fill_all"): {
+        case DrawOp::FillAll: {
             auto bounds = getLocalBounds();
             auto outlineColour = isSelected ? cnv->selectedOutlineCol : cnv->objectOutlineCol;
 
             nvgDrawRoundedRect(nvg, bounds.getX(), bounds.getY(), bounds.getWidth(), bounds.getHeight(), convertColour(currentColour), outlineColour, Corners::objectCornerRadius);
             break;
         }
-
-        case hash("lua_translate"): {
+        case DrawOp::Translate: {
             if (argc >= 2) {
-                float tx = atom_getfloat(argv);
-                float ty = atom_getfloat(argv + 1);
-                nvgTranslate(nvg, tx, ty);
+                nvgTranslate(nvg, arg(0), arg(1));
             }
             break;
         }
-        case hash("lua_scale"): {
+        case DrawOp::Scale: {
             if (argc >= 2) {
-                float sx = atom_getfloat(argv);
-                float sy = atom_getfloat(argv + 1);
-                nvgScale(nvg, sx, sy);
+                nvgScale(nvg, arg(0), arg(1));
             }
             break;
         }
-        case hash("lua_reset_transform"): {
+        case DrawOp::ResetTransform: {
             nvgRestore(nvg);
             nvgSave(nvg);
             break;
@@ -494,47 +611,60 @@ public:
     // So we have this separate callback function that occurs after activating the GPU context, but before starting the frame
     void updateFramebuffers() override
     {
-        LuaGuiMessage guiMessage;
-        for (auto& [layer, layerQueue] : guiMessageQueue) {
-            if (layer == -1) // non-layer related messages
-            {
-                while (layerQueue.try_dequeue(guiMessage)) {
-                    handleGuiMessage(layer, guiMessage.symbol, guiMessage.size, guiMessage.data.data());
-                }
-                continue;
+        std::pair<float, float> newSize;
+        while (resizeQueue.try_dequeue(newSize)) {
+            if (auto pdlua = ptr.get<t_pdlua>()) {
+                pdlua->gfx.width = newSize.first;
+                pdlua->gfx.height = newSize.second;
             }
+            MessageManager::callAsync([_object = SafePointer(object)]() {
+                if (_object)
+                    _object->updateBounds();
+            });
+        }
 
-            while (layerQueue.try_dequeue(guiMessage)) {
-                guiCommandBuffer[layer].add(guiMessage);
+        {
+            SpinLock::ScopedLockType lock(publishLock);
+            for (auto& [layer, published] : publishedFrames) {
+                if (!published.isNew)
+                    continue;
+
+                auto& renderLayer = renderLayers[layer];
+                std::swap(renderLayer.frame, published);
+                renderLayer.frame.isNew = false;
+                renderLayer.hasFrame = true;
+                published.isNew = false;
             }
+        }
 
-            auto* startMesage = pd->generateSymbol("lua_start_paint");
-            auto* endMessage = pd->generateSymbol("lua_end_paint");
+        NVGcontext* nvg = cnv->editor->nvgSurface.getRawContext();
+        if (!nvg)
+            return;
 
-            int startIdx = -1, endIdx = -1;
-            bool updateScene = false;
-            for (int i = guiCommandBuffer[layer].size() - 1; i >= 0; i--) {
-                if (guiCommandBuffer[layer][i].symbol == startMesage)
-                    startIdx = i;
-                if (guiCommandBuffer[layer][i].symbol == endMessage)
-                    endIdx = i + 1;
+        auto scale = getValue<float>(zoomScale) * 2.0f; // Multiply by 2 for hi-dpi screens
+        int imageWidth = std::ceil(getWidth() * scale);
+        int imageHeight = std::ceil(getHeight() * scale);
 
-                if (startIdx != -1 && endIdx != -1) {
-                    updateScene = true;
-                    break;
-                }
-            }
+        for (auto& [layer, renderLayer] : renderLayers) {
+            auto& framebuffer = framebuffers[layer];
 
-            if (updateScene) {
-                if (endIdx > startIdx) {
-                    for (int i = startIdx; i < endIdx; i++) {
-                        handleGuiMessage(layer, guiCommandBuffer[layer][i].symbol, guiCommandBuffer[layer][i].size, guiCommandBuffer[layer][i].data.data());
-                    }
+            // Lua GUIs often repaint periodically without anything changing, in which case the framebuffer is still up-to-date
+            auto const upToDate = renderLayer.isRendered && framebuffer.isValid() && renderLayer.renderedWidth == imageWidth && renderLayer.renderedHeight == imageHeight && renderLayer.renderedSelected == isSelected && renderLayer.frame.hasSameCommands(renderLayer.renderedFrame);
+
+            if (renderLayer.hasFrame && imageWidth > 0 && imageHeight > 0 && !upToDate) {
+                auto const* arena = renderLayer.frame.arena.data();
+                for (auto const& command : renderLayer.frame.commands) {
+                    handleDrawCommand(nvg, layer, command, arena + command.argOffset);
                 }
-                guiCommandBuffer[layer].erase(guiCommandBuffer[layer].begin(), guiCommandBuffer[layer].begin() + endIdx);
+                // Copy assignment keeps the buffers of the previous copy, so this doesn't allocate once they are large enough
+                renderLayer.renderedFrame = renderLayer.frame;
+                renderLayer.renderedWidth = imageWidth;
+                renderLayer.renderedHeight = imageHeight;
+                renderLayer.renderedSelected = isSelected;
+                renderLayer.isRendered = true;
             }
 
-            if (isSelected != object->isSelected() || !framebuffers[layer].isValid()) {
+            if (isSelected != object->isSelected() || !framebuffer.isValid()) {
                 isSelected = object->isSelected();
                 sendRepaintMessage();
             }
@@ -543,8 +673,9 @@ public:
 
     static void drawCallback(void* target, int layer, t_symbol* sym, int argc, t_atom* argv)
     {
+        auto op = getDrawOp(sym);
         for (auto* object : allDrawTargets[static_cast<t_pdlua*>(target)]) {
-            object->guiMessageQueue[layer].enqueue({ sym, argc, argv });
+            object->recordDrawCommand(layer, op, argc, argv);
         }
     }
 
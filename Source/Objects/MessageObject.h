@@ -172,7 +172,7 @@ public:
             imageRenderer.renderJUCEComponent(nvg, *editor, getImageScale());
         } else {
             auto text = getText();
-            textRenderer.renderText(nvg, border.subtractedFrom(getLocalBounds()), getImageScale());
+            textRenderer.renderText(nvg, border.subtractedFrom(getLocalBounds()), getImageScale(), isZooming());
         }
     }
 
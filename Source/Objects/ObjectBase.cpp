@@ -143,6 +143,16 @@ void ObjectBase::PropertyListener::valueChanged(Value& v)
     if (noCallback)
         return;
 
+    if (auto* batch = PropertyChangeBatch::currentBatch) {
+        batch->changes.emplace_back(parent, v);
+        return;
+    }
+
+    applyChange(v);
+}
+
+void ObjectBase::PropertyListener::applyChange(Value& v)
+{
     if (!v.refersToSameSourceAs(lastValue) || Time::getMillisecondCounter() - lastChange > 6000) {
         onChange();
         lastValue.referTo(v);
@@ -152,6 +162,29 @@ void ObjectBase::PropertyListener::valueChanged(Value& v)
     parent->propertyChanged(v);
 }
 
+ObjectBase::PropertyChangeBatch::PropertyChangeBatch(PluginProcessor* instance)
+    : pd(instance)
+    , previousBatch(currentBatch)
+{
+    JUCE_ASSERT_MESSAGE_THREAD;
+    currentBatch = this;
+}
+
+ObjectBase::PropertyChangeBatch::~PropertyChangeBatch()
+{
+    currentBatch = previousBatch;
+    if (changes.empty())
+        return;
+
+    // Objects lock Pd for each of their messages as well, those nested locks are free while we hold it
+    pd->lockAudioThread();
+    for (auto& [object, value] : changes) {
+        if (object)
+            object->propertyListener.applyChange(value);
+    }
+    pd->unlockAudioThread();
+}
+
 ObjectBase::ObjectBase(pd::WeakReference obj, Object* parent)
     : NVGComponent(this)
     , ptr(obj)
@@ -341,6 +374,10 @@ Rectangle<int> ObjectBase::getSelectableBounds()
 // Makes sure that any tabs refering to the now deleted patch will be closed
 void ObjectBase::closeOpenedSubpatchers()
 {
+    // The subpatch is still there when we're only deleted because our canvas is hibernating
+    if (cnv->isHibernated)
+        return;
+
     for (auto* editor : pd->getEditors()) {
         for (auto* canvas : editor->getCanvases()) {
             auto* patch = getPatch().get();
@@ -466,7 +503,7 @@ void ObjectBase::paint(Graphics& g)
     g.drawRoundedRectangle(getLocalBounds().toFloat().reduced(0.5f), Corners::objectCornerRadius, 1.0f);
 }
 
-float ObjectBase::getImageScale()
+Canvas* ObjectBase::getTopLevelCanvas()
 {
     Canvas* topLevel = cnv;
     if (!hideInGraph()) { // No need to do this if we can't be visible in a graph anyway!
@@ -474,6 +511,17 @@ float ObjectBase::getImageScale()
             topLevel = nextCnv;
         }
     }
+    return topLevel;
+}
+
+bool ObjectBase::isZooming()
+{
+    return getTopLevelCanvas()->isZooming;
+}
+
+float ObjectBase::getImageScale()
+{
+    Canvas* topLevel = getTopLevelCanvas();
     if (topLevel->editor->pluginMode) {
         auto scale = std::sqrt(std::abs(topLevel->getTransform().getDeterminant()));
         return topLevel->getRenderScale() * std::max(1.0f, scale);
@@ -750,8 +798,6 @@ bool ObjectBase::canReceiveMouseEvent(int x, int y)
 
 void ObjectBase::receiveMessage(t_symbol* symbol, SmallArray<pd::Atom> const& atoms)
 {
-    object->triggerOverlayActiveState();
-
     auto symHash = hash(symbol->s_name);
     switch (symHash) {
     case hash("size"):
@@ -760,10 +806,7 @@ void ObjectBase::receiveMessage(t_symbol* symbol, SmallArray<pd::Atom> const& at
     case hash("dim"):
     case hash("width"):
     case hash("height"): {
-        MessageManager::callAsync([_this = SafePointer(this)]() {
-            if (_this)
-                _this->object->updateBounds();
-        });
+        boundsUpdatePending = true;
         break;
     }
     case hash("_activity"):
@@ -775,6 +818,20 @@ void ObjectBase::receiveMessage(t_symbol* symbol, SmallArray<pd::Atom> const& at
     receiveObjectMessage(symHash, atoms);
 }
 
+void ObjectBase::messagesFlushed()
+{
+    // A burst of messages only needs to flash the activity overlay once
+    object->triggerOverlayActiveState();
+
+    if (boundsUpdatePending) {
+        boundsUpdatePending = false;
+        MessageManager::callAsync([_this = SafePointer(this)]() {
+            if (_this)
+                _this->object->updateBounds();
+        });
+    }
+}
+
 void ObjectBase::setParameterExcludingListener(Value& parameter, var const& value)
 {
     propertyListener.setNoCallback(true);
@@ -101,6 +101,7 @@ class ObjectBase : public Component
         void setNoCallback(bool skipCallback);
 
         void valueChanged(Value& v) override;
+        void applyChange(Value& v);
 
         Value lastValue;
         uint32 lastChange;
@@ -110,6 +111,24 @@ class ObjectBase : public Component
     };
 
 public:
+    // While one of these exists, property changes are collected instead of applied right away
+    // They are applied to Pd under a single lock when it goes out of scope, so editing a selection doesn't lock once per object
+    class PropertyChangeBatch {
+    public:
+        explicit PropertyChangeBatch(PluginProcessor* instance);
+        ~PropertyChangeBatch();
+
+    private:
+        PluginProcessor* pd;
+        PropertyChangeBatch* previousBatch;
+        SmallArray<std::pair<SafePointer<ObjectBase>, Value>> changes;
+
+        static inline PropertyChangeBatch* currentBatch = nullptr;
+
+        friend struct PropertyListener;
+        JUCE_DECLARE_NON_COPYABLE(PropertyChangeBatch)
+    };
+
     ObjectBase(pd::WeakReference obj, Object* parent);
 
     ~ObjectBase() override;
@@ -192,6 +211,7 @@ public:
     bool click(Point<int> position, bool shift, bool alt);
 
     void receiveMessage(t_symbol* symbol, SmallArray<pd::Atom> const& atoms) override;
+    void messagesFlushed() override;
 
     static ObjectBase* createGui(pd::WeakReference ptr, Object* parent);
 
@@ -243,6 +263,9 @@ protected:
     // Gets the scale factor we need to use of we want to draw images inside the component
     float getImageScale();
 
+    // Returns true while the canvas we are drawn on is being zoomed
+    bool isZooming();
+
     // Used by various ELSE objects, though sometimes with char*, sometimes with unsigned char*
     template<typename T>
     void colourToHexArray(Colour colour, T* hex)
@@ -289,6 +312,11 @@ protected:
     float lastImageScale = 2.0f;
     PropertyListener propertyListener;
 
+    // Set when Pd changed our bounds, applied once when the message queue is flushed
+    bool boundsUpdatePending = false;
+
+    Canvas* getTopLevelCanvas();
+
     NVGImage imageRenderer;
 
     virtual std::unique_ptr<ComponentBoundsConstrainer> createConstrainer();
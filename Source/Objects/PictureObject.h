@@ -4,8 +4,11 @@
  // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
  */
 
+#include "Utility/ImageAssetCache.h"
+
 // ELSE pic
-class PictureObject final : public ObjectBase {
+class PictureObject final : public ObjectBase
+    , public ChangeListener {
 
     Value filename = SynchronousValue();
     Value latch = SynchronousValue();
@@ -16,9 +19,8 @@ class PictureObject final : public ObjectBase {
     Value sizeProperty = SynchronousValue();
 
     File imageFile;
-    Image img;
-    SmallArray<std::pair<std::unique_ptr<NVGImage>, Rectangle<int>>> imageBuffers;
-    bool imageNeedsReload = false;
+    ImageAssetCache::Asset::Ptr imageAsset;
+    bool imageSizePending = false;
 
 public:
     PictureObject(pd::WeakReference ptr, Object* object)
@@ -48,6 +50,8 @@ public:
 
     ~PictureObject()
     {
+        if (imageAsset)
+            imageAsset->removeChangeListener(this);
     }
 
     bool isTransparent() override
@@ -135,55 +139,31 @@ public:
         }
     }
 
-    void updateImage(NVGcontext* nvg)
+    // Called when the image has finished decoding, or when its textures need to be uploaded again
+    void changeListenerCallback(ChangeBroadcaster* source) override
     {
-        imageBuffers.clear();
-
-        if (!img.isValid() && File(imageFile).existsAsFile()) {
-            img = ImageFileFormat::loadFrom(imageFile).convertedToFormat(Image::ARGB);
-        }
-
-        int imageWidth = img.getWidth();
-        int imageHeight = img.getHeight();
-        int x = 0;
-        while (x < imageWidth) {
-            int y = 0;
-            int width = std::min(8192, imageWidth - x);
-            while (y < imageHeight) {
-                int height = std::min(8192, imageHeight - y);
-                auto bounds = Rectangle<int>(x, y, width, height);
-                auto clip = img.getClippedImage(bounds);
-
-                auto partialImage = std::make_unique<NVGImage>(nvg, width, height, [&clip](Graphics& g) {
-                    g.drawImageAt(clip, 0, 0);
-                });
-
-                partialImage->onImageInvalidate = [this]() {
-                    imageNeedsReload = true;
-                    repaint();
-                };
-
-                imageBuffers.emplace_back(std::move(partialImage), bounds);
-                y += 8192;
-            }
-            x += 8192;
+        if (imageSizePending && imageAsset && imageAsset->isLoaded()) {
+            imageSizePending = false;
+            applyImageSize();
         }
 
-        img = Image(); // Clear image from CPU memory after upload
-
-        imageNeedsReload = false;
+        repaint();
     }
 
     void render(NVGcontext* nvg) override
     {
-        if (imageNeedsReload)
-            updateImage(nvg);
-
         auto b = getLocalBounds().toFloat();
 
         NVGScopedState scopedState(nvg);
         nvgIntersectScissor(nvg, 0, 0, getWidth(), getHeight());
-        if (imageBuffers.empty()) {
+
+        auto const* tiles = imageAsset ? &imageAsset->getTiles(nvg) : nullptr;
+        if (imageAsset && !imageAsset->failedToLoad() && tiles->empty()) {
+            // Placeholder while the image is being decoded
+            auto placeholderColour = cnv->editor->getLookAndFeel().findColour(PlugDataColour::canvasTextColourId).withAlpha(0.1f);
+            nvgFillColor(nvg, convertColour(placeholderColour));
+            nvgFillRect(nvg, b.getX(), b.getY(), b.getWidth(), b.getHeight());
+        } else if (!tiles || tiles->empty()) {
             nvgFontSize(nvg, 20);
             nvgFontFace(nvg, "Inter-Regular");
             nvgTextAlign(nvg, NVG_ALIGN_CENTER | NVG_ALIGN_MIDDLE);
@@ -199,7 +179,7 @@ public:
 
             NVGScopedState scopedState(nvg);
             nvgTranslate(nvg, offsetX, offsetY);
-            for (auto& [image, bounds] : imageBuffers) {
+            for (auto& [image, bounds] : *tiles) {
                 nvgFillPaint(nvg, nvgImagePattern(nvg, bounds.getX(), bounds.getY(), bounds.getWidth(), bounds.getHeight(), 0, image->getImageId(), 1.0f));
                 nvgFillRect(nvg, bounds.getX(), bounds.getY(), bounds.getWidth(), bounds.getHeight());
             }
@@ -319,24 +299,42 @@ public:
         auto* rawFileName = fileNameString.toRawUTF8();
         auto* rawPath = pathString.toRawUTF8();
 
-        img = ImageFileFormat::loadFrom(imageFile).convertedToFormat(Image::ARGB);
-        imageNeedsReload = true;
+        // Decoding happens in the background, we'll get a change message once the image size is known
+        if (imageAsset)
+            imageAsset->removeChangeListener(this);
+        imageAsset = ImageAssetCache::getInstance()->getAsset(imageFile);
+        imageAsset->addChangeListener(this);
 
         if (auto pic = ptr.get<t_fake_pic>()) {
             pic->x_filename = pd->generateSymbol(rawFileName);
             pic->x_fullname = pd->generateSymbol(rawPath);
-            pic->x_width = img.getWidth();
-            pic->x_height = img.getHeight();
+        }
+
+        imageSizePending = !imageAsset->isLoaded();
+        if (!imageSizePending) {
+            applyImageSize();
+        }
+
+        repaint();
+    }
+
+    void applyImageSize()
+    {
+        auto width = imageAsset->getWidth();
+        auto height = imageAsset->getHeight();
+
+        if (auto pic = ptr.get<t_fake_pic>()) {
+            pic->x_width = width;
+            pic->x_height = height;
 
             if (getValue<bool>(reportSize)) {
                 StackArray<t_atom, 2> coordinates;
-                SETFLOAT(&coordinates[0], img.getWidth());
-                SETFLOAT(&coordinates[1], img.getHeight());
+                SETFLOAT(&coordinates[0], width);
+                SETFLOAT(&coordinates[1], height);
                 outlet_list(pic->x_outlet, pd->generateSymbol("list"), 2, coordinates.data());
             }
         }
 
         object->updateBounds();
-        repaint();
     }
 };
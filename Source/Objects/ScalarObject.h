@@ -17,6 +17,100 @@
 // accidentally passing on mouse scroll events to the viewport.
 // This prevents that with a separation layer.
 
+// Flattened geometry of a [drawpolygon], [drawcurve] or [plot], so we don't have to convert a juce::Path on every frame
+struct ScalarGeometry {
+    struct SubPath {
+        int start;
+        int size;
+        bool closed;
+    };
+
+    HeapArray<Point<float>> points;
+    HeapArray<SubPath> subPaths;
+    NVGcolor fillColour;
+    NVGcolor strokeColour;
+    float strokeWidth = 1.0f;
+    bool hasFill = false;
+    bool hasStroke = false;
+
+    // Geometry with the same style can be rendered in the same batch
+    hash32 styleHash = 0;
+
+    // Copy of the fields and canvas mapping this geometry was built from
+    // We compare the actual values instead of a hash, so a hash collision can't leave the geometry outdated
+    HeapArray<uint8> inputs;
+
+    void update(Path const& path, Colour fill, Colour stroke, float width, bool closeSubPaths)
+    {
+        points.clear();
+        subPaths.clear();
+
+        PathFlatteningIterator it(path, AffineTransform(), PathFlatteningIterator::defaultTolerance / 4.0f);
+        int subPathIndex = -1;
+        while (it.next()) {
+            if (it.subPathIndex != subPathIndex) {
+                subPathIndex = it.subPathIndex;
+                subPaths.add({ static_cast<int>(points.size()), 0, closeSubPaths });
+                points.add({ it.x1, it.y1 });
+            }
+            points.add({ it.x2, it.y2 });
+
+            if (it.closesSubPath)
+                subPaths[subPaths.size() - 1].closed = true;
+        }
+
+        for (int i = 0; i < subPaths.size(); i++) {
+            auto end = i + 1 < subPaths.size() ? subPaths[i + 1].start : static_cast<int>(points.size());
+            subPaths[i].size = end - subPaths[i].start;
+        }
+
+        fillColour = NVGComponent::convertColour(fill);
+        strokeColour = NVGComponent::convertColour(stroke);
+        strokeWidth = width;
+        hasFill = !fill.isTransparent();
+        hasStroke = !stroke.isTransparent() && width > 0.0f;
+
+        auto fillARGB = fill.getARGB();
+        auto strokeARGB = stroke.getARGB();
+        styleHash = hash(&fillARGB, sizeof(fillARGB));
+        styleHash = hash(&strokeARGB, sizeof(strokeARGB), styleHash);
+        styleHash = hash(&strokeWidth, sizeof(strokeWidth), styleHash);
+    }
+
+    void clear()
+    {
+        points.clear();
+        subPaths.clear();
+        inputs.clear();
+    }
+
+    void addSubPaths(NVGcontext* nvg) const
+    {
+        for (auto const& subPath : subPaths) {
+            auto const* subPathPoints = points.data() + subPath.start;
+            nvgMoveTo(nvg, subPathPoints[0].x, subPathPoints[0].y);
+            for (int i = 1; i < subPath.size; i++) {
+                nvgLineTo(nvg, subPathPoints[i].x, subPathPoints[i].y);
+            }
+            if (subPath.closed)
+                nvgClosePath(nvg);
+        }
+    }
+
+    void fillAndStroke(NVGcontext* nvg) const
+    {
+        if (hasFill) {
+            nvgFillColor(nvg, fillColour);
+            nvgFill(nvg);
+        }
+        if (hasStroke) {
+            nvgStrokeWidth(nvg, strokeWidth);
+            nvgStrokeColor(nvg, strokeColour);
+            nvgStroke(nvg);
+        }
+    }
+};
+
 class DrawableTemplate : public pd::MessageListener
     , public AsyncUpdater
     , public NVGComponent {
@@ -30,6 +124,7 @@ public:
     t_template* parentTempl;
     pd::WeakReference scalar;
     bool mouseWasDown = false;
+    HeapArray<uint8> inputs;
 
     DrawableTemplate(t_scalar* object, t_word* scalarData, t_template* scalarTemplate, t_template* parentTemplate, Canvas* cnv, t_float x, t_float y)
         : NVGComponent(reinterpret_cast<Component*>(this)) // TODO: clean this up
@@ -65,6 +160,28 @@ public:
 
     virtual void update() = 0;
 
+    // Copies the scalar's fields and the canvas mapping, geometry only needs to be rebuilt when these change
+    void getInputs(HeapArray<uint8>& inputs)
+    {
+        inputs.clear();
+        if (data && templ)
+            appendInputs(inputs, data, templ->t_n * sizeof(t_word));
+
+        float zoom = 1.0f;
+        if (auto glist = canvas->patch.getPointer()) {
+            zoom = glist->gl_isgraph ? glist_getzoom(glist.get()) : 1.0f;
+        }
+
+        float mapping[] = { baseX, baseY, xToPixels(0), xToPixels(1), yToPixels(0), yToPixels(1), static_cast<float>(canvas->canvasOrigin.x), static_cast<float>(canvas->canvasOrigin.y), zoom };
+        appendInputs(inputs, mapping, sizeof(mapping));
+    }
+
+    static void appendInputs(HeapArray<uint8>& inputs, void const* data, size_t size)
+    {
+        auto const* bytes = static_cast<uint8 const*>(data);
+        inputs.insert(inputs.end(), bytes, bytes + size);
+    }
+
     t_float xToPixels(t_float xval)
     {
         if (auto x = canvas->patch.getPointer()) {
@@ -145,6 +262,7 @@ class DrawableCurve final : public DrawableTemplate
 
     t_fake_curve* object;
     GlobalMouseListener globalMouseListener;
+    ScalarGeometry geometry;
     bool closed;
 
 public:
@@ -217,23 +335,24 @@ public:
 
     void render(NVGcontext* nvg) override
     {
-        Path p = getPath();
-        setJUCEPath(nvg, p);
+        nvgBeginPath(nvg);
+        geometry.addSubPaths(nvg);
+        geometry.fillAndStroke(nvg);
+    }
 
-        // TODO: could be more optimised
-        if (closed) {
-            nvgClosePath(nvg);
+    hash32 getBatchStyle() override
+    {
+        return geometry.styleHash;
+    }
 
-            nvgFillColor(nvg, convertColour(getFill().colour));
-            nvgFill(nvg);
-            nvgStrokeWidth(nvg, getStrokeType().getStrokeThickness());
-            nvgStrokeColor(nvg, convertColour(getStrokeFill().colour));
-            nvgStroke(nvg);
-        } else {
-            nvgStrokeWidth(nvg, getStrokeType().getStrokeThickness());
-            nvgStrokeColor(nvg, convertColour(getStrokeFill().colour));
-            nvgStroke(nvg);
-        }
+    void addToBatch(NVGcontext* nvg) override
+    {
+        geometry.addSubPaths(nvg);
+    }
+
+    void finishBatch(NVGcontext* nvg) override
+    {
+        geometry.fillAndStroke(nvg);
     }
 
     void update() override
@@ -256,9 +375,19 @@ public:
 
         if (!fielddesc_getfloat(&x->x_vis, templ, data, 0)) {
             setPath(Path());
+            geometry.clear();
             return;
         }
 
+        // Constant coordinates, colours and width live in the curve's own field descriptors, not in the scalar
+        getInputs(inputs);
+        appendInputs(inputs, &x->x_flags, offsetof(t_fake_curve, x_vec) - offsetof(t_fake_curve, x_flags));
+        appendInputs(inputs, x->x_vec, static_cast<size_t>(std::max(x->x_npoints, 0)) * 2 * sizeof(t_fake_fielddesc));
+        if (inputs.vector() == geometry.inputs.vector())
+            return;
+
+        geometry.inputs = inputs;
+
         if (n > 1) {
             int flags = x->x_flags;
             closed = flags & CLOSED;
@@ -343,6 +472,7 @@ public:
             }
 
             setPath(toDraw);
+            geometry.update(toDraw, getFill().colour, getStrokeFill().colour, getStrokeType().getStrokeThickness(), closed);
         } else {
             post("warning: curves need at least two points to be graphed");
         }
@@ -492,6 +622,7 @@ class DrawablePlot final : public DrawableTemplate
     t_fake_curve* object;
     GlobalMouseListener globalMouseListener;
     OwnedArray<Component> subplots;
+    ScalarGeometry geometry;
 
 public:
     DrawablePlot(t_scalar* s, t_gobj* obj, t_word* data, t_template* templ, Canvas* cnv, int x, int y, t_template* parent = nullptr)
@@ -570,14 +701,24 @@ public:
 
     void render(NVGcontext* nvg) override
     {
-        Path p = getPath();
-        setJUCEPath(nvg, p);
-
-        nvgFillColor(nvg, convertColour(getFill().colour));
-        nvgFill(nvg);
-        nvgStrokeWidth(nvg, getStrokeType().getStrokeThickness());
-        nvgStrokeColor(nvg, convertColour(getStrokeFill().colour));
-        nvgStroke(nvg);
+        nvgBeginPath(nvg);
+        geometry.addSubPaths(nvg);
+        geometry.fillAndStroke(nvg);
+    }
+
+    hash32 getBatchStyle() override
+    {
+        return geometry.styleHash;
+    }
+
+    void addToBatch(NVGcontext* nvg) override
+    {
+        geometry.addSubPaths(nvg);
+    }
+
+    void finishBatch(NVGcontext* nvg) override
+    {
+        geometry.fillAndStroke(nvg);
     }
 
     static int readOwnerTemplate(t_fake_plot* x,
@@ -648,6 +789,7 @@ public:
 
         if (!fielddesc_getfloat(&x->x_vis, templ, data, 0)) {
             setPath(Path());
+            geometry.clear();
             return;
         }
 
@@ -671,6 +813,15 @@ public:
         nelem = array->a_n;
         elem = (char*)array->a_vec;
 
+        // Subplots listen to redraw messages themselves, so nothing needs to happen if our fields and elements didn't change
+        getInputs(inputs);
+        appendInputs(inputs, &x->x_outlinecolor, offsetof(t_fake_plot, x_edit) + sizeof(t_fake_fielddesc) - offsetof(t_fake_plot, x_outlinecolor));
+        appendInputs(inputs, elem, nelem * elemsize);
+        if (inputs.vector() == geometry.inputs.vector())
+            return;
+
+        geometry.inputs = inputs;
+
         if (glist->gl_isgraph)
             linewidth *= glist_getzoom(glist);
 
@@ -918,6 +1069,7 @@ public:
         }
 
         setPath(toDraw);
+        geometry.update(toDraw, getFill().colour, getStrokeFill().colour, getStrokeType().getStrokeThickness(), false);
         updateSubplots();
     }
 
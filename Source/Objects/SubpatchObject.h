@@ -13,6 +13,7 @@ class SubpatchObject final : public TextBase
 public:
     SubpatchObject(pd::WeakReference obj, Object* object)
         : TextBase(obj, object)
+        , SettingsFileListener({ "hvcc_mode" })
         , subpatch(new pd::Patch(obj, cnv->pd, false))
     {
         objectParameters.addParamBool("Is graph", cGeneral, &isGraphChild, { "No", "Yes" });
@@ -0,0 +1,497 @@
+/*
+ // Copyright (c) 2021-2024 Timothy Schoen.
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include "Utility/Containers.h"
+
+extern "C" {
+#include <m_pd.h>
+#include <m_imp.h>
+#include <g_canvas.h>
+
+t_glist* clone_get_instance(t_gobj*, int);
+int clone_get_n(t_gobj*);
+}
+
+namespace pd {
+
+// Applies the changes made to an abstraction to all other instances of it, instead of recreating every instance like canvas_reload does
+// Objects that didn't change keep their state, and we only rebuild the DSP graph when a signal object or signal connection changed
+// Objects added to the end of the patch are created, and objects removed from the end are deleted
+// If the changes can't be mapped onto the existing instances, reloadChanges returns false and the caller should do a full reload
+struct AbstractionReloader {
+
+    static bool reloadChanges(File const& changedPatch, String const& previousContent, t_glist* except)
+    {
+        auto oldContents = PatchContents::parse(previousContent);
+        auto newContents = PatchContents::parse(changedPatch.loadFileAsString());
+        if (!oldContents.canBeUpdatedTo(newContents))
+            return false;
+
+        auto* dir = gensym(changedPatch.getParentDirectory().getFullPathName().replace("\\", "/").toRawUTF8());
+        auto* file = gensym(changedPatch.getFileName().toRawUTF8());
+
+        SmallArray<t_glist*> instances;
+        for (auto* cnv = pd_getcanvaslist(); cnv; cnv = cnv->gl_next) {
+            if (cnv != except)
+                findInstances(cnv, file, dir, except, instances);
+        }
+
+        // Check all instances before touching any of them, so we never end up with half-updated abstractions
+        for (auto* instance : instances) {
+            if (!oldContents.matches(instance))
+                return false;
+        }
+
+        // Creating and deleting objects updates DSP for every signal object, so we suspend DSP and rebuild the graph once at the end
+        auto const changesObjects = oldContents.changesObjects(newContents);
+        auto const dspState = changesObjects ? canvas_suspend_dsp() : 0;
+
+        bool needsDSPUpdate = false;
+        for (auto* instance : instances) {
+            needsDSPUpdate = applyChanges(instance, oldContents, newContents) || needsDSPUpdate;
+        }
+
+        if (changesObjects)
+            canvas_resume_dsp(dspState);
+        else if (needsDSPUpdate)
+            canvas_update_dsp();
+
+        return true;
+    }
+
+private:
+    struct Entry {
+        t_symbol* type = nullptr; // Selector that created the object: obj, msg, text, floatatom, scalar, restore, etc.
+        int x = 0, y = 0;
+        int width = 0;
+        SmallArray<t_atom> content; // Creation arguments, without the position and width
+        String text;                // Content as text, for comparing entries
+        String savedData;           // Data saved with the object on "#A" lines
+        String subpatch;            // Content of subpatches, without the position
+
+        void setContent(t_atom* atoms, int numAtoms)
+        {
+            // Objects, messages, comments and subpatches can have their width saved as ", f <width>" after the content
+            if (hasTextWidth() && numAtoms >= 3 && atoms[numAtoms - 3].a_type == A_COMMA && atom_getsymbol(atoms + numAtoms - 2) == gensym("f")) {
+                width = atom_getfloat(atoms + numAtoms - 1);
+                numAtoms -= 3;
+            }
+
+            content.append(atoms, atoms + numAtoms);
+            text = toString(atoms, numAtoms);
+        }
+
+        // Atom boxes store their width in te_width too, but it's part of their content
+        bool hasTextWidth() const
+        {
+            return type == gensym("obj") || type == gensym("msg") || type == gensym("text") || type == gensym("restore");
+        }
+    };
+
+    struct Connection {
+        int source, outlet, sink, inlet;
+
+        bool operator==(Connection const& other) const
+        {
+            return source == other.source && outlet == other.outlet && sink == other.sink && inlet == other.inlet;
+        }
+    };
+
+    // Top-level objects and connections of a patch file
+    struct PatchContents {
+        HeapArray<Entry> objects;
+        SmallArray<Connection> connections;
+        StringArray properties;
+        bool isValid = false;
+
+        static PatchContents parse(String const& content)
+        {
+            PatchContents contents;
+            if (content.isEmpty())
+                return contents;
+
+            auto* buf = binbuf_new();
+            binbuf_text(buf, content.toRawUTF8(), content.getNumBytesAsUTF8());
+
+            auto* atoms = binbuf_getvec(buf);
+            auto numAtoms = binbuf_getnatom(buf);
+
+            int depth = 0;
+            int messageStart = 0;
+            int subpatchStart = 0;
+            for (int i = 0; i < numAtoms; i++) {
+                if (atoms[i].a_type != A_SEMI)
+                    continue;
+
+                auto* message = atoms + messageStart;
+                auto start = messageStart;
+                auto argc = i - messageStart;
+                messageStart = i + 1;
+
+                if (argc < 1 || message[0].a_type != A_SYMBOL)
+                    continue;
+
+                auto* target = atom_getsymbol(message);
+                auto* selector = argc > 1 ? atom_getsymbol(message + 1) : &s_;
+
+                if (target == gensym("#N") && selector == gensym("canvas")) {
+                    if (depth == 0 && argc == 7)
+                        contents.properties.add("font " + String(atom_getfloat(message + 6)));
+                    else if (depth == 1)
+                        subpatchStart = start;
+                    depth++;
+                    continue;
+                }
+
+                if (target == gensym("#X") && selector == gensym("restore")) {
+                    depth--;
+                    if (depth == 1 && argc >= 4) {
+                        Entry entry;
+                        entry.type = selector;
+                        entry.x = atom_getfloat(message + 2);
+                        entry.y = atom_getfloat(message + 3);
+                        entry.setContent(message + 4, argc - 4);
+                        entry.subpatch = toString(atoms + subpatchStart, start - subpatchStart);
+                        contents.objects.add(entry);
+                    }
+                    continue;
+                }
+
+                // Everything inside subpatches is compared as a whole when the subpatch is restored
+                if (depth != 1)
+                    continue;
+
+                if (target == gensym("#X") && selector == gensym("connect") && argc == 6) {
+                    contents.connections.add({ static_cast<int>(atom_getfloat(message + 2)), static_cast<int>(atom_getfloat(message + 3)), static_cast<int>(atom_getfloat(message + 4)), static_cast<int>(atom_getfloat(message + 5)) });
+                } else if (target == gensym("#X") && isObjectSelector(selector)) {
+                    Entry entry;
+                    entry.type = selector;
+
+                    // Scalars don't have a position, their content is compared as a whole
+                    auto positionSize = selector == gensym("scalar") ? 0 : 2;
+                    if (argc < positionSize + 2)
+                        continue;
+
+                    entry.x = positionSize ? atom_getfloat(message + 2) : 0;
+                    entry.y = positionSize ? atom_getfloat(message + 3) : 0;
+
+                    entry.setContent(message + 2 + positionSize, argc - 2 - positionSize);
+                    contents.objects.add(entry);
+                } else if (target == gensym("#A") && contents.objects.not_empty()) {
+                    contents.objects.back().savedData += toString(message, argc);
+                } else {
+                    contents.properties.add(toString(message, argc));
+                }
+            }
+
+            binbuf_free(buf);
+
+            contents.isValid = depth == 1;
+            return contents;
+        }
+
+        // Checks if the changes between these contents and the new contents can be applied to existing instances
+        bool canBeUpdatedTo(PatchContents const& newContents) const
+        {
+            if (!isValid || !newContents.isValid || properties != newContents.properties)
+                return false;
+
+            // Objects added to the end are created from their entry, which doesn't work for subpatches and objects with saved data
+            for (int i = objects.size(); i < newContents.objects.size(); i++) {
+                auto& newEntry = newContents.objects[i];
+                if (newEntry.type == gensym("restore") || newEntry.type == gensym("scalar") || newEntry.savedData.isNotEmpty())
+                    return false;
+            }
+
+            for (int i = 0; i < std::min(objects.size(), newContents.objects.size()); i++) {
+                auto& oldEntry = objects[i];
+                auto& newEntry = newContents.objects[i];
+                if (oldEntry.type != newEntry.type || oldEntry.savedData != newEntry.savedData || oldEntry.subpatch != newEntry.subpatch)
+                    return false;
+
+                // Objects can be recreated and messages and comments can be updated in place, everything else needs a full reload
+                if (oldEntry.text != newEntry.text && oldEntry.type != gensym("obj") && oldEntry.type != gensym("msg") && oldEntry.type != gensym("text"))
+                    return false;
+            }
+
+            return true;
+        }
+
+        // Checks if applying the changes creates or deletes any objects
+        bool changesObjects(PatchContents const& newContents) const
+        {
+            if (objects.size() != newContents.objects.size())
+                return true;
+
+            for (int i = 0; i < objects.size(); i++) {
+                if (objects[i].text != newContents.objects[i].text && newContents.objects[i].type == gensym("obj"))
+                    return true;
+            }
+
+            return false;
+        }
+
+        // Checks if an instance still matches the content it was loaded from
+        bool matches(t_glist* instance) const
+        {
+            int index = 0;
+            for (auto* y = instance->gl_list; y; y = y->g_next, index++) {
+                if (index >= objects.size())
+                    return false;
+
+                auto& entry = objects[index];
+                if (entry.type == gensym("restore")) {
+                    if (pd_class(&y->g_pd) != canvas_class)
+                        return false;
+                    continue;
+                }
+                if (entry.type == gensym("scalar")) {
+                    if (pd_class(&y->g_pd) != scalar_class)
+                        return false;
+                    continue;
+                }
+
+                auto* object = pd_checkobject(&y->g_pd);
+                if (!object || object->te_type != getTextType(entry.type))
+                    return false;
+
+                if (object->te_type != T_ATOM && toString(binbuf_getvec(object->te_binbuf), binbuf_getnatom(object->te_binbuf)) != entry.text)
+                    return false;
+            }
+
+            return index == objects.size();
+        }
+    };
+
+    static bool isObjectSelector(t_symbol* selector)
+    {
+        return selector == gensym("obj") || selector == gensym("msg") || selector == gensym("text") || selector == gensym("floatatom") || selector == gensym("symbolatom") || selector == gensym("listbox") || selector == gensym("scalar");
+    }
+
+    static int getTextType(t_symbol* selector)
+    {
+        if (selector == gensym("msg"))
+            return T_MESSAGE;
+        if (selector == gensym("text"))
+            return T_TEXT;
+        if (selector == gensym("obj"))
+            return T_OBJECT;
+
+        return T_ATOM;
+    }
+
+    // Converts atoms to text the same way Pd does when it creates objects from a file, so escaped commas and dollars compare equal
+    static String toString(t_atom const* atoms, int numAtoms)
+    {
+        auto* buf = binbuf_new();
+        binbuf_restore(buf, numAtoms, const_cast<t_atom*>(atoms));
+
+        char* text = nullptr;
+        int length = 0;
+        binbuf_gettext(buf, &text, &length);
+        auto result = String::fromUTF8(text, length);
+
+        freebytes(text, length);
+        binbuf_free(buf);
+        return result;
+    }
+
+    static void findInstances(t_glist* glist, t_symbol* file, t_symbol* dir, t_glist* except, SmallArray<t_glist*>& instances)
+    {
+        auto checkCanvas = [&](t_glist* cnv) {
+            if (cnv == except)
+                return;
+
+            if (canvas_isabstraction(cnv) && cnv->gl_name == file && canvas_getdir(cnv) == dir)
+                instances.add(cnv);
+            else
+                findInstances(cnv, file, dir, except, instances);
+        };
+
+        for (auto* y = glist->gl_list; y; y = y->g_next) {
+            if (pd_class(&y->g_pd) == canvas_class) {
+                checkCanvas(reinterpret_cast<t_glist*>(y));
+            } else if (pd_class(&y->g_pd) == clone_class) {
+                for (int i = 0; i < clone_get_n(y); i++) {
+                    checkCanvas(clone_get_instance(y, i));
+                }
+            }
+        }
+    }
+
+    // Returns true if the DSP graph needs to be rebuilt
+    static bool applyChanges(t_glist* instance, PatchContents const& oldContents, PatchContents const& newContents)
+    {
+        SmallArray<t_gobj*> objects;
+        for (auto* y = instance->gl_list; y; y = y->g_next) {
+            objects.add(y);
+        }
+
+        auto getObject = [&objects](int index) -> t_object* {
+            return isPositiveAndBelow(index, objects.size()) ? pd_checkobject(&objects[index]->g_pd) : nullptr;
+        };
+
+        auto const numCommon = std::min(oldContents.objects.size(), newContents.objects.size());
+
+        // Recreated objects lose all their connections, so those will all be restored afterwards
+        SmallArray<int> recreated;
+        for (int i = 0; i < numCommon; i++) {
+            if (oldContents.objects[i].text != newContents.objects[i].text && newContents.objects[i].type == gensym("obj"))
+                recreated.add(i);
+        }
+
+        auto touchesRecreated = [&recreated](Connection const& connection) {
+            return recreated.contains(connection.source) || recreated.contains(connection.sink);
+        };
+
+        bool needsDSPUpdate = false;
+        for (auto& connection : oldContents.connections) {
+            if (touchesRecreated(connection) || newContents.connections.contains(connection))
+                continue;
+
+            auto* source = getObject(connection.source);
+            auto* sink = getObject(connection.sink);
+            if (source && sink && canvas_isconnected(instance, source, connection.outlet, sink, connection.inlet)) {
+                needsDSPUpdate = needsDSPUpdate || obj_issignaloutlet(source, connection.outlet);
+                obj_disconnect(source, connection.outlet, sink, connection.inlet);
+            }
+        }
+
+        // Objects removed from the end of the patch, deleting them also removes their remaining connections
+        while (objects.size() > numCommon) {
+            needsDSPUpdate = zgetfn(&objects.back()->g_pd, gensym("dsp")) != nullptr || needsDSPUpdate;
+            glist_delete(instance, objects.back());
+            objects.pop_back();
+        }
+
+        for (int i = 0; i < numCommon; i++) {
+            auto& entry = newContents.objects[i];
+            if (recreated.contains(i)) {
+                needsDSPUpdate = recreateObject(instance, objects, i, entry) || needsDSPUpdate;
+                continue;
+            }
+
+            auto* object = getObject(i);
+            if (!object)
+                continue;
+
+            if (oldContents.objects[i].text != entry.text) {
+                binbuf_clear(object->te_binbuf);
+                binbuf_restore(object->te_binbuf, static_cast<int>(entry.content.size()), const_cast<t_atom*>(entry.content.data()));
+            }
+
+            object->te_xpix = entry.x;
+            object->te_ypix = entry.y;
+            if (entry.hasTextWidth())
+                object->te_width = entry.width;
+        }
+
+        for (int i = numCommon; i < newContents.objects.size(); i++) {
+            needsDSPUpdate = createObject(instance, objects, newContents.objects[i]) || needsDSPUpdate;
+        }
+
+        for (auto& connection : newContents.connections) {
+            if (!touchesRecreated(connection) && oldContents.connections.contains(connection))
+                continue;
+
+            auto* source = getObject(connection.source);
+            auto* sink = getObject(connection.sink);
+            if (source && sink && connection.outlet < obj_noutlets(source) && connection.inlet < obj_ninlets(sink) && !canvas_isconnected(instance, source, connection.outlet, sink, connection.inlet)) {
+                obj_connect(source, connection.outlet, sink, connection.inlet);
+                needsDSPUpdate = needsDSPUpdate || obj_issignaloutlet(source, connection.outlet);
+            }
+        }
+
+        return needsDSPUpdate;
+    }
+
+    // Creates an object from its entry at the end of the object list, the same way Pd does when it loads the patch
+    // Returns true if the new object does signal processing
+    static bool createObject(t_glist* instance, SmallArray<t_gobj*>& objects, Entry const& entry)
+    {
+        SmallArray<t_atom> args(entry.content.size() + 2);
+        SETFLOAT(args.data(), entry.x);
+        SETFLOAT(args.data() + 1, entry.y);
+        std::copy(entry.content.begin(), entry.content.end(), args.begin() + 2);
+
+        // Set the canvas as current so $0 is resolved correctly
+        canvas_setcurrent(instance);
+        pd_typedmess(&instance->gl_pd, entry.type, static_cast<int>(args.size()), args.data());
+        canvas_unsetcurrent(instance);
+
+        auto* newObject = instance->gl_list;
+        while (newObject && newObject->g_next)
+            newObject = newObject->g_next;
+
+        // Keep the object list in sync with the canvas, even if the object couldn't be created
+        if (!newObject || (objects.not_empty() && newObject == objects.back()))
+            return false;
+
+        objects.add(newObject);
+
+        if (auto* object = pd_checkobject(&newObject->g_pd); object && entry.hasTextWidth())
+            object->te_width = entry.width;
+
+        if (pd_class(&newObject->g_pd) == canvas_class)
+            canvas_loadbang(reinterpret_cast<t_canvas*>(newObject));
+
+        return zgetfn(&newObject->g_pd, gensym("dsp")) != nullptr;
+    }
+
+    // Replaces an object with one created from the new content, at the same index in the object list
+    // Returns true if the new object does signal processing
+    static bool recreateObject(t_glist* instance, SmallArray<t_gobj*>& objects, int index, Entry const& entry)
+    {
+        SmallArray<t_atom> args(entry.content.size() + 2);
+        SETFLOAT(args.data(), entry.x);
+        SETFLOAT(args.data() + 1, entry.y);
+        std::copy(entry.content.begin(), entry.content.end(), args.begin() + 2);
+
+        // This adds the new object to the end of the list, and sets the canvas as current so $0 is resolved correctly
+        canvas_obj(instance, gensym("obj"), static_cast<int>(args.size()), args.data());
+
+        auto* newObject = instance->gl_list;
+        while (newObject->g_next)
+            newObject = newObject->g_next;
+
+        // Removing the old object also removes its connections, DSP is suspended while changes are applied
+        glist_delete(instance, objects[index]);
+
+        // Move the new object into the place of the old one, so connection indices stay valid
+        if (instance->gl_list == newObject) {
+            instance->gl_list = nullptr;
+        } else {
+            for (auto* y = instance->gl_list; y; y = y->g_next) {
+                if (y->g_next == newObject) {
+                    y->g_next = nullptr;
+                    break;
+                }
+            }
+        }
+
+        if (index == 0) {
+            newObject->g_next = instance->gl_list;
+            instance->gl_list = newObject;
+        } else {
+            newObject->g_next = objects[index - 1]->g_next;
+            objects[index - 1]->g_next = newObject;
+        }
+
+        objects[index] = newObject;
+
+        if (auto* object = pd_checkobject(&newObject->g_pd))
+            object->te_width = entry.width;
+
+        if (pd_class(&newObject->g_pd) == canvas_class)
+            canvas_loadbang(reinterpret_cast<t_canvas*>(newObject));
+
+        return zgetfn(&newObject->g_pd, gensym("dsp")) != nullptr;
+    }
+};
+
+}
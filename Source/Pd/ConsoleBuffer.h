@@ -0,0 +1,206 @@
+/*
+ // Copyright (c) 2021-2024 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include "Utility/Containers.h"
+#include "Utility/CachedStringWidth.h"
+
+namespace pd {
+
+// Fixed-size, lock-free single producer, single consumer queue for console messages posted from Pd to the message thread
+// The producer is Pd's print hook, which only runs on the thread that currently holds Pd's lock. Other loggers go through the message thread instead
+// Message text is copied into a byte arena that wraps around, so posting never allocates or blocks on the message thread
+// When Pd prints faster than the message thread can keep up, messages are dropped and counted instead of growing the queue
+class ConsoleMessageQueue {
+public:
+    static constexpr int maxRecords = 16384;
+    static constexpr int arenaSize = 1 << 20;
+    static constexpr int maxMessageLength = 4096;
+
+    ConsoleMessageQueue()
+    {
+        records.resize(maxRecords);
+        arena.resize(arenaSize);
+    }
+
+    void push(void* object, int type, char const* text, int length)
+    {
+        // Don't cut a UTF-8 sequence in half: step back to the start of the code point at the cut
+        if (length > maxMessageLength) {
+            length = maxMessageLength;
+            while (length > 0 && (static_cast<uint8>(text[length]) & 0xC0) == 0x80)
+                length--;
+        }
+
+        auto write = writeIndex.load(std::memory_order_relaxed);
+        if (write - readIndex.load(std::memory_order_acquire) >= maxRecords) {
+            numDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // Keep the text contiguous: if it doesn't fit before the end of the arena, start at the beginning
+        auto start = arenaWriteIndex;
+        auto offset = static_cast<int>(start % arenaSize);
+        if (offset + length > arenaSize) {
+            start += arenaSize - offset;
+            offset = 0;
+        }
+
+        auto end = start + length;
+        if (end - arenaReadIndex.load(std::memory_order_acquire) > arenaSize) {
+            numDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        std::copy(text, text + length, arena.data() + offset);
+        records[write % maxRecords] = { object, type, offset, length, end };
+        arenaWriteIndex = end;
+
+        writeIndex.store(write + 1, std::memory_order_release);
+    }
+
+    // Calls the callback for every queued message, should only be called from the message thread
+    template<typename Callback>
+    int popAll(Callback&& callback)
+    {
+        auto read = readIndex.load(std::memory_order_relaxed);
+        auto write = writeIndex.load(std::memory_order_acquire);
+
+        int numPopped = 0;
+        for (; read != write; read++, numPopped++) {
+            auto const& record = records[read % maxRecords];
+            callback(record.object, record.type, arena.data() + record.offset, record.length);
+
+            arenaReadIndex.store(record.arenaEnd, std::memory_order_release);
+            readIndex.store(read + 1, std::memory_order_release);
+        }
+
+        return numPopped;
+    }
+
+    int getAndResetNumDropped()
+    {
+        return numDropped.exchange(0, std::memory_order_relaxed);
+    }
+
+private:
+    struct Record {
+        void* object = nullptr;
+        int type = 0;
+        int offset = 0;
+        int length = 0;
+        uint64 arenaEnd = 0;
+    };
+
+    HeapArray<Record> records;
+    HeapArray<char> arena;
+
+    std::atomic<uint64> writeIndex = 0;
+    std::atomic<uint64> readIndex = 0;
+    uint64 arenaWriteIndex = 0;
+    std::atomic<uint64> arenaReadIndex = 0;
+
+    std::atomic<int> numDropped = 0;
+};
+
+// Console messages shown in the console panel, stored in a ring with a configurable capacity
+// Messages are addressed by sequence numbers that keep counting up, so views can keep track of what they've already seen
+// Clearing the console only hides older messages, so they can be restored as long as they are still in the ring
+class ConsoleMessageStore {
+public:
+    struct Message {
+        void* object = nullptr;
+        String text;
+        int type = 0; // 0 for messages, 1 for warnings and errors
+        int repeats = 1;
+        int width = 0; // width of the text in pixels, including margins
+        int numLines = 1;
+    };
+
+    static constexpr int defaultCapacity = 100000;
+
+    ConsoleMessageStore()
+    {
+        messages.resize(capacity);
+    }
+
+    void setCapacity(int newCapacity)
+    {
+        newCapacity = std::max(newCapacity, 100);
+        if (newCapacity == capacity)
+            return;
+
+        // Keep the most recent messages that fit in the new capacity
+        HeapArray<Message> resized;
+        resized.resize(newCapacity);
+
+        auto newStart = std::max(start, end - std::min<uint64>(end, newCapacity));
+        for (auto seq = newStart; seq < end; seq++) {
+            resized[seq % newCapacity] = std::move(messages[seq % capacity]);
+        }
+
+        messages = std::move(resized);
+        capacity = newCapacity;
+        start = newStart;
+    }
+
+    void add(void* object, String const& text, int type)
+    {
+        // Collapse repeated messages into a single message with a counter
+        if (end > getStart()) {
+            auto& last = messages[(end - 1) % capacity];
+            if (last.object == object && last.type == type && last.text == text) {
+                last.repeats++;
+                return;
+            }
+        }
+
+        auto& message = messages[end % capacity];
+        message.object = object;
+        message.text = text;
+        message.type = type;
+        message.repeats = 1;
+        message.width = CachedStringWidth<14>::calculateStringWidth(text) + 40;
+        message.numLines = 1;
+        for (auto c = text.getCharPointer(); !c.isEmpty(); ++c) {
+            if (*c == '\n')
+                message.numLines++;
+        }
+
+        end++;
+        if (end - start > static_cast<uint64>(capacity))
+            start = end - capacity;
+    }
+
+    Message const& operator[](uint64 seq) const
+    {
+        jassert(seq >= start && seq < end);
+        return messages[seq % capacity];
+    }
+
+    // Sequence number of the first message that is shown
+    uint64 getStart() const { return std::max(start, clearedUpTo); }
+
+    // Sequence number after the last message
+    uint64 getEnd() const { return end; }
+
+    int size() const { return static_cast<int>(end - getStart()); }
+
+    void clear() { clearedUpTo = end; }
+
+    void restore() { clearedUpTo = 0; }
+
+private:
+    HeapArray<Message> messages;
+    int capacity = defaultCapacity;
+
+    uint64 start = 0;
+    uint64 end = 0;
+    uint64 clearedUpTo = 0;
+};
+
+}
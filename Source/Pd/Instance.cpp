@@ -166,12 +166,12 @@ void Instance::initialisePd(String& pdlua_version)
     libpd_set_instance(static_cast<t_pdinstance*>(instance));
 
     setup_lock(
-        static_cast<void const*>(&audioLock),
-        [](void* lock) {
-            static_cast<CriticalSection*>(lock)->enter();
+        static_cast<void const*>(this),
+        [](void* instance) {
+            static_cast<Instance*>(instance)->lockAudioThread();
         },
-        [](void* lock) {
-            static_cast<CriticalSection*>(lock)->exit();
+        [](void* instance) {
+            static_cast<Instance*>(instance)->unlockAudioThread();
         });
 
     setup_weakreferences(
@@ -786,16 +786,11 @@ void Instance::logWarning(String const& warning)
     consoleHandler.logWarning(nullptr, warning);
 }
 
-std::deque<std::tuple<void*, String, int, int, int>>& Instance::getConsoleMessages()
+ConsoleMessageStore& Instance::getConsoleMessages()
 {
     return consoleHandler.consoleMessages;
 }
 
-std::deque<std::tuple<void*, String, int, int, int>>& Instance::getConsoleHistory()
-{
-    return consoleHandler.consoleHistory;
-}
-
 void Instance::createPanel(int type, char const* snd, char const* location, char const* callbackName, int openMode)
 {
 #if ENABLE_TESTING
@@ -886,13 +881,87 @@ bool Instance::loadLibrary(String const& libraryToLoad)
 void Instance::lockAudioThread()
 {
     audioLock.enter();
+    if (audioLockDepth++ == 0)
+        audioLockOwner = Thread::getCurrentThreadId();
 }
 
 void Instance::unlockAudioThread()
 {
+    if (--audioLockDepth == 0)
+        audioLockOwner = nullptr;
     audioLock.exit();
 }
 
+bool Instance::isAudioLockHeldByCurrentThread() const
+{
+    return audioLockOwner.load() == Thread::getCurrentThreadId();
+}
+
+void Instance::startDSPRebuild()
+{
+    if (dspRebuildDepth++ > 0)
+        return;
+
+    // Let the audio thread fade out at the end of a block before we take the lock and stall it
+    // If this thread is already holding the lock, the audio thread can't get there, so we rebuild without waiting
+    auto const audioIsRunning = Time::getMillisecondCounter() - lastAudioBlockTime.load() < 100;
+    if (audioIsRunning && !isAudioLockHeldByCurrentThread()) {
+        dspFadeOutRequested = true;
+
+        auto const waitStart = Time::getMillisecondCounter();
+        while (!dspFadedOut.load() && Time::getMillisecondCounter() - waitStart < 50) {
+            Thread::sleep(1);
+        }
+    }
+
+    lockAudioThread();
+    setThis();
+
+    // Pd will only rebuild the DSP chain once, when we resume it
+    dspSuspendState = canvas_suspend_dsp();
+}
+
+void Instance::finishDSPRebuild()
+{
+    if (--dspRebuildDepth > 0)
+        return;
+
+    setThis();
+    canvas_resume_dsp(dspSuspendState);
+    unlockAudioThread();
+
+    dspFadeOutRequested = false;
+}
+
+void Instance::applyDSPRebuildFade(float* samples, int const numChannels, int const blockSize)
+{
+    // Fade over a few Pd blocks, so the ramp stays inaudible at small block sizes
+    constexpr float fadeStep = 0.25f;
+
+    auto const targetGain = dspFadeOutRequested.load() ? 0.0f : 1.0f;
+    if (approximatelyEqual(dspFadeGain, targetGain)) {
+        if (targetGain == 0.0f) {
+            FloatVectorOperations::clear(samples, numChannels * blockSize);
+            dspFadedOut = true;
+        }
+        return;
+    }
+
+    auto const startGain = dspFadeGain;
+    auto const endGain = targetGain > startGain ? std::min(startGain + fadeStep, targetGain) : std::max(startGain - fadeStep, targetGain);
+    auto const increment = (endGain - startGain) / static_cast<float>(blockSize);
+
+    for (int ch = 0; ch < numChannels; ch++) {
+        auto* channel = samples + ch * blockSize;
+        for (int i = 0; i < blockSize; i++) {
+            channel[i] *= startGain + increment * static_cast<float>(i + 1);
+        }
+    }
+
+    dspFadeGain = endGain;
+    dspFadedOut = endGain == 0.0f;
+}
+
 void Instance::updateObjectImplementations()
 {
     objectImplementations->updateObjectImplementations();
@@ -14,6 +14,7 @@ extern "C" {
 #include <concurrentqueue.h>
 #include <readerwriterqueue.h>
 #include "Utility/CachedStringWidth.h"
+#include "ConsoleBuffer.h"
 #include "Patch.h"
 
 class ObjectImplementationManager;
@@ -271,15 +272,14 @@ public:
     void logError(String const& message);
     void logWarning(String const& message);
 
-    std::deque<std::tuple<void*, String, int, int, int>>& getConsoleMessages();
-    std::deque<std::tuple<void*, String, int, int, int>>& getConsoleHistory();
+    ConsoleMessageStore& getConsoleMessages();
 
     void sendMessagesFromQueue();
     void processSend(dmessage mess);
 
     Patch::Ptr openPatch(File const& toOpen);
 
-    virtual void reloadAbstractions(File changedPatch, t_glist* except) = 0;
+    virtual void reloadAbstractions(File changedPatch, t_glist* except, String const& previousContent) = 0;
 
     void setThis() const;
     t_symbol* generateSymbol(String const& symbol) const;
@@ -287,6 +287,34 @@ public:
 
     void lockAudioThread();
     void unlockAudioThread();
+    bool isAudioLockHeldByCurrentThread() const;
+
+    // Wraps an edit that might rebuild the DSP chain. The outermost rebuild fades the audio out at a block boundary,
+    // suspends DSP so Pd builds the chain only once for the whole edit, and fades back in once it's done
+    void startDSPRebuild();
+    void finishDSPRebuild();
+
+    struct ScopedDSPRebuild {
+        explicit ScopedDSPRebuild(Instance* pd, bool const affectsDSP = true)
+            : instance(affectsDSP ? pd : nullptr)
+        {
+            if (instance)
+                instance->startDSPRebuild();
+        }
+
+        ~ScopedDSPRebuild()
+        {
+            if (instance)
+                instance->finishDSPRebuild();
+        }
+
+        Instance* instance;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedDSPRebuild)
+    };
+
+    // Called by the audio thread on the output of each Pd block, to ramp it around a DSP rebuild
+    void applyDSPRebuildFade(float* samples, int numChannels, int blockSize);
 
     bool loadLibrary(String const& library);
 
@@ -315,9 +343,31 @@ public:
     CriticalSection patchesLock;
     SmallArray<pd::Patch::Ptr, 16> patches;
 
+    // Objects that were last copied from this instance, kept as atoms so we can paste them without parsing text
+    // Top-level object positions are relative to the top-left of the copied selection, so they can be pasted anywhere
+    struct CopiedObjects {
+        HeapArray<t_atom> atoms;
+        SmallArray<int> positions; // Index of the x coordinate of each top-level object, y follows right after
+        String text;               // What we put on the system clipboard, to check if it still holds our copy
+    };
+
+    CopiedObjects copiedObjects;
+
+    // Last time the audio thread processed a block, so edits don't wait for a fade-out when audio isn't running
+    std::atomic<uint32> lastAudioBlockTime = 0;
+
 private:
     UnorderedMap<void*, SmallArray<pd_weak_reference*>> pdWeakReferences;
 
+    int audioLockDepth = 0;
+    std::atomic<Thread::ThreadID> audioLockOwner = nullptr;
+
+    int dspRebuildDepth = 0;
+    int dspSuspendState = 0;
+    std::atomic<bool> dspFadeOutRequested = false;
+    std::atomic<bool> dspFadedOut = false;
+    float dspFadeGain = 1.0f; // Only used by the audio thread
+
     moodycamel::ConcurrentQueue<std::function<void(void)>> functionQueue = moodycamel::ConcurrentQueue<std::function<void(void)>>(4096);
     moodycamel::ConcurrentQueue<Message> guiMessageQueue = moodycamel::ConcurrentQueue<Message>(64);
 
@@ -339,16 +389,16 @@ protected:
 
         void handleAsyncUpdate() override
         {
-            auto item = std::tuple<void*, String, bool>();
-            int numReceived = 0;
             bool newWarning = false;
+            int numReceived = pendingMessages.popAll([this, &newWarning](void* object, int type, char const* text, int length) {
+                consoleMessages.add(object, String::fromUTF8(text, length), type);
+                newWarning = newWarning || type;
+            });
 
-            while (pendingMessages.try_dequeue(item)) {
-                auto& [object, message, type] = item;
-                addMessage(object, message, type);
-
+            if (auto numDropped = pendingMessages.getAndResetNumDropped()) {
+                consoleMessages.add(nullptr, String(numDropped) + " messages were dropped, because Pd printed faster than the console could keep up", 1);
                 numReceived++;
-                newWarning = newWarning || type;
+                newWarning = true;
             }
 
             // Check if any item got assigned
@@ -357,73 +407,65 @@ protected:
             }
         }
 
-        void addMessage(void* object, String const& message, bool type)
+        void logMessage(void* object, String const& message)
         {
-            if (consoleMessages.size()) {
-                auto& [lastObject, lastMessage, lastType, lastLength, numMessages] = consoleMessages.back();
-                if (object == lastObject && message == lastMessage && type == lastType) {
-                    numMessages++;
-                } else {
-                    consoleMessages.emplace_back(object, message, type, CachedStringWidth<14>::calculateStringWidth(message) + 40, 1);
-                }
-            } else {
-                consoleMessages.emplace_back(object, message, type, CachedStringWidth<14>::calculateStringWidth(message) + 40, 1);
-            }
+            postMessage(object, message, 0);
+        }
 
-            if (consoleMessages.size() > 800)
-                consoleMessages.pop_front();
+        void logWarning(void* object, String const& warning)
+        {
+            postMessage(object, warning, 1);
         }
 
-        void logMessage(void* object, String const& message)
+        void logError(void* object, String const& error)
         {
-            if (MessageManager::getInstance()->isThisTheMessageThread()) {
-                addMessage(object, message, false);
-                instance->updateConsole(1, false);
-            } else {
-                pendingMessages.enqueue({ object, message, false });
-                triggerAsyncUpdate();
-            }
+            postMessage(object, error, 1);
         }
 
-        void logWarning(void* object, String const& warning)
+        // Other loggers can be called from any thread, so they're passed to the message thread to keep Pd the only producer of pendingMessages
+        void postMessage(void* object, String const& message, int type)
         {
             if (MessageManager::getInstance()->isThisTheMessageThread()) {
-                addMessage(object, warning, true);
-                instance->updateConsole(1, true);
+                consoleMessages.add(object, message, type);
+                instance->updateConsole(1, type);
             } else {
-                pendingMessages.enqueue({ object, warning, true });
-                triggerAsyncUpdate();
+                MessageManager::callAsync([pd = juce::WeakReference(instance), object, message, type]() {
+                    if (pd)
+                        pd->consoleHandler.postMessage(object, message, type);
+                });
             }
         }
 
-        void logError(void* object, String const& error)
+        // Posts text from Pd's print hook, without creating a String unless we're already on the message thread
+        void postMessage(void* object, char const* message, int type)
         {
             if (MessageManager::getInstance()->isThisTheMessageThread()) {
-                addMessage(object, error, true);
-                instance->updateConsole(1, true);
+                consoleMessages.add(object, String::fromUTF8(message), type);
+                instance->updateConsole(1, type);
             } else {
-                pendingMessages.enqueue({ object, error, true });
+                pendingMessages.push(object, type, message, static_cast<int>(strlen(message)));
                 triggerAsyncUpdate();
             }
         }
 
         void processPrint(void* object, char const* message)
         {
-            std::function<void(String const)> forwardMessage =
-                [this, object](String const& message) {
-                    if (message.startsWith("error")) {
-                        logError(object, message.substring(7));
-                    } else if (message.startsWith("verbose(0):") || message.startsWith("verbose(1):")) {
-                        logError(object, message.substring(12));
-                    } else {
-                        if (message.startsWith("verbose(")) {
-                            logMessage(object, message.substring(12));
-                        } else {
-                            logMessage(object, message);
-                        }
-                    }
+            auto forwardMessage = [this, object](char const* message) {
+                auto skip = [message](size_t numChars) {
+                    return message + std::min(numChars, strlen(message));
                 };
 
+                if (strncmp(message, "error", 5) == 0) {
+                    postMessage(object, skip(7), 1);
+                } else if (strncmp(message, "verbose(0):", 11) == 0 || strncmp(message, "verbose(1):", 11) == 0) {
+                    postMessage(object, skip(12), 1);
+                } else if (strncmp(message, "verbose(", 8) == 0) {
+                    postMessage(object, skip(12), 0);
+                } else {
+                    postMessage(object, message, 0);
+                }
+            };
+
             static int length = 0;
             printConcatBuffer[length] = '\0';
 
@@ -433,7 +475,7 @@ protected:
                 strncat(printConcatBuffer.data(), message, d);
 
                 // Send concatenated line to plugdata!
-                forwardMessage(String::fromUTF8(printConcatBuffer.data()));
+                forwardMessage(printConcatBuffer.data());
 
                 message += d;
                 len -= d;
@@ -448,18 +490,17 @@ protected:
                 printConcatBuffer[length - 1] = '\0';
 
                 // Send concatenated line to plugdata!
-                forwardMessage(String::fromUTF8(printConcatBuffer.data()));
+                forwardMessage(printConcatBuffer.data());
 
                 length = 0;
             }
         }
 
-        std::deque<std::tuple<void*, String, int, int, int>> consoleMessages;
-        std::deque<std::tuple<void*, String, int, int, int>> consoleHistory;
+        ConsoleMessageStore consoleMessages;
 
         StackArray<char, 2048> printConcatBuffer;
 
-        moodycamel::ReaderWriterQueue<std::tuple<void*, String, bool>> pendingMessages;
+        ConsoleMessageQueue pendingMessages;
     };
 
     ConsoleHandler consoleHandler;
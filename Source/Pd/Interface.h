@@ -228,7 +228,41 @@ struct Interface {
         return oc;
     }
 
+    // Looks up the outlet and inlet index of a connection in the outlets of its source object
+    static bool getConnectionIndices(t_object* src, t_outconnect* connection, int* nout, int* nin)
+    {
+        for (int outno = 0; outno < obj_noutlets(src); outno++) {
+            t_outlet* outlet;
+            auto* oc = obj_starttraverseoutlet(src, &outlet, outno);
+            while (oc) {
+                t_object* sink;
+                t_inlet* inlet;
+                int inno;
+                auto* next = obj_nexttraverseoutlet(oc, &sink, &inlet, &inno);
+                if (oc == connection) {
+                    *nout = outno;
+                    *nin = inno;
+                    return true;
+                }
+                oc = next;
+            }
+        }
+
+        return false;
+    }
+
     static char const* copy(t_canvas* cnv, int* size, SmallArray<t_gobj*> const& objects)
+    {
+        char* text;
+        int len;
+        binbuf_gettext(copyToBuffer(cnv, objects), &text, &len);
+        *size = len;
+
+        return text;
+    }
+
+    /* copy the objects into pd's copy buffer, and return that buffer */
+    static t_binbuf* copyToBuffer(t_canvas* cnv, SmallArray<t_gobj*> const& objects)
     {
         glist_noselect(cnv);
 
@@ -240,14 +274,9 @@ struct Interface {
         pd_typedmess((t_pd*)cnv, gensym("copy"), 0, nullptr);
         canvas_unsetcurrent(cnv);
 
-        char* text;
-        int len;
-        binbuf_gettext(getInstanceEditor()->copy_binbuf, &text, &len);
-        *size = len;
-
         glist_noselect(cnv);
 
-        return text;
+        return getInstanceEditor()->copy_binbuf;
     }
 
     static t_symbol* getUnusedArrayName()
@@ -397,6 +426,18 @@ struct Interface {
         canvas_unsetcurrent(cnv);
     }
 
+    /* paste atoms directly, without parsing them from text first */
+    static void paste(t_canvas* cnv, int argc, t_atom const* argv)
+    {
+        auto* copyBinbuf = getInstanceEditor()->copy_binbuf;
+        binbuf_clear(copyBinbuf);
+        binbuf_add(copyBinbuf, argc, argv);
+
+        canvas_setcurrent(cnv);
+        pd_typedmess((t_pd*)cnv, gensym("paste"), 0, nullptr);
+        canvas_unsetcurrent(cnv);
+    }
+
     static void undo(t_canvas* cnv)
     {
         canvas_setcurrent(cnv);
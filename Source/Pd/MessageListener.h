@@ -15,6 +15,10 @@ class MessageListener {
 public:
     virtual void receiveMessage(t_symbol* symbol, SmallArray<pd::Atom> const& atoms) = 0;
 
+    // Called once per frame, after all messages for this listener have been delivered
+    // Use this to apply expensive updates once, instead of for every incoming message
+    virtual void messagesFlushed() { }
+
     void* object;
     JUCE_DECLARE_WEAK_REFERENCEABLE(MessageListener)
 };
@@ -32,6 +36,13 @@ class MessageDispatcher {
         PointerIntPair<t_symbol*, 2, uint8_t> symbolAndSize;
     };
 
+    // Latest message for a target and symbol combination within a frame
+    struct PendingMessage {
+        void* target;
+        t_symbol* symbol;
+        SmallArray<pd::Atom> atoms;
+    };
+
 public:
     MessageDispatcher()
     {
@@ -123,7 +134,11 @@ public:
 
         usedHashes.clear();
         nullListeners.clear();
+        pendingMessages.clear();
+        flushedListeners.clear();
+        flushedListenerPointers.clear();
 
+        // First pass: messages come out newest first, so we only keep the latest message for every target and symbol
         Message message;
         while (popMessage(message)) {
             auto targetPtr = message.targetAndSize.getPointer();
@@ -160,18 +175,36 @@ public:
             if (!symbol)
                 continue;
 
+            pendingMessages.emplace_back(PendingMessage { targetPtr, symbol, std::move(atoms) });
+        }
+
+        // Second pass: deliver the remaining messages in the order they were sent, so the latest state always wins
+        for (auto pending = pendingMessages.rbegin(); pending != pendingMessages.rend(); ++pending) {
+            auto target = messageListeners.find(pending->target);
+            if (target == messageListeners.end())
+                continue;
+
             for (auto it = target->second.begin(); it != target->second.end(); ++it) {
                 if (it->wasObjectDeleted())
                     continue;
                 auto listener = it->get();
 
-                if (listener)
-                    listener->receiveMessage(symbol, atoms);
-                else
-                    nullListeners.add({ targetPtr, it });
+                if (listener) {
+                    listener->receiveMessage(pending->symbol, pending->atoms);
+                    if (flushedListenerPointers.insert(listener).second)
+                        flushedListeners.add(*it);
+                } else {
+                    nullListeners.add({ pending->target, it });
+                }
             }
         }
 
+        // Finally, let every listener that received messages apply its updates once for this frame
+        for (auto& listener : flushedListeners) {
+            if (auto* l = listener.get())
+                l->messagesFlushed();
+        }
+
         nullListeners.erase(
             std::remove_if(nullListeners.begin(), nullListeners.end(),
                 [&](auto const& entry) {
@@ -199,6 +232,9 @@ private:
 
     SmallArray<std::pair<void*, UnorderedSet<juce::WeakReference<pd::MessageListener>>::iterator>, 16> nullListeners;
     UnorderedSet<intptr_t> usedHashes;
+    HeapArray<PendingMessage> pendingMessages;
+    HeapArray<juce::WeakReference<MessageListener>> flushedListeners;
+    UnorderedSet<MessageListener*> flushedListenerPointers;
     UnorderedMap<void*, UnorderedSet<juce::WeakReference<MessageListener>>> messageListeners;
 };
 
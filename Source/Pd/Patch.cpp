@@ -11,6 +11,7 @@
 #include "Patch.h"
 #include "Instance.h"
 #include "Interface.h"
+#include "AbstractionReloader.h"
 #include "Objects/ObjectBase.h"
 #include "../PluginEditor.h"
 
@@ -90,6 +91,18 @@ bool Patch::canRedo() const
     return canPatchRedo.load();
 }
 
+Patch::UndoRedoState Patch::getUndoRedoState() const
+{
+    UndoRedoState state;
+    state.canUndo = canPatchUndo.load();
+    state.canRedo = canPatchRedo.load();
+
+    SpinLock::ScopedLockType lock(undoRedoStateLock);
+    state.undoName = lastUndoSequence;
+    state.redoName = lastRedoSequence;
+    return state;
+}
+
 void Patch::savePatch(URL const& locationURL)
 {
     auto location = locationURL.getLocalFile();
@@ -99,11 +112,16 @@ void Patch::savePatch(URL const& locationURL)
     auto* dir = instance->generateSymbol(fullPathname.replace("\\", "/"));
     auto* file = instance->generateSymbol(filename);
 
+    t_glist* savedPatch = nullptr;
+    String previousContent;
     if (auto patch = ptr.get<t_glist>()) {
         setTitle(filename);
         untitledPatchNum = 0;
         canvas_dirty(patch.get(), 0);
 
+        // Other instances of this abstraction were loaded from the old content, we use it to only reload what changed
+        previousContent = location.existsAsFile() ? location.loadFileAsString() : String();
+
 #if JUCE_IOS
         auto patchText = getCanvasContent();
         auto outputStream = locationURL.createOutputStream();
@@ -121,8 +139,12 @@ void Patch::savePatch(URL const& locationURL)
 
         currentFile = location;
         currentURL = locationURL;
-        instance->reloadAbstractions(location, patch.get());
+        savedPatch = patch.get();
     }
+
+    // Reload after releasing the lock, so the reload can let audio fade out before it rebuilds DSP
+    if (savedPatch)
+        instance->reloadAbstractions(location, savedPatch, previousContent);
 }
 
 t_glist* Patch::getRoot()
@@ -146,15 +168,26 @@ bool Patch::isSubpatch()
 void Patch::updateUndoRedoState()
 {
     if (auto patch = ptr.get<t_glist>()) {
-        canPatchUndo = pd::Interface::canUndo(patch.get());
-        canPatchRedo = pd::Interface::canRedo(patch.get());
         isPatchDirty = patch->gl_dirty;
 
-        auto undoSize = pd::Interface::getUndoSize(patch.get());
-        if (undoQueueSize != undoSize) {
-            undoQueueSize = undoSize;
-            updateUndoRedoString();
-        }
+        // Only take a new snapshot if the actions around the undo position changed, so we don't have to walk the undo queue after every edit
+        auto* udo = canvas_undo_get(patch.get());
+        auto* currentUndo = udo ? udo->u_last : nullptr;
+        auto* currentRedo = currentUndo ? currentUndo->next : nullptr;
+        auto* currentUndoName = currentUndo ? currentUndo->name : nullptr;
+        auto* currentRedoName = currentRedo ? currentRedo->name : nullptr;
+
+        if (currentUndo == lastUndoAction && currentRedo == lastRedoAction && currentUndoName == lastUndoActionName && currentRedoName == lastRedoActionName)
+            return;
+
+        lastUndoAction = currentUndo;
+        lastRedoAction = currentRedo;
+        lastUndoActionName = currentUndoName;
+        lastRedoActionName = currentRedoName;
+
+        canPatchUndo = pd::Interface::canUndo(patch.get());
+        canPatchRedo = pd::Interface::canRedo(patch.get());
+        updateUndoRedoString();
     }
 }
 
@@ -166,20 +199,28 @@ void Patch::savePatch()
     auto* dir = instance->generateSymbol(fullPathname.replace("\\", "/"));
     auto* file = instance->generateSymbol(filename);
 
+    String previousContent;
     if (auto patch = ptr.get<t_glist>()) {
         setTitle(filename);
         untitledPatchNum = 0;
         canvas_dirty(patch.get(), 0);
 
+        // Other instances of this abstraction were loaded from the old content, we use it to only reload what changed
+        previousContent = currentFile.existsAsFile() ? currentFile.loadFileAsString() : String();
         pd::Interface::saveToFile(patch.get(), file, dir);
     }
 
-    MessageManager::callAsync([instance = juce::WeakReference(this->instance), file = this->currentFile, ptr = this->ptr]() {
-        if (instance) {
-            if (auto patch = ptr.get<t_glist>()) {
-                instance->reloadAbstractions(file, patch.get());
-            }
+    MessageManager::callAsync([instance = juce::WeakReference(this->instance), file = this->currentFile, ptr = this->ptr, previousContent]() {
+        if (!instance)
+            return;
+
+        t_glist* savedPatch = nullptr;
+        if (auto patch = ptr.get<t_glist>()) {
+            savedPatch = patch.get();
         }
+
+        if (savedPatch)
+            instance->reloadAbstractions(file, savedPatch, previousContent);
     });
 }
 
@@ -232,6 +273,34 @@ HeapArray<pd::WeakReference> Patch::getObjects()
     return objects;
 }
 
+// Creating one of these can add to the DSP chain: signal objects, subpatches, clones and anything that still has to be loaded, like abstractions
+static bool mayAffectDSP(Instance* instance, String const& objectName)
+{
+    if (objectName.containsChar('~') || objectName == "pd" || objectName == "clone")
+        return true;
+
+    return !zgetfn(&pd_objectmaker, instance->generateSymbol(objectName));
+}
+
+static bool mayAffectDSP(Instance* instance, StringArray const& patchLines)
+{
+    for (auto const& line : patchLines) {
+        if (!line.startsWith("#X obj "))
+            continue;
+
+        auto tokens = StringArray::fromTokens(line.upToFirstOccurrenceOf(";", false, false), true);
+        if (tokens.size() > 4 && mayAffectDSP(instance, tokens[4]))
+            return true;
+    }
+
+    return false;
+}
+
+static bool hasDSPMethod(Instance* instance, t_gobj* object)
+{
+    return zgetfn(&object->g_pd, instance->generateSymbol("dsp")) != nullptr;
+}
+
 t_gobj* Patch::createObject(int x, int y, String const& name)
 {
 
@@ -308,6 +377,7 @@ t_gobj* Patch::createObject(int x, int y, String const& name)
         }
     }
 
+    Instance::ScopedDSPRebuild dspRebuild(instance, typesymbol == instance->generateSymbol("obj") && mayAffectDSP(instance, tokens[0]));
     if (auto patch = ptr.get<t_glist>()) {
         setCurrent();
         return pd::Interface::createObject(patch.get(), typesymbol, argc, argv.data());
@@ -324,6 +394,12 @@ t_gobj* Patch::renameObject(t_object* obj, String const& name)
     ObjectThemeManager::get()->formatObject(tokens);
     String newName = tokens.joinIntoString(" ");
 
+    auto affectsDSP = mayAffectDSP(instance, tokens[0]);
+    if (auto patch = ptr.get<t_glist>()) {
+        affectsDSP = affectsDSP || hasDSPMethod(instance, &obj->te_g);
+    }
+
+    Instance::ScopedDSPRebuild dspRebuild(instance, affectsDSP);
     if (auto patch = ptr.get<t_glist>()) {
         setCurrent();
 
@@ -337,10 +413,62 @@ t_gobj* Patch::renameObject(t_object* obj, String const& name)
 void Patch::copy(SmallArray<t_gobj*> const& objects)
 {
     if (auto patch = ptr.get<t_glist>()) {
+        auto* binbuf = pd::Interface::copyToBuffer(patch.get(), objects);
+        auto* argv = binbuf_getvec(binbuf);
+        auto argc = binbuf_getnatom(binbuf);
+
+        auto& copied = instance->copiedObjects;
+        copied.atoms.resize(argc);
+        std::copy(argv, argv + argc, copied.atoms.data());
+        copied.positions.clear();
+
+        auto isSymbol = [](t_atom const& atom, char const* name) {
+            return atom.a_type == A_SYMBOL && !strcmp(atom.a_w.w_symbol->s_name, name);
+        };
+
+        // Find the positions of the top-level objects, the same way translatePatchAsString does
+        int minX = std::numeric_limits<int>::max();
+        int minY = std::numeric_limits<int>::max();
+        int canvasDepth = 0;
+        for (int start = 0, end = 0; start < argc; start = end + 1) {
+            end = start;
+            while (end < argc && argv[end].a_type != A_SEMI)
+                end++;
+
+            auto const* message = argv + start;
+            if (end - start < 4 || (!isSymbol(message[0], "#N") && !isSymbol(message[0], "#X")))
+                continue;
+
+            auto const hasPosition = message[2].a_type == A_FLOAT && message[3].a_type == A_FLOAT;
+            if (isSymbol(message[0], "#N") && isSymbol(message[1], "canvas")) {
+                canvasDepth++;
+            } else if (isSymbol(message[1], "restore")) {
+                if (canvasDepth == 1 && hasPosition)
+                    copied.positions.add(start + 2);
+                canvasDepth--;
+            } else if (canvasDepth == 0 && hasPosition && !isSymbol(message[1], "connect") && !isSymbol(message[1], "f")) {
+                copied.positions.add(start + 2);
+            }
+        }
+
+        for (auto index : copied.positions) {
+            minX = std::min(minX, static_cast<int>(atom_getfloat(&copied.atoms[index])));
+            minY = std::min(minY, static_cast<int>(atom_getfloat(&copied.atoms[index + 1])));
+        }
+
+        for (auto index : copied.positions) {
+            SETFLOAT(&copied.atoms[index], static_cast<int>(atom_getfloat(&copied.atoms[index])) - minX);
+            SETFLOAT(&copied.atoms[index + 1], static_cast<int>(atom_getfloat(&copied.atoms[index + 1])) - minY);
+        }
+
+        // JUCE can't render the system clipboard on demand, so we still need a text version
+        char* text;
         int size;
-        char const* text = pd::Interface::copy(patch.get(), &size, objects);
-        auto copied = String::fromUTF8(text, size);
-        MessageManager::callAsync([copied]() mutable { SystemClipboard::copyTextToClipboard(copied); });
+        binbuf_gettext(binbuf, &text, &size);
+        copied.text = String::fromUTF8(text, size);
+        freebytes(text, size);
+
+        MessageManager::callAsync([copiedText = copied.text]() mutable { SystemClipboard::copyTextToClipboard(copiedText); });
     }
 }
 
@@ -439,6 +567,22 @@ String Patch::translatePatchAsString(String const& patchAsString, Point<int> pos
 void Patch::paste(Point<int> position)
 {
     auto text = SystemClipboard::getTextFromClipboard();
+    Instance::ScopedDSPRebuild dspRebuild(instance, mayAffectDSP(instance, StringArray::fromLines(text)));
+
+    // If the clipboard still holds what we copied, paste the atoms we kept instead of parsing the text
+    auto& copied = instance->copiedObjects;
+    if (!copied.atoms.empty() && text == copied.text) {
+        auto atoms = copied.atoms;
+        for (auto index : copied.positions) {
+            SETFLOAT(&atoms[index], atom_getfloat(&atoms[index]) + position.x);
+            SETFLOAT(&atoms[index + 1], atom_getfloat(&atoms[index + 1]) + position.y);
+        }
+
+        if (auto patch = ptr.get<t_glist>()) {
+            pd::Interface::paste(patch.get(), static_cast<int>(atoms.size()), atoms.data());
+        }
+        return;
+    }
 
     auto translatedObjects = translatePatchAsString(text, position);
 
@@ -449,6 +593,7 @@ void Patch::paste(Point<int> position)
 
 void Patch::duplicate(SmallArray<t_gobj*> const& objects, t_outconnect* connection)
 {
+    Instance::ScopedDSPRebuild dspRebuild(instance, containsDSPObjects(objects));
     if (auto patch = ptr.get<t_glist>()) {
         setCurrent();
         pd::Interface::duplicateSelection(patch.get(), objects, connection);
@@ -483,6 +628,7 @@ bool Patch::canConnect(t_object* src, int nout, t_object* sink, int nin)
 
 void Patch::createConnection(t_object* src, int nout, t_object* sink, int nin)
 {
+    Instance::ScopedDSPRebuild dspRebuild(instance, isSignalOutlet(src, nout));
     if (auto patch = ptr.get<t_glist>()) {
         setCurrent();
         pd::Interface::createConnection(patch.get(), src, nout, sink, nin);
@@ -491,6 +637,7 @@ void Patch::createConnection(t_object* src, int nout, t_object* sink, int nin)
 
 t_outconnect* Patch::createAndReturnConnection(t_object* src, int nout, t_object* sink, int nin)
 {
+    Instance::ScopedDSPRebuild dspRebuild(instance, isSignalOutlet(src, nout));
     if (auto patch = ptr.get<t_glist>()) {
         setCurrent();
         return pd::Interface::createConnection(patch.get(), src, nout, sink, nin);
@@ -501,6 +648,7 @@ t_outconnect* Patch::createAndReturnConnection(t_object* src, int nout, t_object
 
 void Patch::removeConnection(t_object* src, int nout, t_object* sink, int nin, t_symbol* connectionPath)
 {
+    Instance::ScopedDSPRebuild dspRebuild(instance, isSignalOutlet(src, nout));
     if (auto patch = ptr.get<t_glist>()) {
         setCurrent();
         pd::Interface::removeConnection(patch.get(), src, nout, sink, nin, connectionPath);
@@ -544,6 +692,7 @@ void Patch::finishRemove()
 
 void Patch::removeObjects(SmallArray<t_gobj*> const& objects)
 {
+    Instance::ScopedDSPRebuild dspRebuild(instance, containsDSPObjects(objects));
     if (auto patch = ptr.get<t_glist>()) {
         setCurrent();
         pd::Interface::removeObjects(patch.get(), objects);
@@ -562,7 +711,7 @@ void Patch::endUndoSequence(String const& name)
     if (auto patch = ptr.get<t_glist>()) {
         canvas_undo_add(patch.get(), UNDO_SEQUENCE_END, instance->generateSymbol(name)->s_name, nullptr);
 
-        updateUndoRedoString();
+        updateUndoRedoState();
     }
 }
 
@@ -574,7 +723,7 @@ void Patch::undo()
         glist_noselect(x);
 
         pd::Interface::undo(patch.get());
-        updateUndoRedoString();
+        updateUndoRedoState();
     }
 }
 
@@ -586,7 +735,7 @@ void Patch::redo()
         glist_noselect(x);
 
         pd::Interface::redo(patch.get());
-        updateUndoRedoString();
+        updateUndoRedoState();
     }
 }
 
@@ -594,26 +743,27 @@ void Patch::updateUndoRedoString()
 {
     if (auto patch = ptr.get<t_glist>()) {
         auto cnv = patch.get();
-        auto currentUndo = canvas_undo_get(cnv)->u_last;
+        auto* udo = canvas_undo_get(cnv);
+        auto currentUndo = udo ? udo->u_last : nullptr;
         auto undo = currentUndo;
-        auto redo = currentUndo->next;
+        auto redo = currentUndo ? currentUndo->next : nullptr;
 
 #ifdef DEBUG_UNDO_QUEUE
         auto undoDbg = undo;
         auto redoDbg = redo;
 #endif
 
-        lastUndoSequence = "";
-        lastRedoSequence = "";
+        String undoSequence;
+        String redoSequence;
 
         // undo / redo list will contain pd undo events
         while (undo) {
             String undoName = String::fromUTF8(undo->name);
             if (undoName == "props") {
-                lastUndoSequence = "Change property";
+                undoSequence = "Change property";
                 break;
             } else if (undoName != "no") {
-                lastUndoSequence = undoName.substring(0, 1).toUpperCase() + undoName.substring(1);
+                undoSequence = undoName.substring(0, 1).toUpperCase() + undoName.substring(1);
                 break;
             }
             undo = undo->prev;
@@ -622,14 +772,20 @@ void Patch::updateUndoRedoString()
         while (redo) {
             String redoName = String::fromUTF8(redo->name);
             if (redoName == "props") {
-                lastRedoSequence = "Change property";
+                redoSequence = "Change property";
                 break;
             } else if (redoName != "no") {
-                lastRedoSequence = redoName.substring(0, 1).toUpperCase() + redoName.substring(1);
+                redoSequence = redoName.substring(0, 1).toUpperCase() + redoName.substring(1);
                 break;
             }
             redo = redo->next;
         }
+
+        {
+            SpinLock::ScopedLockType lock(undoRedoStateLock);
+            lastUndoSequence = undoSequence;
+            lastRedoSequence = redoSequence;
+        }
 // #define DEBUG_UNDO_QUEUE
 #ifdef DEBUG_UNDO_QUEUE
         std::cout << "<<<<<< undo list:" << std::endl;
@@ -750,13 +906,37 @@ String Patch::getCanvasContent()
     return content;
 }
 
-void Patch::reloadPatch(File const& changedPatch, t_glist* except)
+void Patch::reloadPatch(File const& changedPatch, t_glist* except, String const& previousContent)
 {
+    // Try to only apply the changes to the other instances first, so they can keep their state
+    if (AbstractionReloader::reloadChanges(changedPatch, previousContent, except))
+        return;
+
     auto* dir = gensym(changedPatch.getParentDirectory().getFullPathName().replace("\\", "/").toRawUTF8());
     auto* file = gensym(changedPatch.getFileName().toRawUTF8());
     canvas_reload(file, dir, except);
 }
 
+bool Patch::containsDSPObjects(SmallArray<t_gobj*> const& objects) const
+{
+    if (auto patch = ptr.get<t_glist>()) {
+        return std::any_of(objects.begin(), objects.end(), [this](t_gobj* object) {
+            return hasDSPMethod(instance, object);
+        });
+    }
+
+    return false;
+}
+
+bool Patch::isSignalOutlet(t_object* object, int outlet) const
+{
+    if (auto patch = ptr.get<t_glist>()) {
+        return obj_issignaloutlet(object, outlet);
+    }
+
+    return false;
+}
+
 bool Patch::objectWasDeleted(t_gobj* objectPtr) const
 {
     if (auto patch = ptr.get<t_glist>()) {
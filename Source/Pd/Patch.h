@@ -73,9 +73,19 @@ public:
 
     void setCurrent();
 
+    // Snapshot of the undo queue, taken on the Pd thread whenever the queue changes
+    // This allows the GUI to read the undo/redo state without locking or walking Pd's undo queue
+    struct UndoRedoState {
+        bool canUndo = false;
+        bool canRedo = false;
+        String undoName;
+        String redoName;
+    };
+
     bool isDirty() const;
     bool canUndo() const;
     bool canRedo() const;
+    UndoRedoState getUndoRedoState() const;
 
     void savePatch(URL const& location);
     void savePatch();
@@ -113,7 +123,7 @@ public:
 
     String getCanvasContent();
 
-    static void reloadPatch(File const& changedPatch, t_glist* except);
+    static void reloadPatch(File const& changedPatch, t_glist* except, String const& previousContent);
 
     String getTitle() const;
     void setTitle(String const& title);
@@ -129,18 +139,29 @@ public:
     Point<int> lastViewportPosition = { 1, 1 };
     float lastViewportScale;
 
-    String lastUndoSequence;
-    String lastRedoSequence;
-
     int untitledPatchNum = 0;
 
+private:
     void updateUndoRedoString();
 
-private:
+    // Used to decide if an edit needs to fade out audio and rebuild DSP
+    bool containsDSPObjects(SmallArray<t_gobj*> const& objects) const;
+    bool isSignalOutlet(t_object* object, int outlet) const;
+
     std::atomic<bool> canPatchUndo;
     std::atomic<bool> canPatchRedo;
     std::atomic<bool> isPatchDirty;
 
+    mutable SpinLock undoRedoStateLock;
+    String lastUndoSequence;
+    String lastRedoSequence;
+
+    // The undo actions and names around the undo position when the last snapshot was taken
+    void* lastUndoAction = nullptr;
+    void* lastRedoAction = nullptr;
+    char const* lastUndoActionName = nullptr;
+    char const* lastRedoActionName = nullptr;
+
     File currentFile;
     URL currentURL; // We hold a URL to the patch as well, which is needed for file IO on iOS
 
@@ -149,8 +170,6 @@ private:
     friend class Instance;
     friend class Object;
 
-    int undoQueueSize = 0;
-
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Patch)
 };
 } // namespace pd
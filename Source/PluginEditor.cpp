@@ -1480,6 +1480,7 @@ bool PluginEditor::perform(InvocationInfo const& info)
     }
     case CommandIDs::SelectAll: {
         cnv = getCurrentCanvas();
+        cnv->loadAllObjects();
         for (auto* object : cnv->objects) {
             cnv->setSelected(object, true, false);
         }
@@ -1766,7 +1767,7 @@ Object* PluginEditor::highlightSearchTarget(void* target, bool openNewTabIfNeede
         return nullptr;
     };
 
-    pd->audioLock.enter();
+    pd->lockAudioThread();
 
     t_glist* targetCanvas = nullptr;
     for (auto* glist = pd_getcanvaslist(); glist; glist = glist->gl_next) {
@@ -1777,7 +1778,7 @@ Object* PluginEditor::highlightSearchTarget(void* target, bool openNewTabIfNeede
         }
     }
     
-    pd->audioLock.exit();
+    pd->unlockAudioThread();
 
     if (!targetCanvas) {
         return nullptr;
@@ -1788,6 +1789,7 @@ Object* PluginEditor::highlightSearchTarget(void* target, bool openNewTabIfNeede
 
     for (auto* openCanvas : getCanvases()) {
         if (openCanvas->patch.getPointer().get() == targetCanvas) {
+            openCanvas->loadAllObjects();
             for (auto* object : openCanvas->objects) {
                 if (object->getPointer() == target) {
                     found = object;
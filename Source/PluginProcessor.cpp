@@ -89,6 +89,7 @@ PluginProcessor::PluginProcessor()
     : AudioProcessor(buildBusesProperties())
     , internalSynth(std::make_unique<InternalSynth>())
     , hostInfoUpdater(this)
+    , parameterChangeNotifier(this)
 {
     // Make sure to use dots for decimal numbers, pd requires that
     std::setlocale(LC_ALL, "C");
@@ -103,6 +104,8 @@ PluginProcessor::PluginProcessor()
         settingsFile = SettingsFile::getInstance()->initialise();
     }
 
+    getConsoleMessages().setCapacity(settingsFile->getProperty<int>("console_capacity"));
+
     statusbarSource = std::make_unique<StatusbarSource>();
 
     auto* volumeParameter = new PlugDataParameter(this, "volume", 0.8f, true, 0, 0.0f, 1.0f);
@@ -527,7 +530,7 @@ void PluginProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
     midiOutputHistory.ensureSize(2048);
     midiBufferInternalSynth.ensureSize(2048);
 
-    midiDeviceManager.prepareToPlay(sampleRate);
+    midiDeviceManager.prepareToPlay(sampleRate, samplesPerBlock, 1 << oversampling);
 
     cpuLoadMeasurer.reset(sampleRate, samplesPerBlock);
 
@@ -609,7 +612,12 @@ void PluginProcessor::updatePatchUndoRedoState()
         return;
     }
 
+    // Many edits can request an update before Pd gets to it, like when dragging objects. We only need to check once
+    if (undoRedoStateUpdatePending.exchange(true))
+        return;
+
     enqueueFunctionAsync([this]() {
+        undoRedoStateUpdatePending = false;
         ScopedLock lock(patchesLock);
         for (auto& patch : patches) {
             patch->updateUndoRedoState();
@@ -633,11 +641,15 @@ void PluginProcessor::processBlock(AudioBuffer<float>& buffer, MidiBuffer& midiB
     ScopedNoDenormals noDenormals;
     AudioProcessLoadMeasurer::ScopedTimer cpuTimer(cpuLoadMeasurer, buffer.getNumSamples());
 
+    lastAudioBlockTime = Time::getMillisecondCounter();
+
     auto totalNumInputChannels = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
     if (!ProjectInfo::isStandalone && !midiBuffer.isEmpty()) {
-        midiDeviceManager.enqueueMidiInput(0, midiBuffer);
+        // Samples that are still waiting in the FIFO will be processed before this block
+        auto const fifoOffset = variableBlockSize ? inputFifo->getNumSamplesAvailable() : 0;
+        midiDeviceManager.enqueueHostMidiInput(midiBuffer, fifoOffset, 1 << oversampling);
     }
 
     setThis();
@@ -741,6 +753,7 @@ void PluginProcessor::processConstant(dsp::AudioBlock<float> buffer, MidiBuffer&
 {
     int pdBlockSize = Instance::getBlockSize();
     int numBlocks = buffer.getNumSamples() / pdBlockSize;
+    int oversampleFactor = 1 << oversampling;
     audioAdvancement = 0;
 
     if (producesMidi()) {
@@ -766,8 +779,12 @@ void PluginProcessor::processConstant(dsp::AudioBlock<float> buffer, MidiBuffer&
             sendMidiBuffer(port, buffer);
         });
 
+        // MIDI output from this Pd block ends up at the start of it in the output buffer
+        midiOutputPosition = audioAdvancement / oversampleFactor;
+
         // Process audio
         performDSP(audioVectorIn.data(), audioVectorOut.data());
+        applyDSPRebuildFade(audioVectorOut.data(), static_cast<int>(buffer.getNumChannels()), pdBlockSize);
 
         sendMessagesFromQueue();
 
@@ -795,6 +812,11 @@ void PluginProcessor::processVariable(dsp::AudioBlock<float> buffer, MidiBuffer&
 
     audioAdvancement = 0; // Always has to be 0 if we use the AudioFifo!
 
+    // Output of the next Pd block will be read from the output FIFO after the samples that are already in there
+    auto const oversampleFactor = 1 << oversampling;
+    auto const numHostSamples = static_cast<int>(buffer.getNumSamples()) / oversampleFactor;
+    auto outputPosition = outputFifo->getNumSamplesAvailable();
+
     while (inputFifo->getNumSamplesAvailable() >= pdBlockSize) {
         inputFifo->readAudio(audioBufferIn);
 
@@ -820,8 +842,13 @@ void PluginProcessor::processVariable(dsp::AudioBlock<float> buffer, MidiBuffer&
 
         setThis();
 
+        // Output that would only be heard in the next host block is sent at the end of this one, rather than too late
+        midiOutputPosition = std::clamp(outputPosition / oversampleFactor, 0, std::max(numHostSamples - 1, 0));
+        outputPosition += pdBlockSize;
+
         // Process audio
         performDSP(audioVectorIn.data(), audioVectorOut.data());
+        applyDSPRebuildFade(audioVectorOut.data(), static_cast<int>(numChannels), pdBlockSize);
 
         sendMessagesFromQueue();
 
@@ -1375,9 +1402,9 @@ void PluginProcessor::receiveNoteOn(int const channel, int const pitch, int cons
     auto deviceChannel = channel - (port * 16);
 
     if (velocity == 0) {
-        midiDeviceManager.enqueueMidiOutput(port, MidiMessage::noteOff(deviceChannel, pitch, uint8(0)), audioAdvancement);
+        midiDeviceManager.enqueueMidiOutput(port, MidiMessage::noteOff(deviceChannel, pitch, uint8(0)), midiOutputPosition);
     } else {
-        midiDeviceManager.enqueueMidiOutput(port, MidiMessage::noteOn(deviceChannel, pitch, static_cast<uint8>(velocity)), audioAdvancement);
+        midiDeviceManager.enqueueMidiOutput(port, MidiMessage::noteOn(deviceChannel, pitch, static_cast<uint8>(velocity)), midiOutputPosition);
     }
 }
 
@@ -1386,7 +1413,7 @@ void PluginProcessor::receiveControlChange(int const channel, int const controll
     auto port = channel >> 4;
     auto deviceChannel = channel - (port * 16);
 
-    midiDeviceManager.enqueueMidiOutput(port, MidiMessage::controllerEvent(deviceChannel, controller, value), audioAdvancement);
+    midiDeviceManager.enqueueMidiOutput(port, MidiMessage::controllerEvent(deviceChannel, controller, value), midiOutputPosition);
 }
 
 void PluginProcessor::receiveProgramChange(int const channel, int const value)
@@ -1394,7 +1421,7 @@ void PluginProcessor::receiveProgramChange(int const channel, int const value)
     auto port = channel >> 4;
     auto deviceChannel = channel - (port * 16);
 
-    midiDeviceManager.enqueueMidiOutput(port, MidiMessage::programChange(deviceChannel, value), audioAdvancement);
+    midiDeviceManager.enqueueMidiOutput(port, MidiMessage::programChange(deviceChannel, value), midiOutputPosition);
 }
 
 void PluginProcessor::receivePitchBend(int const channel, int const value)
@@ -1402,7 +1429,7 @@ void PluginProcessor::receivePitchBend(int const channel, int const value)
     auto port = channel >> 4;
     auto deviceChannel = channel - (port * 16);
 
-    midiDeviceManager.enqueueMidiOutput(port, MidiMessage::pitchWheel(deviceChannel, value + 8192), audioAdvancement);
+    midiDeviceManager.enqueueMidiOutput(port, MidiMessage::pitchWheel(deviceChannel, value + 8192), midiOutputPosition);
 }
 
 void PluginProcessor::receiveAftertouch(int const channel, int const value)
@@ -1410,7 +1437,7 @@ void PluginProcessor::receiveAftertouch(int const channel, int const value)
     auto port = channel >> 4;
     auto deviceChannel = channel - (port * 16);
 
-    midiDeviceManager.enqueueMidiOutput(port, MidiMessage::channelPressureChange(deviceChannel, value), audioAdvancement);
+    midiDeviceManager.enqueueMidiOutput(port, MidiMessage::channelPressureChange(deviceChannel, value), midiOutputPosition);
 }
 
 void PluginProcessor::receivePolyAftertouch(int const channel, int const pitch, int const value)
@@ -1418,7 +1445,7 @@ void PluginProcessor::receivePolyAftertouch(int const channel, int const pitch,
     auto port = channel >> 4;
     auto deviceChannel = channel - (port * 16);
 
-    midiDeviceManager.enqueueMidiOutput(port, MidiMessage::aftertouchChange(deviceChannel, pitch, value), audioAdvancement);
+    midiDeviceManager.enqueueMidiOutput(port, MidiMessage::aftertouchChange(deviceChannel, pitch, value), midiOutputPosition);
 }
 
 void PluginProcessor::receiveMidiByte(int const channel, int const byte)
@@ -1427,7 +1454,7 @@ void PluginProcessor::receiveMidiByte(int const channel, int const byte)
 
     if (midiByteIsSysex) {
         if (byte == 0xf7) {
-            midiDeviceManager.enqueueMidiOutput(port, MidiMessage::createSysExMessage(midiByteBuffer, static_cast<int>(midiByteIndex)), audioAdvancement);
+            midiDeviceManager.enqueueMidiOutput(port, MidiMessage::createSysExMessage(midiByteBuffer, static_cast<int>(midiByteIndex)), midiOutputPosition);
             midiByteIndex = 0;
             midiByteIsSysex = false;
         } else {
@@ -1441,13 +1468,13 @@ void PluginProcessor::receiveMidiByte(int const channel, int const byte)
     } else {
         // Handle single-byte messages
         if (midiByteIndex == 0 && byte >= 0xf8 && byte <= 0xff) {
-            midiDeviceManager.enqueueMidiOutput(port, MidiMessage(static_cast<uint8>(byte)), audioAdvancement);
+            midiDeviceManager.enqueueMidiOutput(port, MidiMessage(static_cast<uint8>(byte)), midiOutputPosition);
         }
         // Handle 3-byte messages
         else {
             midiByteBuffer[midiByteIndex++] = static_cast<uint8>(byte);
             if (midiByteIndex >= 3) {
-                midiDeviceManager.enqueueMidiOutput(port, MidiMessage(midiByteBuffer, 3), audioAdvancement);
+                midiDeviceManager.enqueueMidiOutput(port, MidiMessage(midiByteBuffer, 3), midiOutputPosition);
                 midiByteIndex = 0;
             }
         }
@@ -1678,17 +1705,88 @@ void PluginProcessor::sendParameterInfoChangeMessage()
     hostInfoUpdater.triggerAsyncUpdate();
 }
 
-void PluginProcessor::setParameterRange(String const& name, float min, float max)
+PlugDataParameter* PluginProcessor::getEnabledParameter(String const& name)
 {
-    for (auto* p : getParameters()) {
-        auto* param = dynamic_cast<PlugDataParameter*>(p);
-        if (param->isEnabled() && param->getTitle() == name) {
-            max = std::max(max, min + 0.000001f);
-            param->setRange(min, max);
-            break;
+    ScopedLock lock(parameterIndexLock);
+
+    if (parameterIndexNeedsUpdate.exchange(false)) {
+        parameterIndex.clear();
+        for (auto* p : getParameters()) {
+            auto* param = reinterpret_cast<PlugDataParameter*>(p);
+            if (param->isEnabled())
+                parameterIndex.try_emplace(param->getTitle(), param);
+        }
+    }
+
+    auto it = parameterIndex.find(name);
+    return it != parameterIndex.end() ? it->second : nullptr;
+}
+
+void PluginProcessor::invalidateParameterIndex()
+{
+    parameterIndexNeedsUpdate = true;
+}
+
+// Returns all [param] abstractions that use this parameter name
+SmallArray<pd::WeakReference> PluginProcessor::getParameterObjects(String const& name)
+{
+    if (parameterObjectIndexNeedsUpdate) {
+        parameterObjectIndex.clear();
+
+        lockAudioThread();
+        std::function<void(t_glist*)> searchInsideCanvas = [this, &searchInsideCanvas](t_glist* cnv) -> void {
+            for (t_gobj* y = cnv->gl_list; y; y = y->g_next) {
+                if (pd_class(&y->g_pd) != canvas_class)
+                    continue;
+
+                auto* canvas = reinterpret_cast<t_canvas*>(y);
+                if (String(canvas->gl_name->s_name) == "param.pd") {
+                    auto* binbuf = canvas->gl_obj.te_binbuf;
+                    if (binbuf_getnatom(binbuf) > 1) {
+                        auto* atoms = binbuf_getvec(binbuf);
+                        if (atoms[1].a_type == A_SYMBOL) {
+                            parameterObjectIndex[String::fromUTF8(atom_getsymbol(&atoms[1])->s_name)].add(pd::WeakReference(canvas, this));
+                        }
+                    }
+                }
+
+                // Yes, also search inside the param.pd - in case someone put a param inside that!
+                searchInsideCanvas(canvas);
+            }
+        };
+
+        for (auto* cnv = pd_getcanvaslist(); cnv; cnv = cnv->gl_next) {
+            searchInsideCanvas(cnv);
+        }
+        unlockAudioThread();
+
+        parameterObjectIndexNeedsUpdate = false;
+    }
+
+    SmallArray<pd::WeakReference> result;
+    auto it = parameterObjectIndex.find(name);
+    if (it != parameterObjectIndex.end()) {
+        for (auto& object : it->second) {
+            if (object.isValid())
+                result.add(object);
         }
     }
 
+    return result;
+}
+
+void PluginProcessor::invalidateParameterObjectIndex()
+{
+    parameterObjectIndexNeedsUpdate = true;
+}
+
+void PluginProcessor::setParameterRange(String const& name, float min, float max)
+{
+    if (auto* param = getEnabledParameter(name)) {
+        max = std::max(max, min + 0.000001f);
+        param->setRange(min, max);
+    }
+
     for (auto* editor : getEditors()) {
         editor->sidebar->updateAutomationParameters();
     }
@@ -1696,12 +1794,8 @@ void PluginProcessor::setParameterRange(String const& name, float min, float max
 
 void PluginProcessor::setParameterMode(String const& name, int mode)
 {
-    for (auto* p : getParameters()) {
-        auto* param = dynamic_cast<PlugDataParameter*>(p);
-        if (param->isEnabled() && param->getTitle() == name) {
-            param->setMode(static_cast<PlugDataParameter::Mode>(std::clamp<int>(mode, 1, 4)));
-            break;
-        }
+    if (auto* param = getEnabledParameter(name)) {
+        param->setMode(static_cast<PlugDataParameter::Mode>(std::clamp<int>(mode, 1, 4)));
     }
 
     for (auto* editor : getEditors()) {
@@ -1711,17 +1805,18 @@ void PluginProcessor::setParameterMode(String const& name, int mode)
 
 void PluginProcessor::enableAudioParameter(String const& name)
 {
+    invalidateParameterObjectIndex();
+
+    if (getEnabledParameter(name))
+        return;
+
     int numEnabled = 0;
     for (auto* p : getParameters()) {
-        auto* param = dynamic_cast<PlugDataParameter*>(p);
-        numEnabled += param->isEnabled();
-        if (param->isEnabled() && param->getTitle() == name) {
-            return;
-        }
+        numEnabled += reinterpret_cast<PlugDataParameter*>(p)->isEnabled();
     }
 
     for (auto* p : getParameters()) {
-        auto* param = dynamic_cast<PlugDataParameter*>(p);
+        auto* param = reinterpret_cast<PlugDataParameter*>(p);
         if (!param->isEnabled()) {
             param->setEnabled(true);
             param->setName(name);
@@ -1738,15 +1833,17 @@ void PluginProcessor::enableAudioParameter(String const& name)
 
 void PluginProcessor::disableAudioParameter(String const& name)
 {
+    invalidateParameterObjectIndex();
+
     for (auto* p : getParameters()) {
-        auto* param = dynamic_cast<PlugDataParameter*>(p);
+        auto* param = reinterpret_cast<PlugDataParameter*>(p);
         if (!param->isEnabled() && param->getTitle() == name) {
             return;
         }
     }
 
     for (auto* p : getParameters()) {
-        auto* param = dynamic_cast<PlugDataParameter*>(p);
+        auto* param = reinterpret_cast<PlugDataParameter*>(p);
         if (param->isEnabled()) {
             param->setEnabled(false);
             param->setValue(0.0f);
@@ -1764,36 +1861,44 @@ void PluginProcessor::disableAudioParameter(String const& name)
 
 void PluginProcessor::performParameterChange(int type, String const& name, float value)
 {
+    auto* pldParam = getEnabledParameter(name);
+    if (!pldParam)
+        return;
+
     // Type == 1 means it sets the change gesture state
     if (type) {
-        for (auto* param : getParameters()) {
-            auto* pldParam = dynamic_cast<PlugDataParameter*>(param);
-
-            if (!pldParam->isEnabled() || pldParam->getTitle() != name)
-                continue;
+        // Make sure the host receives the values that were set before the gesture state changed
+        flushParameterChanges();
 
-            if (pldParam->getGestureState() == value) {
-                logMessage("parameter change " + name + (value ? " already started" : " not started"));
-            } else if (pldParam->isEnabled() && pldParam->getTitle() == name) {
-                pldParam->setGestureState(value);
-            }
+        if (pldParam->getGestureState() == value) {
+            logMessage("parameter change " + name + (value ? " already started" : " not started"));
+        } else {
+            pldParam->setGestureState(value);
         }
     } else { // otherwise set parameter value
-        for (auto* param : getParameters()) {
-            auto* pldParam = dynamic_cast<PlugDataParameter*>(param);
-            if (!pldParam->isEnabled() || pldParam->getTitle() != name)
-                continue;
+        // The new value is sent to the DAW later, so that when Pd sets a parameter many times in a row, the host only gets notified once
+        pldParam->setUnscaledValue(value);
+        pendingParameterChanges.insert(pldParam);
+        parameterChangeNotifier.triggerAsyncUpdate();
+    }
+}
 
-            // Send new value to DAW
-            pldParam->setUnscaledValueNotifyingHost(value);
+void PluginProcessor::flushParameterChanges()
+{
+    parameterChangeNotifier.cancelPendingUpdate();
 
-            if (ProjectInfo::isStandalone) {
-                for (auto* editor : getEditors()) {
-                    editor->sidebar->updateAutomationParameterValue(pldParam);
-                }
+    for (auto* param : pendingParameterChanges) {
+        // Send new value to DAW
+        param->sendValueChangedMessageToListeners(param->getValue());
+
+        if (ProjectInfo::isStandalone) {
+            for (auto* editor : getEditors()) {
+                editor->sidebar->updateAutomationParameterValue(param);
             }
         }
     }
+
+    pendingParameterChanges.clear();
 }
 
 void PluginProcessor::fillDataBuffer(SmallArray<pd::Atom> const& vec)
@@ -1893,7 +1998,7 @@ SmallArray<PluginEditor*> PluginProcessor::getEditors() const
     return editors;
 }
 
-void PluginProcessor::reloadAbstractions(File changedPatch, t_glist* except)
+void PluginProcessor::reloadAbstractions(File changedPatch, t_glist* except, String const& previousContent)
 {
     setThis();
 
@@ -1902,7 +2007,11 @@ void PluginProcessor::reloadAbstractions(File changedPatch, t_glist* except)
 
     isPerformingGlobalSync = true;
 
-    pd::Patch::reloadPatch(changedPatch, except);
+    {
+        // Every instance of the abstraction might get new signal objects, so rebuild DSP once for all of them
+        ScopedDSPRebuild dspRebuild(this);
+        pd::Patch::reloadPatch(changedPatch, except, previousContent);
+    }
 
     for (auto* editor : getEditors()) {
         // Synchronising can potentially delete some other canvases, so make sure we use a safepointer
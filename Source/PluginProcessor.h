@@ -30,6 +30,7 @@ struct PlugDataLook;
 class PluginEditor;
 class ConnectionMessageDisplay;
 class Object;
+class PlugDataParameter;
 class PluginProcessor final : public AudioProcessor
     , public pd::Instance
     , public SettingsFileListener {
@@ -95,7 +96,7 @@ public:
 
     void updateConsole(int numMessages, bool newWarning) override;
 
-    void reloadAbstractions(File changedPatch, t_glist* except) override;
+    void reloadAbstractions(File changedPatch, t_glist* except, String const& previousContent) override;
 
     void processConstant(dsp::AudioBlock<float>, MidiBuffer& midiBuffer);
     void processVariable(dsp::AudioBlock<float>, MidiBuffer& midiBuffer);
@@ -132,6 +133,11 @@ public:
     void setParameterRange(String const& name, float min, float max) override;
     void setParameterMode(String const& name, int mode) override;
 
+    PlugDataParameter* getEnabledParameter(String const& name);
+    SmallArray<pd::WeakReference> getParameterObjects(String const& name);
+    void invalidateParameterIndex();
+    void invalidateParameterObjectIndex();
+
     void performLatencyCompensationChange(float value) override;
     void sendParameterInfoChangeMessage();
 
@@ -189,6 +195,7 @@ private:
     SmoothedValue<float, ValueSmoothingTypes::Linear> smoothedGain;
 
     int audioAdvancement = 0;
+    int midiOutputPosition = 0; // Sample position in the host block for MIDI coming out of Pd
 
     bool variableBlockSize = false;
     AudioBuffer<float> audioBufferIn;
@@ -216,6 +223,8 @@ private:
 
     int lastSetProgram = 0;
 
+    std::atomic<bool> undoRedoStateUpdatePending = false;
+
     Limiter limiter;
     std::unique_ptr<dsp::Oversampling<float>> oversampler;
 
@@ -256,5 +265,34 @@ private:
 
     HostInfoUpdater hostInfoUpdater;
 
+    // Sends the values that Pd has set since the last update to the host, so the host gets at most one notification per parameter
+    class ParameterChangeNotifier : public AsyncUpdater {
+    public:
+        ParameterChangeNotifier(PluginProcessor* parentProcessor)
+            : processor(*parentProcessor) { };
+
+    private:
+        void handleAsyncUpdate() override
+        {
+            processor.flushParameterChanges();
+        }
+
+        PluginProcessor& processor;
+    };
+
+    void flushParameterChanges();
+
+    ParameterChangeNotifier parameterChangeNotifier;
+    UnorderedSet<PlugDataParameter*> pendingParameterChanges;
+
+    // Enabled parameters by name, rebuilt after a parameter has been renamed, enabled or disabled
+    CriticalSection parameterIndexLock;
+    UnorderedMap<String, PlugDataParameter*> parameterIndex;
+    std::atomic<bool> parameterIndexNeedsUpdate = true;
+
+    // [param] abstractions by parameter name, rebuilt after patches have changed
+    UnorderedMap<String, SmallArray<pd::WeakReference>> parameterObjectIndex;
+    bool parameterObjectIndexNeedsUpdate = true;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PluginProcessor)
 };
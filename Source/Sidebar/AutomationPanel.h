@@ -258,11 +258,6 @@ public:
             if (lastName == newName)
                 return;
 
-            StringArray allNames;
-            for (auto* param : pd->getParameters()) {
-                allNames.add(dynamic_cast<PlugDataParameter*>(param)->getTitle());
-            }
-
             auto character = newName[0];
 
             bool startsWithCorrectChar = (character == '_' || character == '-'
@@ -271,49 +266,14 @@ public:
 
             bool correctCharacters = newName.containsOnly("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ1234567890_-");
 
-            bool uniqueName = !allNames.contains(newName);
+            bool uniqueName = pd->getEnabledParameter(newName) == nullptr;
             bool notEmptyName = newName.isNotEmpty();
 
             // Check if name is valid
             if (startsWithCorrectChar && correctCharacters && uniqueName && notEmptyName) {
                 param->setName(newName);
 
-                auto findParamsWithLastName = [this, newName]() {
-                    SmallArray<pd::WeakReference> paramObjectsToChange;
-
-                    pd->lockAudioThread();
-                    // Find [param] object, and update it's param name to new name
-                    for (auto* cnv = pd_getcanvaslist(); cnv; cnv = cnv->gl_next) {
-                        std::function<void(t_glist*)> searchInsideCanvas = [&](t_glist* cnv) -> void {
-                            for (t_gobj* y = cnv->gl_list; y; y = y->g_next) {
-                                if (pd_class(&y->g_pd) == canvas_class) {
-                                    auto canvas = reinterpret_cast<t_canvas*>(y);
-                                    if (String(canvas->gl_name->s_name) == "param.pd") {
-                                        auto binName = canvas->gl_obj.te_binbuf;
-                                        t_atom* atoms;
-                                        int argc = binbuf_getnatom(binName);
-                                        if (argc > 1) {
-                                            atoms = binbuf_getvec(binName);
-                                            if (atoms[1].a_type == A_SYMBOL) {
-                                                if (String(atom_getsymbol(&atoms[1])->s_name) == lastName) {
-                                                    paramObjectsToChange.add(pd::WeakReference(canvas, pd));
-                                                }
-                                            }
-                                        }
-                                    }
-                                    // Yes, also search inside the param.pd - in case someone put a param inside that!
-                                    searchInsideCanvas(canvas);
-                                }
-                            }
-                        };
-                        searchInsideCanvas(cnv);
-                    }
-                    pd->unlockAudioThread();
-
-                    return paramObjectsToChange;
-                };
-
-                auto const paramsWithLastName = findParamsWithLastName();
+                auto const paramsWithLastName = pd->getParameterObjects(lastName);
 
                 if (paramsWithLastName.size() == 0)
                     return;
@@ -336,6 +296,7 @@ public:
                             pd::Interface::renameObject(obj->gl_owner, &obj->gl_obj.te_g, name.toRawUTF8(), name.getNumBytesAsUTF8());
                         }
                     }
+                    pd->invalidateParameterObjectIndex();
 
                     for (auto& editor : pd->getEditors()) {
                         for (auto canvas : editor->getCanvases()) {
@@ -910,6 +871,11 @@ public:
             return a->param->getIndex() < b->param->getIndex();
         });
 
+        rowsByParameter.clear();
+        for (auto* row : rows) {
+            rowsByParameter[row->param] = row;
+        }
+
         addParameterButton.toFront(false);
 
         checkMaxNumParameters();
@@ -917,6 +883,12 @@ public:
         resized();
     }
 
+    AutomationItem* getRowForParameter(PlugDataParameter* param)
+    {
+        auto it = rowsByParameter.find(param);
+        return it != rowsByParameter.end() ? it->second : nullptr;
+    }
+
     void checkMaxNumParameters()
     {
         addParameterButton.setVisible(rows.size() < PluginProcessor::numParameters);
@@ -967,6 +939,7 @@ public:
     PluginProcessor* pd;
     Component* parentComponent;
     OwnedArray<AutomationItem> rows;
+    UnorderedMap<PlugDataParameter*, AutomationItem*> rowsByParameter;
     AddParameterButton addParameterButton;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AutomationComponent)
@@ -1012,13 +985,9 @@ public:
 
     void updateParameterValue(PlugDataParameter* changedParameter)
     {
-        for (int p = 0; p < sliders.rows.size(); p++) {
-            auto* param = sliders.rows[p]->param;
-            auto& slider = sliders.rows[p]->slider;
-            if (changedParameter == param && slider.getThumbBeingDragged() == -1) {
-                slider.setValue(param->getUnscaledValue());
-                break;
-            }
+        if (auto* row = sliders.getRowForParameter(changedParameter)) {
+            if (row->slider.getThumbBeingDragged() == -1)
+                row->slider.setValue(changedParameter->getUnscaledValue());
         }
     }
 
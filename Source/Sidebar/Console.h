@@ -176,142 +176,40 @@ public:
 
     void deselect()
     {
-        console->selectedItems.clear();
+        console->selectedMessages.clear();
         repaint();
     }
 
+    // Only the rows inside the visible area are laid out and drawn, so the console can hold a large number of messages
+    // The rows that pass the current filter are kept as an index into the message store, which is extended as new messages come in
     class ConsoleComponent : public Component {
-        class ConsoleMessage : public Component {
-
-            ConsoleComponent& console;
-
-        public:
-            int idx;
-
-            ConsoleMessage(int index, ConsoleComponent& parent)
-                : console(parent)
-                , idx(index)
-            {
-                parent.addAndMakeVisible(this);
-            }
-
-            void mouseDown(MouseEvent const& e) override
-            {
-                if (!e.mods.isShiftDown() && !e.mods.isCommandDown()) {
-                    console.selectedItems.clear();
-                }
-
-                auto& [object, message, type, length, repeats] = console.pd->getConsoleMessages()[idx];
-                if (e.mods.isPopupMenu()) {
-
-                    PopupMenu menu;
-                    menu.addItem("Copy", [this]() { console.copySelectionToClipboard(); });
-                    menu.addItem("Show origin", object != nullptr, false, [this, target = object]() {
-                        auto* editor = findParentComponentOfClass<PluginEditor>();
-                        editor->highlightSearchTarget(target, true);
-                    });
-                    menu.showMenuAsync(PopupMenu::Options());
-                }
-
-                if (e.mods.isShiftDown()) {
-                    int startIdx = console.messages.size();
-                    int endIdx = idx;
-                    for (auto& item : console.selectedItems) {
-                        startIdx = std::min(item->idx, startIdx);
-                    }
-                    for (int i = std::min(startIdx, endIdx); i < std::max(startIdx, endIdx); i++) {
-                        console.selectedItems.add_unique(SafePointer(console.messages[i].get()));
-                    }
-                }
-
-                console.selectedItems.add_unique(SafePointer(this));
-                console.repaint();
-            }
-
-            void paint(Graphics& g) override
-            {
-                auto isSelected = console.selectedItems.contains(this);
-                auto showMessages = getValue<bool>(console.settingsValues[2]);
-                auto showErrors = getValue<bool>(console.settingsValues[3]);
-
-                if (isSelected) {
-                    // Draw selected background
-                    g.setColour(findColour(PlugDataColour::sidebarActiveBackgroundColourId));
-                    g.fillRoundedRectangle(getLocalBounds().reduced(0, 1).toFloat().withTrimmedTop(0.5f), Corners::defaultCornerRadius);
-
-                    for (auto& item : console.selectedItems) {
-
-                        if (!item.getComponent())
-                            return;
-                        // Draw connected on top
-                        if (item->idx == idx - 1) {
-                            g.setColour(findColour(PlugDataColour::sidebarActiveBackgroundColourId));
-                            g.fillRect(getLocalBounds().toFloat().withTrimmedBottom(5));
-
-                            g.setColour(findColour(PlugDataColour::outlineColourId));
-                            g.drawLine(10, 0, getWidth() - 10, 0);
-                        }
-
-                        // Draw connected on bottom
-                        if (item->idx == idx + 1) {
-                            g.setColour(findColour(PlugDataColour::sidebarActiveBackgroundColourId));
-                            g.fillRect(getLocalBounds().toFloat().withTrimmedTop(5));
-                        }
-                    }
-                }
-
-                // Get console message
-                auto& [object, message, type, length, repeats] = console.pd->getConsoleMessages()[idx];
-
-                // Check if message type should be visible
-                if ((type == 0 && !showMessages) || (type == 1 && !showErrors)) {
-                    return;
-                }
-
-                // Approximate number of lines from string length and current width
-                auto totalLength = length + calculateRepeatOffset(repeats);
-                auto numLines = Console::calculateNumLines(message, totalLength, console.getWidth());
-
-                auto textColour = findColour(PlugDataColour::sidebarTextColourId);
-
-                if (type == 1)
-                    textColour = Colours::orange;
-                else if (type == 2)
-                    textColour = Colours::red;
-
-                auto bounds = getLocalBounds().reduced(8, 2);
-                if (repeats > 1) {
-
-                    auto repeatIndicatorBounds = bounds.removeFromLeft(calculateRepeatOffset(repeats)).toFloat().translated(-4, 0.25);
-                    repeatIndicatorBounds = repeatIndicatorBounds.withSizeKeepingCentre(repeatIndicatorBounds.getWidth(), 21);
-
-                    auto circleColour = findColour(PlugDataColour::sidebarActiveBackgroundColourId);
-                    auto backgroundColour = findColour(PlugDataColour::sidebarBackgroundColourId);
-                    auto contrast = isSelected ? 1.5f : 0.5f;
+        StackArray<Value, 5>& settingsValues;
+        Viewport& viewport;
 
-                    circleColour = Colour(circleColour.getRed() + (circleColour.getRed() - backgroundColour.getRed()) * contrast,
-                        circleColour.getGreen() + (circleColour.getGreen() - backgroundColour.getGreen()) * contrast,
-                        circleColour.getBlue() + (circleColour.getBlue() - backgroundColour.getBlue()) * contrast);
+        pd::Instance* pd; // instance to get console messages from
 
-                    g.setColour(circleColour);
-                    auto circleBounds = repeatIndicatorBounds.reduced(2);
-                    g.fillRoundedRectangle(circleBounds, circleBounds.getHeight() / 2.0f);
+        // Sequence numbers of the messages that pass the filter, and the bottom of each row
+        std::deque<uint64> rows;
+        std::deque<int64> rowEnds;
 
-                    Fonts::drawText(g, String(repeats), repeatIndicatorBounds, findColour(PlugDataColour::sidebarTextColourId), 12, Justification::centred);
-                }
+        // Height of the rows that were removed from the top
+        int64 removedHeight = 0;
 
-                // Draw text
-                Fonts::drawFittedText(g, message, bounds.translated(0, -1), textColour, numLines, 0.9f, 14);
-            }
-        };
+        // Range of message sequence numbers that we have already filtered
+        uint64 indexedFrom = 0;
+        uint64 indexedUpTo = 0;
 
-        StackArray<Value, 5>& settingsValues;
-        Viewport& viewport;
+        // Filter and width that the current rows were laid out with
+        bool indexShowsMessages = true;
+        bool indexShowsErrors = true;
+        void* indexedObject = nullptr;
+        int layoutWidth = 0;
 
-        pd::Instance* pd; // instance to get console messages from
     public:
-        std::deque<std::unique_ptr<ConsoleMessage>> messages;
-        SmallArray<SafePointer<ConsoleMessage>> selectedItems;
+        UnorderedSet<uint64> selectedMessages;
+
+        // When set, only messages from this object are shown
+        void* objectFilter = nullptr;
 
         ConsoleComponent(pd::Instance* instance, StackArray<Value, 5>& b, Viewport& v)
             : settingsValues(b)
@@ -325,17 +223,18 @@ public:
 
         void focusLost(FocusChangeType cause) override
         {
-            selectedItems.clear();
+            selectedMessages.clear();
             repaint();
         }
 
         void copySelectionToClipboard()
         {
+            auto& messages = pd->getConsoleMessages();
+
             String textToCopy;
-            for (auto& item : selectedItems) {
-                if (!item.getComponent())
-                    continue;
-                textToCopy += std::get<1>(pd->getConsoleMessages()[item->idx]) + "\n";
+            for (auto seq : rows) {
+                if (selectedMessages.contains(seq))
+                    textToCopy += messages[seq].text + "\n";
             }
 
             SystemClipboard::copyTextToClipboard(textToCopy.trimEnd());
@@ -349,10 +248,10 @@ public:
                 return true;
             }
             if (key == KeyPress('a', ModifierKeys::commandModifier, 0)) {
-                for (auto& message : messages) {
-                    selectedItems.add_unique(SafePointer(message.get()));
-                    repaint();
+                for (auto seq : rows) {
+                    selectedMessages.insert(seq);
                 }
+                repaint();
                 return true;
             }
 
@@ -361,60 +260,105 @@ public:
 
         void update()
         {
-            while (messages.size() > pd->getConsoleMessages().size() || messages.size() >= 800) {
-                messages.pop_front();
+            auto& messages = pd->getConsoleMessages();
+            auto showMessages = getValue<bool>(settingsValues[2]);
+            auto showErrors = getValue<bool>(settingsValues[3]);
 
-                // Make sure we don't trigger a repaint for all messages when the console is full
-                for (auto const& message : messages) {
-                    message->idx--;
-                }
+            // Restoring the console, or changing the filter or width, requires filtering and laying out all rows again
+            if (messages.getStart() < indexedFrom || showMessages != indexShowsMessages || showErrors != indexShowsErrors || objectFilter != indexedObject || getWidth() != layoutWidth) {
+                rows.clear();
+                rowEnds.clear();
+                removedHeight = 0;
+                indexedFrom = indexedUpTo = messages.getStart();
+                indexShowsMessages = showMessages;
+                indexShowsErrors = showErrors;
+                indexedObject = objectFilter;
+                layoutWidth = getWidth();
             }
 
-            while (messages.size() < pd->getConsoleMessages().size()) {
-                messages.push_back(std::make_unique<ConsoleMessage>(messages.size(), *this));
+            // Remove rows for messages that were cleared or pushed out of the store
+            indexedFrom = std::max(indexedFrom, messages.getStart());
+            indexedUpTo = std::max(indexedUpTo, indexedFrom);
+            while (!rows.empty() && rows.front() < indexedFrom) {
+                removedHeight = rowEnds.front();
+                rows.pop_front();
+                rowEnds.pop_front();
             }
 
+            // The last message might have been repeated since the last update, which can change its height
+            if (!rows.empty()) {
+                indexedUpTo = std::min(indexedUpTo, rows.back());
+                rows.pop_back();
+                rowEnds.pop_back();
+            }
+
+            for (auto seq = indexedUpTo; seq < messages.getEnd(); seq++) {
+                auto& message = messages[seq];
+                if ((message.type == 0 && !showMessages) || (message.type == 1 && !showErrors))
+                    continue;
+                if (objectFilter && message.object != objectFilter)
+                    continue;
+
+                auto top = rowEnds.empty() ? removedHeight : rowEnds.back();
+                rows.push_back(seq);
+                rowEnds.push_back(top + getRowHeight(message));
+            }
+            indexedUpTo = messages.getEnd();
+
             setSize(getWidth(), std::max<int>(getTotalHeight(), viewport.getHeight()));
-            resized();
 
             if (getValue<bool>(settingsValues[4])) {
                 viewport.setViewPositionProportionately(0.0f, 1.0f);
             }
+
+            repaint();
         }
 
         void clear()
         {
-            pd->getConsoleHistory().insert(pd->getConsoleHistory().end(), pd->getConsoleMessages().begin(), pd->getConsoleMessages().end());
             pd->getConsoleMessages().clear();
+            selectedMessages.clear();
             update();
         }
 
         void restore()
         {
-            pd->getConsoleMessages().insert(pd->getConsoleMessages().begin(), pd->getConsoleHistory().begin(), pd->getConsoleHistory().end());
-            pd->getConsoleHistory().clear();
+            pd->getConsoleMessages().restore();
             update();
         }
 
         // Get total height of messages, also taking multi-line messages into account
-        int getTotalHeight()
+        int getTotalHeight() const
         {
-            auto showMessages = getValue<bool>(settingsValues[2]);
-            auto showErrors = getValue<bool>(settingsValues[3]);
-            auto totalHeight = 0;
+            return static_cast<int>(rowEnds.empty() ? 0 : rowEnds.back() - removedHeight) + 8;
+        }
 
-            for (auto& [object, message, type, length, repeats] : pd->getConsoleMessages()) {
-                auto totalLength = length + calculateRepeatOffset(repeats);
-                auto numLines = Console::calculateNumLines(message, totalLength, getWidth());
-                auto height = numLines * 13 + 12;
+        int getRowHeight(pd::ConsoleMessageStore::Message const& message) const
+        {
+            return Console::calculateNumLines(message, getWidth()) * 13 + 12;
+        }
 
-                if ((type == 0 && !showMessages) || (type == 1 && !showErrors))
-                    continue;
+        Rectangle<int> getRowBounds(int row) const
+        {
+            auto top = row == 0 ? removedHeight : rowEnds[row - 1];
+            int rightMargin = viewport.canScrollVertically() ? 13 : 11;
+            return { 6, static_cast<int>(top - removedHeight) + 4, getWidth() - rightMargin, static_cast<int>(rowEnds[row] - top) };
+        }
 
-                totalHeight += std::max(0, height);
-            }
+        // Returns the row at a vertical position, or -1 if there is no row there
+        int getRowAt(int y) const
+        {
+            auto it = std::upper_bound(rowEnds.begin(), rowEnds.end(), static_cast<int64>(y - 4) + removedHeight);
+            if (it == rowEnds.end() || y < 4)
+                return -1;
+
+            return static_cast<int>(it - rowEnds.begin());
+        }
 
-            return totalHeight + 8;
+        int getRowForMessage(uint64 seq) const
+        {
+            auto it = std::lower_bound(rows.begin(), rows.end(), seq);
+            return it != rows.end() && *it == seq ? static_cast<int>(it - rows.begin()) : -1;
         }
 
         static int calculateRepeatOffset(int numRepeats)
@@ -428,37 +372,138 @@ public:
 
         void mouseDown(MouseEvent const& e) override
         {
-            if (!e.mods.isLeftButtonDown())
+            auto row = getRowAt(e.y);
+            if (row < 0) {
+                if (e.mods.isLeftButtonDown()) {
+                    selectedMessages.clear();
+                    repaint();
+                }
                 return;
+            }
+
+            if (!e.mods.isShiftDown() && !e.mods.isCommandDown()) {
+                selectedMessages.clear();
+            }
 
-            selectedItems.clear();
+            auto seq = rows[row];
+            auto* object = pd->getConsoleMessages()[seq].object;
+            if (e.mods.isPopupMenu()) {
+                PopupMenu menu;
+                menu.addItem("Copy", [this]() { copySelectionToClipboard(); });
+                menu.addItem("Show origin", object != nullptr, false, [this, target = object]() {
+                    auto* editor = findParentComponentOfClass<PluginEditor>();
+                    editor->highlightSearchTarget(target, true);
+                });
+                menu.addSeparator();
+                menu.addItem("Only show messages from origin", object != nullptr, objectFilter != nullptr && objectFilter == object, [this, target = object]() {
+                    objectFilter = objectFilter == target ? nullptr : target;
+                    update();
+                });
+                menu.addItem("Show messages from all objects", objectFilter != nullptr, false, [this]() {
+                    objectFilter = nullptr;
+                    update();
+                });
+                menu.showMenuAsync(PopupMenu::Options());
+            }
+
+            if (e.mods.isShiftDown()) {
+                int startIdx = row;
+                for (auto selected : selectedMessages) {
+                    auto selectedRow = getRowForMessage(selected);
+                    if (selectedRow >= 0)
+                        startIdx = std::min(selectedRow, startIdx);
+                }
+                for (int i = startIdx; i < row; i++) {
+                    selectedMessages.insert(rows[i]);
+                }
+            }
+
+            selectedMessages.insert(seq);
             repaint();
         }
 
         void resized() override
         {
-            auto showMessages = getValue<bool>(settingsValues[2]);
-            auto showErrors = getValue<bool>(settingsValues[3]);
+            if (getWidth() != layoutWidth)
+                update();
+        }
 
-            int totalHeight = 4;
-            for (int row = 0; row < static_cast<int>(pd->getConsoleMessages().size()); row++) {
-                if (row >= messages.size())
+        void paint(Graphics& g) override
+        {
+            auto clip = g.getClipBounds();
+            auto row = std::max(getRowAt(clip.getY()), 0);
+
+            for (; row < static_cast<int>(rows.size()); row++) {
+                auto bounds = getRowBounds(row);
+                if (bounds.getY() > clip.getBottom())
                     break;
 
-                auto& [object, message, type, length, repeats] = pd->getConsoleMessages()[row];
+                paintRow(g, row, bounds);
+            }
+        }
 
-                auto totalLength = length + calculateRepeatOffset(repeats);
-                auto numLines = Console::calculateNumLines(message, totalLength, getWidth());
-                auto height = numLines * 13 + 12;
+        void paintRow(Graphics& g, int row, Rectangle<int> rowBounds)
+        {
+            auto& message = pd->getConsoleMessages()[rows[row]];
+            auto isSelected = selectedMessages.contains(rows[row]);
+            auto localBounds = rowBounds.withZeroOrigin();
 
-                if ((type == 0 && !showMessages) || (type == 1 && !showErrors))
-                    continue;
+            Graphics::ScopedSaveState saveState(g);
+            g.setOrigin(rowBounds.getPosition());
+
+            if (isSelected) {
+                // Draw selected background
+                g.setColour(findColour(PlugDataColour::sidebarActiveBackgroundColourId));
+                g.fillRoundedRectangle(localBounds.reduced(0, 1).toFloat().withTrimmedTop(0.5f), Corners::defaultCornerRadius);
+
+                // Draw connected on top
+                if (row > 0 && selectedMessages.contains(rows[row - 1])) {
+                    g.setColour(findColour(PlugDataColour::sidebarActiveBackgroundColourId));
+                    g.fillRect(localBounds.toFloat().withTrimmedBottom(5));
+
+                    g.setColour(findColour(PlugDataColour::outlineColourId));
+                    g.drawLine(10, 0, rowBounds.getWidth() - 10, 0);
+                }
+
+                // Draw connected on bottom
+                if (row + 1 < static_cast<int>(rows.size()) && selectedMessages.contains(rows[row + 1])) {
+                    g.setColour(findColour(PlugDataColour::sidebarActiveBackgroundColourId));
+                    g.fillRect(localBounds.toFloat().withTrimmedTop(5));
+                }
+            }
+
+            auto numLines = Console::calculateNumLines(message, getWidth());
+
+            auto textColour = findColour(PlugDataColour::sidebarTextColourId);
+
+            if (message.type == 1)
+                textColour = Colours::orange;
+            else if (message.type == 2)
+                textColour = Colours::red;
+
+            auto bounds = localBounds.reduced(8, 2);
+            if (message.repeats > 1) {
 
-                int rightMargin = viewport.canScrollVertically() ? 13 : 11;
-                messages[row]->setBounds(6, totalHeight, getWidth() - rightMargin, height);
+                auto repeatIndicatorBounds = bounds.removeFromLeft(calculateRepeatOffset(message.repeats)).toFloat().translated(-4, 0.25);
+                repeatIndicatorBounds = repeatIndicatorBounds.withSizeKeepingCentre(repeatIndicatorBounds.getWidth(), 21);
 
-                totalHeight += height;
+                auto circleColour = findColour(PlugDataColour::sidebarActiveBackgroundColourId);
+                auto backgroundColour = findColour(PlugDataColour::sidebarBackgroundColourId);
+                auto contrast = isSelected ? 1.5f : 0.5f;
+
+                circleColour = Colour(circleColour.getRed() + (circleColour.getRed() - backgroundColour.getRed()) * contrast,
+                    circleColour.getGreen() + (circleColour.getGreen() - backgroundColour.getGreen()) * contrast,
+                    circleColour.getBlue() + (circleColour.getBlue() - backgroundColour.getBlue()) * contrast);
+
+                g.setColour(circleColour);
+                auto circleBounds = repeatIndicatorBounds.reduced(2);
+                g.fillRoundedRectangle(circleBounds, circleBounds.getHeight() / 2.0f);
+
+                Fonts::drawText(g, String(message.repeats), repeatIndicatorBounds, findColour(PlugDataColour::sidebarTextColourId), 12, Justification::centred);
             }
+
+            // Draw text
+            Fonts::drawFittedText(g, message.text, bounds.translated(0, -1), textColour, numLines, 0.9f, 14);
         }
 
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ConsoleComponent)
@@ -478,12 +523,12 @@ public:
         return std::unique_ptr<TextButton>(settingsCalloutButton);
     }
 
-    static int calculateNumLines(String& message, int length, int maxWidth)
+    static int calculateNumLines(pd::ConsoleMessageStore::Message const& message, int maxWidth)
     {
         maxWidth -= 38.0f;
-        if (message.containsAnyOf("\n\r") && message.containsNonWhitespaceChars()) {
+        if (message.numLines > 1 && message.text.containsNonWhitespaceChars()) {
             int numLines = 0;
-            for (auto line : StringArray::fromLines(message)) {
+            for (auto line : StringArray::fromLines(message.text)) {
                 numLines++;
                 int lineWidth = CachedStringWidth<14>::calculateSingleLineWidth(line);
                 while (lineWidth > maxWidth && numLines < 64) {
@@ -493,12 +538,9 @@ public:
             }
             return numLines;
         } else {
-            if (length == 0)
-                return 0;
+            auto length = message.width + ConsoleComponent::calculateRepeatOffset(message.repeats);
             return std::max<int>(round(static_cast<float>(length) / maxWidth), 1);
         }
-
-        return 1;
     }
 
 private:
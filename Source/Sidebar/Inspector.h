@@ -48,29 +48,18 @@ class Inspector : public Component {
 
         void valueChanged(Value& v) override
         {
-            pd::Patch* currentPatch = nullptr;
-            if (auto* editor = inspector->findParentComponentOfClass<PluginEditor>()) {
-                if (auto* cnv = editor->getCurrentCanvas()) {
-                    currentPatch = &cnv->patch;
-                }
-            }
-
             for (auto* property : properties) {
                 if (property->baseValue.refersToSameSourceAs(v)) {
-                    bool isInsideUndoSequence = false;
-                    if (currentPatch && !lastChangedValue.refersToSameSourceAs(v)) {
-                        currentPatch->startUndoSequence("properties");
-                        lastChangedValue.referTo(v);
-                        isInsideUndoSequence = true;
-                    }
-
-                    for (auto* value : property->values) {
-                        value->setValue(v.getValue());
-                    }
-
-                    if (isInsideUndoSequence) {
-                        currentPatch->endUndoSequence("properties");
-                    }
+                    // Only the first change to a property needs an undo sequence, the objects won't add undo actions for repeated changes
+                    auto const isNewChange = !lastChangedValue.refersToSameSourceAs(v);
+                    lastChangedValue.referTo(v);
+
+                    auto const newValue = v.getValue();
+                    inspector->applyToSelection(isNewChange, [property, &newValue]() {
+                        for (auto* value : property->values) {
+                            value->setValue(newValue);
+                        }
+                    });
                     break;
                 }
             }
@@ -225,15 +214,41 @@ public:
         return true;
     }
 
+    // Applies a change to all selected objects inside one undo sequence
+    // The objects' property changes are collected while the panel values update, and applied to Pd in one batch under a single lock
+    template<typename ApplyFn>
+    void applyToSelection(bool withUndoSequence, ApplyFn const& applyChanges)
+    {
+        auto* editor = findParentComponentOfClass<PluginEditor>();
+        auto* cnv = editor ? editor->getCurrentCanvas() : nullptr;
+        if (!cnv) {
+            applyChanges();
+            return;
+        }
+
+        if (withUndoSequence)
+            cnv->patch.startUndoSequence("properties");
+
+        {
+            ObjectBase::PropertyChangeBatch batch(cnv->pd);
+            applyChanges();
+        }
+
+        if (withUndoSequence)
+            cnv->patch.endUndoSequence("properties");
+    }
+
     std::unique_ptr<Component> getExtraSettingsComponent()
     {
         auto* resetButton = new SmallIconButton(Icons::Reset);
         resetButton->setTooltip("Reset to default");
         resetButton->setSize(23, 23);
         resetButton->onClick = [this]() {
-            for (auto& propertiesList : properties) {
-                propertiesList.resetAll();
-            }
+            applyToSelection(true, [this]() {
+                for (auto& propertiesList : properties) {
+                    propertiesList.resetAll();
+                }
+            });
         };
 
         return std::unique_ptr<TextButton>(resetButton);
@@ -116,12 +116,445 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SearchPanelSettings);
 };
 
+// Keeps the search entries of every canvas in the patch hierarchy, so that only canvases that changed have to be read from Pd again
+// Selection state and the top-level object of each entry depend on the current canvas, so those are added when the tree is created
+class PatchSearchIndex {
+    struct Entry {
+        t_gobj* object = nullptr;
+        t_glist* subpatch = nullptr;
+        ValueTree element = ValueTree("Object");
+    };
+
+    struct IndexedCanvas {
+        explicit IndexedCanvas(pd::WeakReference ref)
+            : canvas(std::move(ref))
+        {
+        }
+
+        pd::WeakReference canvas;
+        SmallArray<Entry> entries;
+        bool needsUpdate = true;
+    };
+
+public:
+    explicit PatchSearchIndex(pd::Instance* instance)
+        : pd(instance)
+    {
+    }
+
+    // Marks a canvas as changed, it will be read again on the next update
+    void invalidate(t_glist* glist)
+    {
+        auto it = canvases.find(glist);
+        if (it != canvases.end())
+            it->second->needsUpdate = true;
+    }
+
+    void clear()
+    {
+        canvases.clear();
+    }
+
+    // Reads all canvases below the root that have changed, or haven't been indexed yet
+    // The audio thread is only locked while reading a single canvas
+    void update(t_glist* root)
+    {
+        auto it = canvases.find(root);
+        if (it == canvases.end() || !it->second->canvas.isValid()) {
+            removeCanvas(root);
+            canvases[root] = std::make_unique<IndexedCanvas>(pd::WeakReference(root, pd));
+        }
+
+        updateCanvas(root);
+    }
+
+    // Creates the tree for the search panel, without accessing Pd
+    ValueTree createTree(t_glist* root, UnorderedSet<void*> const& selection) const
+    {
+        ValueTree tree("Patch");
+        appendEntries(tree, root, selection, nullptr);
+        return tree;
+    }
+
+private:
+    void updateCanvas(t_glist* glist)
+    {
+        auto it = canvases.find(glist);
+        if (it == canvases.end())
+            return;
+
+        auto* indexed = it->second.get();
+        if (indexed->needsUpdate) {
+            auto oldEntries = std::move(indexed->entries);
+
+            if (auto patch = indexed->canvas.get<t_glist>()) {
+                indexed->entries = readEntries(patch.get());
+                indexed->needsUpdate = false;
+            } else {
+                // The canvas was deleted without its parent being updated
+                indexed->entries.clear();
+            }
+
+            // Forget subpatches that were removed from this canvas
+            for (auto& entry : oldEntries) {
+                if (entry.subpatch && !std::any_of(indexed->entries.begin(), indexed->entries.end(), [subpatch = entry.subpatch](Entry const& newEntry) { return newEntry.subpatch == subpatch; }))
+                    removeCanvas(entry.subpatch);
+            }
+        }
+
+        for (auto& entry : indexed->entries) {
+            if (entry.subpatch)
+                updateCanvas(entry.subpatch);
+        }
+    }
+
+    void addSubpatch(t_glist* subpatch)
+    {
+        auto it = canvases.find(subpatch);
+        if (it != canvases.end() && it->second->canvas.isValid())
+            return;
+
+        // Either a new subpatch, or a new canvas that was allocated where a deleted one used to be
+        removeCanvas(subpatch);
+        canvases[subpatch] = std::make_unique<IndexedCanvas>(pd::WeakReference(subpatch, pd));
+    }
+
+    void removeCanvas(t_glist* glist)
+    {
+        auto it = canvases.find(glist);
+        if (it == canvases.end())
+            return;
+
+        auto removed = std::move(it->second);
+        canvases.erase(it);
+
+        for (auto& entry : removed->entries) {
+            if (entry.subpatch)
+                removeCanvas(entry.subpatch);
+        }
+    }
+
+    void appendEntries(ValueTree& parent, t_glist* glist, UnorderedSet<void*> const& selection, void* topLevel) const
+    {
+        auto it = canvases.find(glist);
+        if (it == canvases.end())
+            return;
+
+        for (auto& entry : it->second->entries) {
+            auto* top = topLevel ? topLevel : entry.object;
+            auto element = entry.element.createCopy();
+
+            if (entry.subpatch)
+                appendEntries(element, entry.subpatch, selection, top);
+
+            if (selection.contains(entry.object))
+                element.setProperty("Selected", true, nullptr);
+
+            element.setProperty("TopLevel", reinterpret_cast<int64>(top), nullptr);
+            parent.appendChild(element, nullptr);
+        }
+    }
+
+    // Reads the search entries of a single canvas, should be called with the audio thread locked
+    SmallArray<Entry> readEntries(t_glist* patch)
+    {
+        SmallArray<Entry> entries;
+        int index = 0;
+
+        for (t_gobj* gobj = patch->gl_list; gobj; gobj = gobj->g_next) {
+            auto* object = &gobj->g_pd;
+            String type = String::fromUTF8(pd::Interface::getObjectClassName(object));
+
+            if (!pd::Interface::checkObject(object))
+                continue;
+
+            char* objectText;
+            int len;
+            pd::Interface::getObjectText(pd::Interface::checkObject(object), &objectText, &len);
+
+            int x, y, w, h;
+            pd::Interface::getObjectBounds(patch, gobj, &x, &y, &w, &h);
+
+            auto name = String::fromUTF8(objectText, len);
+            freebytes(objectText, len);
+
+            auto nameWithoutArgs = name.upToFirstOccurrenceOf(" ", false, false);
+            auto positionText = " (" + String(x) + ":" + String(y) + ")";
+
+            Entry entry;
+            entry.object = gobj;
+
+            auto getFirstArgumentFromFullName = [](String const& fullName) -> String {
+                return fullName.fromFirstOccurrenceOf(" ", false, true).upToFirstOccurrenceOf(" ", false, true);
+            };
+
+            auto& element = entry.element;
+            if (type == "canvas" || type == "graph") {
+                auto* patchPtr = reinterpret_cast<t_glist*>(gobj);
+                entry.subpatch = patchPtr;
+                addSubpatch(patchPtr);
+
+                if (patchPtr->gl_list) {
+                    t_class* c = patchPtr->gl_list->g_pd;
+                    if (c && c->c_name && (String::fromUTF8(c->c_name->s_name) == "array")) {
+                        StringArray arrays;
+                        auto arrayIt = patchPtr->gl_list;
+                        while (arrayIt) {
+                            if (auto* array = reinterpret_cast<t_fake_garray*>(arrayIt))
+                                arrays.add(String::fromUTF8(array->x_name->s_name));
+                            arrayIt = arrayIt->g_next;
+                        }
+                        String formatedArraysText;
+                        for (int i = 0; i < arrays.size(); i++) {
+                            formatedArraysText += arrays[i] + String(i < arrays.size() - 1 ? ", " : "");
+                        }
+                        name = "array: " + formatedArraysText;
+                    } else if (patchPtr->gl_isgraph) {
+                        name = nameWithoutArgs;
+                    }
+                } else if (patchPtr->gl_isgraph) {
+                    name = nameWithoutArgs;
+                }
+#ifdef SHOW_PD_SUBPATCH_SYMBOL
+                if (nameWithoutArgs == "pd") {
+                    auto arg = getFirstArgumentFromFullName(name);
+                    if (arg.isNotEmpty())
+                        element.setProperty("PDSymbol", nameWithoutArgs + "-" + arg, nullptr);
+                }
+#endif
+                element.setProperty("ObjectName", name, nullptr);
+                element.setProperty("Name", name, nullptr);
+                element.setProperty("RightText", positionText, nullptr);
+                element.setProperty("Icon", canvas_isabstraction(patchPtr) ? Icons::File : Icons::Object, nullptr);
+                element.setProperty("Object", reinterpret_cast<int64>(gobj), nullptr);
+                element.setProperty("Index", index, nullptr);
+
+                index++;
+            } else {
+                String objectName = type;
+                String finalFormatedName;
+                String sendSymbol;
+                String receiveSymbol;
+
+                switch (hash(type)) {
+                // IEM send-receive symbols
+                case hash("bng"):
+                case hash("hsl"):
+                case hash("vsl"):
+                case hash("slider"):
+                case hash("tgl"):
+                case hash("nbx"):
+                case hash("vradio"):
+                case hash("hradio"):
+                case hash("vu"):
+                case hash("cnv"): {
+                    if (auto* iemgui = reinterpret_cast<t_iemgui*>(gobj)) {
+                        t_symbol* srlsym[3];
+                        iemgui_all_sym2dollararg(iemgui, srlsym);
+                        if (srl_is_valid(srlsym[0])) {
+                            sendSymbol = String::fromUTF8(iemgui->x_snd_unexpanded->s_name);
+                        }
+                        if (srl_is_valid(srlsym[1])) {
+                            receiveSymbol = String::fromUTF8(iemgui->x_rcv_unexpanded->s_name);
+                        }
+                    }
+                    finalFormatedName = nameWithoutArgs;
+                    break;
+                }
+                case hash("keyboard"): {
+                    if (auto* keyboardObject = reinterpret_cast<t_fake_keyboard*>(gobj)) {
+                        sendSymbol = String(keyboardObject->x_send->s_name);
+                        receiveSymbol = String(keyboardObject->x_receive->s_name);
+                    }
+                    finalFormatedName = nameWithoutArgs;
+                    break;
+                }
+                case hash("pic"): {
+                    if (auto* picObject = reinterpret_cast<t_fake_pic*>(gobj)) {
+                        sendSymbol = String(picObject->x_send->s_name);
+                        receiveSymbol = String(picObject->x_receive->s_name);
+                    }
+                    finalFormatedName = nameWithoutArgs;
+                    break;
+                }
+                case hash("scope~"): {
+                    if (auto* scopeObject = reinterpret_cast<t_fake_scope*>(gobj)) {
+                        receiveSymbol = String(scopeObject->x_receive->s_name);
+                    }
+                    finalFormatedName = nameWithoutArgs;
+                    break;
+                }
+                case hash("function"): {
+                    if (auto* functionObject = reinterpret_cast<t_fake_function*>(gobj)) {
+                        sendSymbol = String(functionObject->x_send->s_name);
+                        receiveSymbol = String(functionObject->x_receive->s_name);
+                    }
+                    finalFormatedName = nameWithoutArgs;
+                    break;
+                }
+                case hash("note"): {
+                    if (auto* noteObject = reinterpret_cast<t_fake_note*>(gobj)) {
+                        receiveSymbol = String(noteObject->x_receive->s_name);
+                    }
+                    finalFormatedName = nameWithoutArgs;
+                    break;
+                }
+                case hash("knob"): {
+                    if (auto* knobObj = reinterpret_cast<t_fake_knob*>(gobj)) {
+                        sendSymbol = String(knobObj->x_snd->s_name);
+                        receiveSymbol = String(knobObj->x_rcv->s_name);
+                    }
+                    finalFormatedName = nameWithoutArgs;
+                    break;
+                }
+                case hash("gatom"): {
+                    auto* gatomObject = reinterpret_cast<t_fake_gatom*>(gobj);
+                    String gatomName;
+                    switch (gatomObject->a_flavor) {
+                    case A_FLOAT:
+                        gatomName = "floatbox";
+                        break;
+                    case A_SYMBOL:
+                        gatomName = "symbolbox";
+                        break;
+                    case A_NULL:
+                        gatomName = "listbox";
+                        break;
+                    default:
+                        break;
+                    }
+                    receiveSymbol = String(gatomObject->a_symfrom->s_name);
+                    sendSymbol = String(gatomObject->a_symto->s_name);
+                    finalFormatedName = gatomName;
+                    objectName = gatomName;
+                    break;
+                }
+                case hash("message"): {
+                    finalFormatedName = "msg: " + name;
+                    break;
+                }
+                case hash("comment"): {
+                    finalFormatedName = "comment: " + name;
+                    break;
+                }
+                case hash("text"): {
+                    switch (reinterpret_cast<t_fake_text_define*>(gobj)->x_textbuf.b_ob.te_type) {
+                    case T_TEXT: {
+                        // if object & classname is text, then it's a comment
+                        finalFormatedName = String("comment: ") + name;
+                        objectName = "comment";
+                        break;
+                    }
+                    case T_OBJECT: {
+                        // if object is T_OBJECT but classname is 'text' object is in error state
+                        element.setProperty("IconColour", Colours::red.toString(), nullptr);
+
+                        if (name.isEmpty()) {
+                            finalFormatedName = String("empty");
+                            objectName = "empty";
+                        } else {
+                            finalFormatedName = String("unknown: ") + name;
+                            objectName = "unknown";
+                        }
+                        break;
+                    }
+                    default:
+                        break;
+                    }
+                    break;
+                }
+                case hash("canvas"):
+                case hash("bicoeff"):
+                case hash("messbox"):
+                case hash("pad"):
+                case hash("button"): {
+                    finalFormatedName = nameWithoutArgs;
+                    break;
+                }
+
+                default: {
+                    switch (hash(nameWithoutArgs)) {
+                    case hash("s"):
+                    case hash("s~"):
+                    case hash("send"):
+                    case hash("send~"):
+                    case hash("throw~"): {
+                        sendSymbol = getFirstArgumentFromFullName(name);
+                        element.setProperty("SendObject", 1, nullptr);
+                        finalFormatedName = nameWithoutArgs;
+                        break;
+                    }
+                    case hash("r"):
+                    case hash("r~"):
+                    case hash("receive"):
+                    case hash("receive~"):
+                    case hash("catch~"): {
+                        receiveSymbol = getFirstArgumentFromFullName(name);
+                        element.setProperty("ReceiveObject", 1, nullptr);
+                        finalFormatedName = nameWithoutArgs;
+                        break;
+                    }
+                    case hash("t"):
+                    case hash("trigger"):
+                        element.setProperty("TriggerObject", 1, nullptr);
+                        finalFormatedName = name;
+                        break;
+                    case hash("v"):
+                    case hash("value"):
+                        element.setProperty("ValueObject", 1, nullptr);
+                        finalFormatedName = name;
+                        break;
+                    case hash("i"):
+                    case hash("int"):
+                        element.setProperty("IntObject", 1, nullptr);
+                        finalFormatedName = name;
+                        break;
+                    case hash("f"):
+                    case hash("float"):
+                        element.setProperty("FloatObject", 1, nullptr);
+                        finalFormatedName = name;
+                        break;
+                    default:
+                        finalFormatedName = name;
+                        break;
+                    }
+                    break;
+                }
+                }
+                element.setProperty("ObjectName", objectName, nullptr);
+                element.setProperty("Name", finalFormatedName, nullptr);
+                // Add send/receive tags if they exist
+                if (sendSymbol.isNotEmpty() && (sendSymbol != "empty") && (sendSymbol != "nosndno")) {
+                    element.setProperty("SendSymbol", sendSymbol, nullptr);
+                }
+                if (receiveSymbol.isNotEmpty() && (receiveSymbol != "empty")) {
+                    element.setProperty("ReceiveSymbol", receiveSymbol, nullptr);
+                }
+                element.setProperty("RightText", positionText, nullptr);
+                element.setProperty("Icon", Icons::Object, nullptr);
+                element.setProperty("Object", reinterpret_cast<int64>(gobj), nullptr);
+                element.setProperty("Index", index, nullptr);
+
+                index++;
+            }
+
+            entries.add(std::move(entry));
+        }
+
+        return entries;
+    }
+
+    pd::Instance* pd;
+    UnorderedMap<t_glist*, std::unique_ptr<IndexedCanvas>> canvases;
+};
+
 class SearchPanel : public Component
     , public KeyListener
     , public Timer {
 public:
     explicit SearchPanel(PluginEditor* pluginEditor)
         : editor(pluginEditor)
+        , searchIndex(pluginEditor->pd)
     {
         input.setBackgroundColour(PlugDataColour::sidebarActiveBackgroundColourId);
         input.setTextToShowWhenEmpty("Type to search in patch", findColour(PlugDataColour::sidebarTextColourId).withAlpha(0.5f));
@@ -211,10 +644,18 @@ public:
 
     void timerCallback() override
     {
+        // Canvases that were synchronised since the last update need to be read again
+        bool canvasChanged = false;
+        for (auto* cnv : editor->getCanvases()) {
+            if (cnv->needsSearchUpdate) {
+                searchIndex.invalidate(cnv->patch.getUncheckedPointer());
+                cnv->needsSearchUpdate = false;
+                canvasChanged = true;
+            }
+        }
+
         auto* cnv = editor->getCurrentCanvas();
-        if (cnv && (currentCanvas.getComponent() != cnv || cnv->needsSearchUpdate)) {
-            currentCanvas = cnv;
-            currentCanvas->needsSearchUpdate = false;
+        if (cnv && (currentCanvas.getComponent() != cnv || canvasChanged)) {
             updateResults();
         }
     }
@@ -222,6 +663,11 @@ public:
     void visibilityChanged() override
     {
         if (isVisible()) {
+            // We don't keep track of changes while hidden, so index everything again
+            searchIndex.clear();
+            for (auto* cnv : editor->getCanvases()) {
+                cnv->needsSearchUpdate = false;
+            }
             updateResults();
             startTimer(100);
         } else {
@@ -278,31 +724,29 @@ public:
     {
         auto* cnv = editor->getCurrentCanvas();
         if (cnv && isVisible()) {
-            cnv->pd->lockAudioThread(); // It locks inside of this anyway, so we might as well lock around it to prevent constantly locking/unlocking
+            currentCanvas = cnv;
 
             // Get the currently selected object
             auto selectedObj = patchTree.getSelectedNodeObject();
 
-            patchTree.setValueTree(generatePatchTree(cnv->refCountedPatch));
-
-            // If the object is still selected, reselect it
-            auto numSelectedObject = 0;
-            auto foundInCanvas = false;
+            UnorderedSet<void*> selection;
             for (auto item : cnv->getLassoSelection()) {
                 if (auto* obj = dynamic_cast<Object*>(item.get())) {
-                    numSelectedObject++;
-                    if (selectedObj == obj->getPointer()) {
-                        foundInCanvas = true;
-                    }
+                    selection.insert(obj->getPointer());
                 }
             }
-            if (foundInCanvas && numSelectedObject == 1)
+
+            auto* root = cnv->patch.getUncheckedPointer();
+            searchIndex.update(root);
+            patchTree.setValueTree(searchIndex.createTree(root, selection));
+
+            // If the object is still selected, reselect it
+            if (selection.size() == 1 && selection.contains(selectedObj))
                 patchTree.setSelectedNode(selectedObj);
             else
                 patchTree.setSelectedNode(nullptr);
 
             patchTree.filterNodes();
-            cnv->pd->unlockAudioThread();
             patchTree.repaint();
         }
     }
@@ -323,317 +767,9 @@ public:
         patchTree.setBounds(tableBounds);
     }
 
-    ValueTree generatePatchTree(pd::Patch::Ptr patch, void* topLevel = nullptr)
-    {
-        currentCanvas = editor->getCurrentCanvas();
-
-        ValueTree patchTree("Patch");
-
-        int index = 0;
-
-        for (auto objectPtr : patch->getObjects()) {
-            if (auto object = objectPtr.get<t_pd>()) {
-                auto* top = topLevel ? topLevel : object.get();
-                String type = String::fromUTF8(pd::Interface::getObjectClassName(object.get()));
-
-                if (!pd::Interface::checkObject(object.get()))
-                    continue;
-
-                char* objectText;
-                int len;
-                pd::Interface::getObjectText(object.cast<t_text>(), &objectText, &len);
-
-                int x, y, w, h;
-                pd::Interface::getObjectBounds(patch->getPointer().get(), object.cast<t_gobj>(), &x, &y, &w, &h);
-
-                auto name = String::fromUTF8(objectText, len);
-                auto nameWithoutArgs = name.upToFirstOccurrenceOf(" ", false, false);
-                auto positionText = " (" + String(x) + ":" + String(y) + ")";
-
-                auto getFirstArgumentFromFullName = [](String const& fullName) -> String {
-                    return fullName.fromFirstOccurrenceOf(" ", false, true).upToFirstOccurrenceOf(" ", false, true);
-                };
-
-                ValueTree element("Object");
-                if (type == "canvas" || type == "graph") {
-                    pd::Patch::Ptr subpatch = new pd::Patch(objectPtr, editor->pd, false);
-                    ValueTree subpatchTree = generatePatchTree(subpatch, top);
-                    element.copyPropertiesAndChildrenFrom(subpatchTree, nullptr);
-
-                    if (auto patchPtr = subpatch->getPointer()) {
-                        if (patchPtr->gl_list) {
-                            t_class* c = patchPtr->gl_list->g_pd;
-                            if (c && c->c_name && (String::fromUTF8(c->c_name->s_name) == "array")) {
-                                StringArray arrays;
-                                auto arrayIt = patchPtr->gl_list;
-                                while (arrayIt) {
-                                    if (auto* array = reinterpret_cast<t_fake_garray*>(arrayIt))
-                                        arrays.add(String::fromUTF8(array->x_name->s_name));
-                                    arrayIt = arrayIt->g_next;
-                                }
-                                String formatedArraysText;
-                                for (int i = 0; i < arrays.size(); i++) {
-                                    formatedArraysText += arrays[i] + String(i < arrays.size() - 1 ? ", " : "");
-                                }
-                                name = "array: " + formatedArraysText;
-                            } else if (patchPtr->gl_isgraph) {
-                                name = nameWithoutArgs;
-                            }
-                        } else if (patchPtr->gl_isgraph) {
-                            name = nameWithoutArgs;
-                        }
-                    }
-#ifdef SHOW_PD_SUBPATCH_SYMBOL
-                    if (nameWithoutArgs == "pd") {
-                        auto arg = getFirstArgumentFromFullName(name);
-                        if (arg.isNotEmpty())
-                            element.setProperty("PDSymbol", nameWithoutArgs + "-" + arg, nullptr);
-                    }
-#endif
-                    element.setProperty("ObjectName", name, nullptr);
-                    element.setProperty("Name", name, nullptr);
-                    element.setProperty("RightText", positionText, nullptr);
-                    element.setProperty("Icon", canvas_isabstraction(subpatch->getPointer().get()) ? Icons::File : Icons::Object, nullptr);
-                    element.setProperty("Object", reinterpret_cast<int64>(object.cast<void>()), nullptr);
-                    if (currentCanvas) {
-                        for (auto comp : currentCanvas->getLassoSelection()) {
-                            if (auto obj = dynamic_cast<Object*>(comp.get())) {
-                                if (obj->getPointer() == object.cast<t_gobj>()) {
-                                    element.setProperty("Selected", true, nullptr);
-                                }
-                            }
-                        }
-                    }
-                    element.setProperty("TopLevel", reinterpret_cast<int64>(top), nullptr);
-                    element.setProperty("Index", index, nullptr);
-
-                    index++;
-                } else {
-                    String objectName = type;
-                    String finalFormatedName;
-                    String sendSymbol;
-                    String receiveSymbol;
-
-                    switch (hash(type)) {
-                    // IEM send-receive symbols
-                    case hash("bng"):
-                    case hash("hsl"):
-                    case hash("vsl"):
-                    case hash("slider"):
-                    case hash("tgl"):
-                    case hash("nbx"):
-                    case hash("vradio"):
-                    case hash("hradio"):
-                    case hash("vu"):
-                    case hash("cnv"): {
-                        if (auto iemgui = objectPtr.get<t_iemgui>()) {
-                            t_symbol* srlsym[3];
-                            iemgui_all_sym2dollararg(iemgui.get(), srlsym);
-                            if (srl_is_valid(srlsym[0])) {
-                                sendSymbol = String::fromUTF8(iemgui->x_snd_unexpanded->s_name);
-                            }
-                            if (srl_is_valid(srlsym[1])) {
-                                receiveSymbol = String::fromUTF8(iemgui->x_rcv_unexpanded->s_name);
-                            }
-                        }
-                        finalFormatedName = nameWithoutArgs;
-                        break;
-                    }
-                    case hash("keyboard"): {
-                        if (auto keyboardObject = object.cast<t_fake_keyboard>()) {
-                            sendSymbol = String(keyboardObject->x_send->s_name);
-                            receiveSymbol = String(keyboardObject->x_receive->s_name);
-                        }
-                        finalFormatedName = nameWithoutArgs;
-                        break;
-                    }
-                    case hash("pic"): {
-                        if (auto picObject = object.cast<t_fake_pic>()) {
-                            sendSymbol = String(picObject->x_send->s_name);
-                            receiveSymbol = String(picObject->x_receive->s_name);
-                        }
-                        finalFormatedName = nameWithoutArgs;
-                        break;
-                    }
-                    case hash("scope~"): {
-                        if (auto scopeObject = object.cast<t_fake_scope>()) {
-                            receiveSymbol = String(scopeObject->x_receive->s_name);
-                        }
-                        finalFormatedName = nameWithoutArgs;
-                        break;
-                    }
-                    case hash("function"): {
-                        if (auto keyboardObject = object.cast<t_fake_function>()) {
-                            sendSymbol = String(keyboardObject->x_send->s_name);
-                            receiveSymbol = String(keyboardObject->x_receive->s_name);
-                        }
-                        finalFormatedName = nameWithoutArgs;
-                        break;
-                    }
-                    case hash("note"): {
-                        if (auto noteObject = object.cast<t_fake_note>()) {
-                            receiveSymbol = String(noteObject->x_receive->s_name);
-                        }
-                        finalFormatedName = nameWithoutArgs;
-                        break;
-                    }
-                    case hash("knob"): {
-                        if (auto knobObj = object.cast<t_fake_knob>()) {
-                            sendSymbol = String(knobObj->x_snd->s_name);
-                            receiveSymbol = String(knobObj->x_rcv->s_name);
-                        }
-                        finalFormatedName = nameWithoutArgs;
-                        break;
-                    }
-                    case hash("gatom"): {
-                        auto gatomObject = object.cast<t_fake_gatom>();
-                        String gatomName;
-                        switch (gatomObject->a_flavor) {
-                        case A_FLOAT:
-                            gatomName = "floatbox";
-                            break;
-                        case A_SYMBOL:
-                            gatomName = "symbolbox";
-                            break;
-                        case A_NULL:
-                            gatomName = "listbox";
-                            break;
-                        default:
-                            break;
-                        }
-                        receiveSymbol = String(gatomObject->a_symfrom->s_name);
-                        sendSymbol = String(gatomObject->a_symto->s_name);
-                        finalFormatedName = gatomName;
-                        objectName = gatomName;
-                        break;
-                    }
-                    case hash("message"): {
-                        finalFormatedName = "msg: " + name;
-                        break;
-                    }
-                    case hash("comment"): {
-                        finalFormatedName = "comment: " + name;
-                        break;
-                    }
-                    case hash("text"): {
-                        switch (object.cast<t_fake_text_define>()->x_textbuf.b_ob.te_type) {
-                        case T_TEXT: {
-                            // if object & classname is text, then it's a comment
-                            finalFormatedName = String("comment: ") + name;
-                            objectName = "comment";
-                            break;
-                        }
-                        case T_OBJECT: {
-                            // if object is T_OBJECT but classname is 'text' object is in error state
-                            element.setProperty("IconColour", Colours::red.toString(), nullptr);
-
-                            if (name.isEmpty()) {
-                                finalFormatedName = String("empty");
-                                objectName = "empty";
-                            } else {
-                                finalFormatedName = String("unknown: ") + name;
-                                objectName = "unknown";
-                            }
-                            break;
-                        }
-                        default:
-                            break;
-                        }
-                        break;
-                    }
-                    case hash("canvas"):
-                    case hash("bicoeff"):
-                    case hash("messbox"):
-                    case hash("pad"):
-                    case hash("button"): {
-                        finalFormatedName = nameWithoutArgs;
-                        break;
-                    }
-
-                    default: {
-                        switch (hash(nameWithoutArgs)) {
-                        case hash("s"):
-                        case hash("s~"):
-                        case hash("send"):
-                        case hash("send~"):
-                        case hash("throw~"): {
-                            sendSymbol = getFirstArgumentFromFullName(name);
-                            element.setProperty("SendObject", 1, nullptr);
-                            finalFormatedName = nameWithoutArgs;
-                            break;
-                        }
-                        case hash("r"):
-                        case hash("r~"):
-                        case hash("receive"):
-                        case hash("receive~"):
-                        case hash("catch~"): {
-                            receiveSymbol = getFirstArgumentFromFullName(name);
-                            element.setProperty("ReceiveObject", 1, nullptr);
-                            finalFormatedName = nameWithoutArgs;
-                            break;
-                        }
-                        case hash("t"):
-                        case hash("trigger"):
-                            element.setProperty("TriggerObject", 1, nullptr);
-                            finalFormatedName = name;
-                            break;
-                        case hash("v"):
-                        case hash("value"):
-                            element.setProperty("ValueObject", 1, nullptr);
-                            finalFormatedName = name;
-                            break;
-                        case hash("i"):
-                        case hash("int"):
-                            element.setProperty("IntObject", 1, nullptr);
-                            finalFormatedName = name;
-                            break;
-                        case hash("f"):
-                        case hash("float"):
-                            element.setProperty("FloatObject", 1, nullptr);
-                            finalFormatedName = name;
-                            break;
-                        default:
-                            finalFormatedName = name;
-                            break;
-                        }
-                        break;
-                    }
-                    }
-                    element.setProperty("ObjectName", objectName, nullptr);
-                    element.setProperty("Name", finalFormatedName, nullptr);
-                    // Add send/receive tags if they exist
-                    if (sendSymbol.isNotEmpty() && (sendSymbol != "empty") && (sendSymbol != "nosndno")) {
-                        element.setProperty("SendSymbol", sendSymbol, nullptr);
-                    }
-                    if (receiveSymbol.isNotEmpty() && (receiveSymbol != "empty")) {
-                        element.setProperty("ReceiveSymbol", receiveSymbol, nullptr);
-                    }
-                    element.setProperty("RightText", positionText, nullptr);
-                    element.setProperty("Icon", Icons::Object, nullptr);
-                    element.setProperty("Object", reinterpret_cast<int64>(object.cast<void>()), nullptr);
-                    if (currentCanvas) {
-                        for (auto comp : currentCanvas->getLassoSelection()) {
-                            if (auto obj = dynamic_cast<Object*>(comp.get())) {
-                                if (obj->getPointer() == object.cast<t_gobj>())
-                                    element.setProperty("Selected", true, nullptr);
-                            }
-                        }
-                    }
-                    element.setProperty("TopLevel", reinterpret_cast<int64>(top), nullptr);
-                    element.setProperty("Index", index, nullptr);
-
-                    index++;
-                }
-
-                patchTree.appendChild(element, nullptr);
-            }
-        }
-
-        return patchTree;
-    }
-
     SafePointer<Canvas> currentCanvas;
     PluginEditor* editor;
+    PatchSearchIndex searchIndex;
     ValueTreeViewerComponent patchTree = ValueTreeViewerComponent("(Subpatch)");
     SearchEditor input;
 };
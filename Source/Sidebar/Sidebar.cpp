@@ -12,6 +12,7 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 #include "Canvas.h"
+#include "Objects/ObjectBase.h"
 
 #include "Components/SearchEditor.h"
 #include "Sidebar.h"
@@ -35,6 +35,7 @@ TabComponent::TabComponent(PluginEditor* editor)
     editor->pd->triggerAsyncUpdate();
 
     triggerAsyncUpdate();
+    startTimer(5000);
 }
 
 TabComponent::~TabComponent()
@@ -534,12 +535,14 @@ void TabComponent::showTab(Canvas* cnv, int splitIndex)
 
     if (splits[splitIndex] && splits[splitIndex] != splits[!splitIndex]) {
         splits[splitIndex]->saveViewportState();
+        splits[splitIndex]->lastShownTime = Time::getMillisecondCounter();
         removeChildComponent(splits[splitIndex]->viewport.get());
     }
 
     splits[splitIndex] = cnv;
 
     if (cnv) {
+        cnv->rehydrate();
         addAndMakeVisible(cnv->viewport.get());
         cnv->setVisible(true);
         cnv->grabKeyboardFocus();
@@ -785,10 +788,57 @@ void TabComponent::closeTab(Canvas* cnv)
     pd->patchesLock.exit();
 
     pd->updateObjectImplementations();
+    pd->invalidateParameterObjectIndex();
 
     triggerAsyncUpdate();
 }
 
+void TabComponent::timerCallback()
+{
+    hibernateHiddenCanvases();
+}
+
+// Release the GUI of tabs that have been hidden for a while, or of the least recently shown tabs when we're over the memory budget
+void TabComponent::hibernateHiddenCanvases()
+{
+    if (editor->isInPluginMode())
+        return;
+
+    auto* settings = SettingsFile::getInstance();
+    auto hibernateTime = static_cast<uint32>(std::max(settings->getProperty<int>("tab_hibernate_time"), 0)) * 1000;
+    auto memoryBudget = static_cast<size_t>(std::max(settings->getProperty<int>("canvas_memory_budget"), 0)) << 20;
+
+    auto visibleCanvases = getVisibleCanvases();
+    auto now = Time::getMillisecondCounter();
+
+    size_t memoryUsage = 0;
+    SmallArray<Canvas*> hiddenCanvases;
+    for (auto* cnv : canvases) {
+        if (cnv->isHibernated)
+            continue;
+
+        memoryUsage += cnv->getEstimatedMemoryUsage();
+        if (visibleCanvases.contains(cnv))
+            cnv->lastShownTime = now;
+        else
+            hiddenCanvases.add(cnv);
+    }
+
+    std::sort(hiddenCanvases.begin(), hiddenCanvases.end(), [](Canvas const* a, Canvas const* b) {
+        return a->lastShownTime < b->lastShownTime;
+    });
+
+    for (auto* cnv : hiddenCanvases) {
+        auto hiddenTooLong = hibernateTime && now - cnv->lastShownTime >= hibernateTime;
+        auto overBudget = memoryBudget && memoryUsage > memoryBudget;
+        if (!hiddenTooLong && !overBudget)
+            break;
+
+        memoryUsage -= cnv->getEstimatedMemoryUsage();
+        cnv->hibernate();
+    }
+}
+
 void TabComponent::addLastShownTab(Canvas* tab, int split)
 {
     if (lastShownTabs[split].contains(tab))
@@ -7,7 +7,8 @@
 class PluginMode;
 class TabComponent : public Component
     , public DragAndDropTarget
-    , public AsyncUpdater {
+    , public AsyncUpdater
+    , public Timer {
     class TabBarButtonComponent;
 
 public:
@@ -51,6 +52,9 @@ private:
     void clearCanvases();
     void handleAsyncUpdate() override;
 
+    void timerCallback() override;
+    void hibernateHiddenCanvases();
+
     void sendTabUpdateToVisibleCanvases();
 
     void resized() override;
@@ -11,6 +11,8 @@ struct CachedStringWidth {
 
     static int calculateSingleLineWidth(String const& singleLine)
     {
+        // Patch silhouettes for the welcome panel are generated on a background thread
+        SpinLock::ScopedLockType lock(stringWidthCacheLock);
         auto stringHash = hash(singleLine);
 
         auto cacheHit = stringWidthCache.find(stringHash);
@@ -34,6 +36,7 @@ struct CachedStringWidth {
     }
 
     static inline UnorderedMap<hash32, int> stringWidthCache = UnorderedMap<hash32, int>();
+    static inline SpinLock stringWidthCacheLock;
 };
 
 struct CachedFontStringWidth : public DeletedAtShutdown {
@@ -1,13 +1,212 @@
 #pragma once
 
+// Shared texture for rendered text layouts, so that we don't need a separate texture for every text object
+// Text is packed into horizontal shelves. When the atlas is full, the least recently used shelf gets recycled
+class TextAtlas {
+public:
+    struct Entry {
+        Rectangle<int> area;
+        float scale;
+        int shelf;
+        String text; // Keys are hashed, so we check the text to make sure a collision doesn't show the wrong text
+    };
+
+    static constexpr int atlasSize = 2048;
+    static constexpr int maxEntryHeight = atlasSize / 4;
+    static constexpr int entryPadding = 2;
+
+    TextAtlas(bool colourAtlas)
+        : isColourAtlas(colourAtlas)
+    {
+        texture.onImageInvalidate = [this]() {
+            reset();
+        };
+    }
+
+    static TextAtlas* getAtlasForContext(NVGcontext* nvg, bool colourAtlas)
+    {
+        auto& atlas = (colourAtlas ? colourAtlases : alphaAtlases)[nvg];
+        if (!atlas)
+            atlas = std::make_unique<TextAtlas>(colourAtlas);
+        return atlas.get();
+    }
+
+    static void releaseContext(NVGcontext* nvg)
+    {
+        alphaAtlases.erase(nvg);
+        colourAtlases.erase(nvg);
+    }
+
+    // Call once per frame: shelves that have been drawn in the current frame can't be recycled,
+    // because nanovg only flushes its draw calls at the end of the frame
+    static void beginFrame()
+    {
+        currentFrame++;
+    }
+
+    // Zoom scales are quantised to quarter octaves, so zooming in or out doesn't rasterise text for every possible scale
+    static int getScaleBucket(float scale)
+    {
+        return static_cast<int>(std::ceil(std::log2(std::max(scale, 0.01f)) * 4.0f - 0.01f));
+    }
+
+    static float getBucketScale(int bucket)
+    {
+        return std::exp2(bucket / 4.0f);
+    }
+
+    Entry const* find(uint64 key, String const& text)
+    {
+        auto it = entries.find(key);
+        if (it == entries.end() || it->second.text != text)
+            return nullptr;
+
+        shelves[it->second.shelf].lastUsedFrame = currentFrame;
+        return &it->second;
+    }
+
+    // Allocates space for the text and rasterises it into the atlas. Returns nullptr if the text doesn't fit
+    Entry const* add(NVGcontext* nvg, uint64 key, String const& text, int width, int height, float scale, std::function<void(Graphics&)> const& renderCall)
+    {
+        if (width + entryPadding > atlasSize || height + entryPadding > maxEntryHeight)
+            return nullptr;
+
+        if (!atlasImage.isValid()) {
+            atlasImage = Image(isColourAtlas ? Image::ARGB : Image::SingleChannel, atlasSize, atlasSize, true, SoftwareImageType());
+        }
+        if (!texture.isValid()) {
+            texture.loadJUCEImage(nvg, atlasImage);
+        }
+
+        auto shelfIndex = allocateShelf(width + entryPadding, height + entryPadding);
+        if (shelfIndex < 0)
+            return nullptr;
+
+        auto& shelf = shelves[shelfIndex];
+        auto area = Rectangle<int>(shelf.x, shelf.y, width, height);
+        shelf.x += width + entryPadding;
+        shelf.lastUsedFrame = currentFrame;
+        shelf.keys.add(key);
+
+        {
+            Graphics g(atlasImage);
+            g.reduceClipRegion(area);
+            g.setOrigin(area.getPosition());
+            renderCall(g);
+        }
+
+        // Upload the whole shelf, so the padding around the entry is guaranteed to be empty on the GPU as well
+        Image::BitmapData imageData(atlasImage, Image::BitmapData::readOnly);
+        auto* params = nvgInternalParams(nvg);
+        params->renderUpdateTexture(params->userPtr, texture.getImageId(), 0, shelf.y, atlasSize, shelf.height, imageData.data);
+
+        auto& entry = entries[key];
+        entry = { area, scale, shelfIndex, text };
+        return &entry;
+    }
+
+    int getImageId()
+    {
+        return texture.getImageId();
+    }
+
+private:
+    struct Shelf {
+        int y;
+        int height;
+        int x = 0;
+        uint32 lastUsedFrame = 0;
+        SmallArray<uint64> keys;
+    };
+
+    int allocateShelf(int width, int height)
+    {
+        // Try to fit it into a shelf with a similar height first
+        for (int i = 0; i < shelves.size(); i++) {
+            auto& shelf = shelves[i];
+            if (height <= shelf.height && height * 4 >= shelf.height * 3 && shelf.x + width <= atlasSize)
+                return i;
+        }
+
+        auto shelfHeight = (height + 7) & ~7;
+        if (nextShelfY + shelfHeight <= atlasSize) {
+            shelves.add({ nextShelfY, shelfHeight });
+            nextShelfY += shelfHeight;
+            return shelves.size() - 1;
+        }
+
+        int leastRecentlyUsed = -1;
+        bool atlasInUse = false;
+        for (int i = 0; i < shelves.size(); i++) {
+            auto& shelf = shelves[i];
+            if (shelf.lastUsedFrame == currentFrame) {
+                atlasInUse = true;
+                continue;
+            }
+            if (shelf.height >= height && (leastRecentlyUsed < 0 || shelf.lastUsedFrame < shelves[leastRecentlyUsed].lastUsedFrame))
+                leastRecentlyUsed = i;
+        }
+
+        if (leastRecentlyUsed >= 0) {
+            clearShelf(leastRecentlyUsed);
+            return leastRecentlyUsed;
+        }
+
+        // No shelf is tall enough: if nothing has been drawn from the atlas this frame, we can start over with a new layout
+        if (!atlasInUse) {
+            reset();
+            return allocateShelf(width, height);
+        }
+
+        return -1;
+    }
+
+    void clearShelf(int shelfIndex)
+    {
+        auto& shelf = shelves[shelfIndex];
+        for (auto key : shelf.keys)
+            entries.erase(key);
+
+        shelf.keys.clear();
+        shelf.x = 0;
+        atlasImage.clear({ 0, shelf.y, atlasSize, shelf.height });
+    }
+
+    void reset()
+    {
+        entries.clear();
+        shelves.clear();
+        nextShelfY = 0;
+        if (atlasImage.isValid())
+            atlasImage.clear(atlasImage.getBounds());
+    }
+
+    bool isColourAtlas;
+    Image atlasImage;
+    NVGImage texture;
+
+    UnorderedMap<uint64, Entry> entries;
+    HeapArray<Shelf> shelves;
+    int nextShelfY = 0;
+
+    static inline uint32 currentFrame = 0;
+    static inline UnorderedMap<NVGcontext*, std::unique_ptr<TextAtlas>> alphaAtlases;
+    static inline UnorderedMap<NVGcontext*, std::unique_ptr<TextAtlas>> colourAtlases;
+};
+
 class CachedTextRender {
 public:
     CachedTextRender() = default;
 
-    void renderText(NVGcontext* nvg, Rectangle<int> const& bounds, float scale)
+    void renderText(NVGcontext* nvg, Rectangle<int> const& bounds, float scale, bool isZooming = false)
     {
+        auto imageBounds = Rectangle<int>(bounds.getX(), bounds.getY(), bounds.getWidth() + 3, bounds.getHeight());
+        if (renderTextFromAtlas(nvg, bounds, imageBounds, scale, isZooming))
+            return;
+
+        // Text is too large for the atlas, so render it to its own image
         if (updateImage || !image.isValid() || lastRenderBounds != bounds || lastScale != scale) {
-            renderTextToImage(nvg, Rectangle<int>(bounds.getX(), bounds.getY(), bounds.getWidth() + 3, bounds.getHeight()), scale);
+            renderTextToImage(nvg, imageBounds, scale);
             lastRenderBounds = bounds;
             lastScale = scale;
             updateImage = false;
@@ -53,8 +252,7 @@ public:
     // If you want to use this for text measuring as well, you might want the measuring to be ready before
     bool prepareLayout(String const& text, Font const& font, Colour const& colour, int const width, int const cachedWidth, bool const highlightObjectSyntax)
     {
-        auto textHash = hash(text);
-        bool needsUpdate = lastTextHash != textHash || colour != lastColour || cachedWidth != lastWidth || highlightObjectSyntax != isSyntaxHighlighted;
+        bool needsUpdate = lastText != text || colour != lastColour || cachedWidth != lastWidth || highlightObjectSyntax != isSyntaxHighlighted;
         if (needsUpdate) {
             AttributedString attributedText;
             if (highlightObjectSyntax) {
@@ -72,8 +270,11 @@ public:
 
             idealHeight = layout.getHeight();
             lastWidth = cachedWidth;
+            layoutWidth = width;
 
-            lastTextHash = textHash;
+            lastText = text;
+            lastTextHash = hash(text);
+            lastFontHash = hash(font.toString());
             lastColour = colour;
             isSyntaxHighlighted = highlightObjectSyntax;
             updateImage = true;
@@ -99,11 +300,82 @@ public:
     }
 
 private:
+    bool renderTextFromAtlas(NVGcontext* nvg, Rectangle<int> const& bounds, Rectangle<int> const& imageBounds, float scale, bool isZooming)
+    {
+        auto* atlas = TextAtlas::getAtlasForContext(nvg, isSyntaxHighlighted);
+        auto scaleBucket = TextAtlas::getScaleBucket(scale);
+        auto key = getAtlasKey(imageBounds, scaleBucket);
+
+        auto const* entry = atlas->find(key, lastText);
+
+        // While zooming, reuse the text at a nearby scale. When zooming stops, the canvas repaints and we'll rasterise at the exact scale
+        if (!entry && isZooming) {
+            for (auto offset : { -1, 1, -2, 2 }) {
+                if ((entry = atlas->find(getAtlasKey(imageBounds, scaleBucket + offset), lastText)))
+                    break;
+            }
+        }
+
+        if (!entry) {
+            auto atlasScale = TextAtlas::getBucketScale(scaleBucket);
+            int width = std::ceil(imageBounds.getWidth() * atlasScale);
+            int height = std::ceil(imageBounds.getHeight() * atlasScale);
+            entry = atlas->add(nvg, key, lastText, width, height, atlasScale, [this, imageBounds, atlasScale](Graphics& g) {
+                g.addTransform(AffineTransform::scale(atlasScale, atlasScale));
+                g.reduceClipRegion(imageBounds.withTrimmedRight(4)); // If it touches the edges of the image, it'll look bad
+                layout.draw(g, imageBounds.toFloat());
+            });
+        }
+
+        if (!entry)
+            return false;
+
+        // Release the fallback image if we had one
+        if (image.isValid())
+            image = NVGImage();
+
+        // The atlas entry contains the area from the component origin to the bottom-right of the text, so place the pattern accordingly
+        auto atlasExtent = TextAtlas::atlasSize / entry->scale;
+        auto originX = entry->area.getX() / -entry->scale;
+        auto originY = entry->area.getY() / -entry->scale;
+        auto entryBounds = Rectangle<float>(0, 0, entry->area.getWidth() / entry->scale, entry->area.getHeight() / entry->scale);
+        auto fillBounds = imageBounds.toFloat().getIntersection(entryBounds);
+
+        NVGScopedState scopedState(nvg);
+        nvgIntersectScissor(nvg, bounds.getX(), bounds.getY(), bounds.getWidth(), bounds.getHeight());
+        auto imagePattern = isSyntaxHighlighted ? nvgImagePattern(nvg, originX, originY, atlasExtent, atlasExtent, 0, atlas->getImageId(), 1.0f) : nvgImageAlphaPattern(nvg, originX, originY, atlasExtent, atlasExtent, 0, atlas->getImageId(), NVGComponent::convertColour(lastColour));
+
+        nvgFillPaint(nvg, imagePattern);
+        nvgFillRect(nvg, fillBounds.getX(), fillBounds.getY(), fillBounds.getWidth(), fillBounds.getHeight());
+        return true;
+    }
+
+    // Identical text layouts share an atlas entry. The colour only matters for syntax highlighted text, otherwise it's applied when drawing
+    uint64 getAtlasKey(Rectangle<int> const& imageBounds, int scaleBucket) const
+    {
+        auto combine = [](uint64 seed, uint64 value) {
+            return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+        };
+
+        uint64 key = lastTextHash;
+        key = combine(key, lastFontHash);
+        key = combine(key, static_cast<uint32>(layoutWidth));
+        key = combine(key, (static_cast<uint64>(static_cast<uint32>(imageBounds.getX())) << 32) | static_cast<uint32>(imageBounds.getY()));
+        key = combine(key, (static_cast<uint64>(static_cast<uint32>(imageBounds.getWidth())) << 32) | static_cast<uint32>(imageBounds.getHeight()));
+        key = combine(key, static_cast<uint32>(scaleBucket));
+        if (isSyntaxHighlighted)
+            key = combine(key, lastColour.getARGB());
+        return key;
+    }
+
     NVGImage image;
+    String lastText;
     hash32 lastTextHash = 0;
+    hash32 lastFontHash = 0;
     float lastScale = 1.0f;
     Colour lastColour;
     int lastWidth = 0;
+    int layoutWidth = 0;
     int idealWidth = 0, idealHeight = 0;
     Rectangle<int> lastRenderBounds;
 
@@ -1791,6 +1791,10 @@ public:
     {
     }
 
+    HeapArray(HeapArray&& other) noexcept = default;
+    HeapArray& operator=(HeapArray const& other) = default;
+    HeapArray& operator=(HeapArray&& other) noexcept = default;
+
     // Adds an element if it doesn't already exist
     bool add_unique(T const& to_find)
     {
@@ -1864,6 +1868,7 @@ public:
     T const& operator[](size_t index) const { return data_[index]; }
     void clear() { data_.clear(); }
     T* data() { return data_.data(); }
+    T const* data() const { return data_.data(); }
 
     template<typename U>
     [[nodiscard]] bool contains(U const& to_find) const
@@ -2210,6 +2215,20 @@ public:
         data_.clear();
     }
 
+    // Clear all elements, and also give the pooled memory back instead of keeping it around for reuse
+    void clear_and_release()
+    {
+        clear();
+
+        for (auto [ptr, size] : free_list) {
+            allocator_.deallocate(ptr, size);
+        }
+        free_list.clear();
+        reuse_list.clear();
+        num_preallocated = 0;
+        stackUsed = 0;
+    }
+
     void reserve(size_t capacity)
     {
         data_.reserve(capacity);
@@ -35,3 +35,17 @@ inline hash32 hash(juce::String const& str)
 {
     return hash(str.toRawUTF8());
 }
+
+/**
+ * FNV-1a hash function for raw bytes, pass in a previous result to hash multiple blocks
+ */
+inline hash32 hash(void const* data, size_t size, hash32 result = EMPTY_HASH)
+{
+    auto const* bytes = static_cast<uint8_t const*>(data);
+    for (size_t i = 0; i < size; i++) {
+        result ^= (hash32)bytes[i];
+        result *= (hash32)0x01000193;
+    }
+
+    return result;
+}
@@ -0,0 +1,190 @@
+/*
+ // Copyright (c) 2024 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+#include "NVGSurface.h"
+
+// Process-wide cache of images shown by [pic] objects, keyed by path and modification time
+// Images are decoded on background threads, and the GPU textures are shared between all objects and canvases that show the same image
+class ImageAssetCache : public DeletedAtShutdown {
+
+    static inline ImageAssetCache* instance = nullptr;
+
+public:
+    // Maximum texture size for a single tile
+    static constexpr int tileSize = 8192;
+
+    class Asset : public ReferenceCountedObject
+        , public ChangeBroadcaster {
+    public:
+        using Ptr = ReferenceCountedObjectPtr<Asset>;
+        using Tiles = SmallArray<std::pair<std::unique_ptr<NVGImage>, Rectangle<int>>>;
+
+        Asset(String assetKey, File file)
+            : key(std::move(assetKey))
+            , imageFile(std::move(file))
+        {
+        }
+
+        ~Asset() override
+        {
+            if (instance)
+                instance->assets.erase(key);
+        }
+
+        bool isLoaded() const { return state == Loaded; }
+        bool failedToLoad() const { return state == Failed; }
+
+        int getWidth() const { return width; }
+        int getHeight() const { return height; }
+
+        // Returns the textures for this context, or an empty list while the image is still being decoded
+        Tiles const& getTiles(NVGcontext* nvg)
+        {
+            auto& textures = contextTextures[nvg];
+            if (textures.isValid)
+                return textures.tiles;
+
+            textures.tiles.clear();
+            if (!decodedImage.isValid()) {
+                // We already threw away the decoded image, because all textures were uploaded before
+                if (state == Loaded)
+                    requestDecode();
+                return textures.tiles;
+            }
+
+            for (int x = 0; x < width; x += tileSize) {
+                auto tileWidth = std::min(tileSize, width - x);
+                for (int y = 0; y < height; y += tileSize) {
+                    auto tileHeight = std::min(tileSize, height - y);
+                    auto bounds = Rectangle<int>(x, y, tileWidth, tileHeight);
+                    auto clip = decodedImage.getClippedImage(bounds);
+
+                    auto tile = std::make_unique<NVGImage>(nvg, tileWidth, tileHeight, [&clip](Graphics& g) {
+                        g.drawImageAt(clip, 0, 0);
+                    });
+
+                    // Can't remove the tile here, since this gets called while iterating over all images
+                    tile->onImageInvalidate = [this, nvg]() {
+                        contextTextures[nvg].isValid = false;
+                        sendChangeMessage();
+                    };
+
+                    textures.tiles.emplace_back(std::move(tile), bounds);
+                }
+            }
+            textures.isValid = true;
+
+            // Clear image from CPU memory after upload, we'll decode it again if another context needs it
+            decodedImage = Image();
+            return textures.tiles;
+        }
+
+    private:
+        void requestDecode()
+        {
+            if (isDecoding || !instance)
+                return;
+
+            isDecoding = true;
+            instance->decodePool.addJob([asset = Ptr(this)]() mutable {
+                auto image = loadImage(asset->imageFile);
+
+                // Keep all asset state on the message thread, this also makes sure the asset is never deleted on the decoding thread
+                MessageManager::callAsync([asset = std::move(asset), image]() mutable {
+                    asset->decodeFinished(image);
+                });
+            });
+        }
+
+        void decodeFinished(Image const& image)
+        {
+            isDecoding = false;
+            decodedImage = image;
+            if (image.isValid()) {
+                width = image.getWidth();
+                height = image.getHeight();
+                state = Loaded;
+            } else {
+                state = Failed;
+            }
+
+            sendChangeMessage();
+        }
+
+        static Image loadImage(File const& file)
+        {
+            FileInputStream fileStream(file);
+            if (fileStream.openedOk()) {
+                return ImageFileFormat::loadFrom(fileStream).convertedToFormat(Image::ARGB);
+            }
+            return {};
+        }
+
+        enum LoadState {
+            Loading,
+            Loaded,
+            Failed
+        };
+
+        struct ContextTextures {
+            Tiles tiles;
+            bool isValid = false;
+        };
+
+        String const key;
+        File const imageFile;
+
+        LoadState state = Loading;
+        bool isDecoding = false;
+        int width = 0, height = 0;
+
+        Image decodedImage;
+        UnorderedMap<NVGcontext*, ContextTextures> contextTextures;
+
+        friend class ImageAssetCache;
+    };
+
+    ImageAssetCache()
+        : decodePool(2, Thread::osDefaultStackSize, Thread::Priority::background)
+    {
+    }
+
+    ~ImageAssetCache() override
+    {
+        instance = nullptr;
+        decodePool.removeAllJobs(true, 5000);
+    }
+
+    static ImageAssetCache* getInstance()
+    {
+        if (!instance)
+            instance = new ImageAssetCache();
+        return instance;
+    }
+
+    // Returns the shared asset for an image file, and starts decoding it if needed
+    Asset::Ptr getAsset(File const& file)
+    {
+        JUCE_ASSERT_MESSAGE_THREAD;
+
+        auto key = file.getFullPathName() + ":" + String(file.getLastModificationTime().toMilliseconds());
+        auto it = assets.find(key);
+        if (it != assets.end())
+            return it->second;
+
+        Asset::Ptr asset = new Asset(key, file);
+        assets[key] = asset.get();
+        asset->requestDecode();
+        return asset;
+    }
+
+private:
+    ThreadPool decodePool;
+
+    // Assets remove themselves from this map once the last object stops using them
+    UnorderedMap<String, Asset*> assets;
+};
@@ -8,12 +8,97 @@
 #include <juce_audio_utils/juce_audio_utils.h>
 #include "Utility/Containers.h"
 
+// Lock-free single producer, single consumer ring of MIDI events
+// Events are stored as a small header followed by the raw MIDI bytes, so SysEx doesn't need any allocations either
+class MidiEventRing {
+    struct Header {
+        double timestamp;
+        int numBytes;
+    };
+
+public:
+    explicit MidiEventRing(int capacity = 1 << 16)
+        : fifo(capacity)
+        , buffer(capacity)
+        , scratch(capacity)
+    {
+    }
+
+    // Returns false if there was no space left, in which case the event is dropped
+    bool push(uint8 const* data, int numBytes, double timestamp)
+    {
+        auto const totalSize = static_cast<int>(sizeof(Header)) + numBytes;
+        if (fifo.getFreeSpace() < totalSize)
+            return false;
+
+        Header header { timestamp, numBytes };
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(totalSize, start1, size1, start2, size2);
+        copyToRing(reinterpret_cast<uint8 const*>(&header), sizeof(Header), 0, start1, size1, start2);
+        copyToRing(data, numBytes, sizeof(Header), start1, size1, start2);
+        fifo.finishedWrite(totalSize);
+        return true;
+    }
+
+    // Calls back with (data, numBytes, timestamp) for every event in the ring
+    template<typename Callback>
+    void popAll(Callback&& callback)
+    {
+        int numReady;
+        while ((numReady = fifo.getNumReady()) >= static_cast<int>(sizeof(Header))) {
+            int start1, size1, start2, size2;
+            fifo.prepareToRead(numReady, start1, size1, start2, size2);
+
+            Header header;
+            copyFromRing(reinterpret_cast<uint8*>(&header), sizeof(Header), 0, start1, size1, start2);
+            copyFromRing(scratch.data(), header.numBytes, sizeof(Header), start1, size1, start2);
+            fifo.finishedRead(static_cast<int>(sizeof(Header)) + header.numBytes);
+
+            callback(scratch.data(), header.numBytes, header.timestamp);
+        }
+    }
+
+    bool isEmpty() const { return fifo.getNumReady() == 0; }
+
+private:
+    void copyToRing(uint8 const* source, int numBytes, int offset, int start1, int size1, int start2)
+    {
+        for (int i = 0; i < numBytes; i++) {
+            auto const position = offset + i;
+            buffer[position < size1 ? start1 + position : start2 + position - size1] = source[i];
+        }
+    }
+
+    void copyFromRing(uint8* destination, int numBytes, int offset, int start1, int size1, int start2) const
+    {
+        for (int i = 0; i < numBytes; i++) {
+            auto const position = offset + i;
+            destination[i] = buffer[position < size1 ? start1 + position : start2 + position - size1];
+        }
+    }
+
+    AbstractFifo fifo;
+    HeapArray<uint8> buffer;
+    HeapArray<uint8> scratch;
+};
+
+// Handles MIDI device I/O without locks or allocations on the audio thread
+// MIDI input threads push into fixed per-port rings that the audio thread drains, and the audio thread pushes
+// timestamped output into per-port rings that a dedicated output thread polls and sends out to the devices
+// The port tables are only changed on the message thread, under a lock that the audio thread never takes
 class MidiDeviceManager : public ChangeListener
     , public AsyncUpdater
-    , public MidiInputCallback {
+    , public MidiInputCallback
+    , private Thread {
 
 public:
+    static constexpr int numPorts = 8;
+
+    // How often the output thread checks for new output from the audio thread, in milliseconds
+    static constexpr int outputPollInterval = 1;
+
     MidiDeviceManager()
+        : Thread("MIDI Output Thread")
     {
 #if !JUCE_WINDOWS && !JUCE_IOS
         if (ProjectInfo::isStandalone) {
@@ -32,20 +117,33 @@ public:
         }
 
         updateMidiDevices();
-        midiBufferIn.ensureSize(2048);
-        midiBufferOut[0].ensureSize(2048);
+        midiBufferIn.ensureSize(midiBufferSize);
+        for (auto& buffer : midiBufferOut)
+            buffer.ensureSize(midiBufferSize);
+        hostMidiInput.ensureSize(midiBufferSize);
+        hostMidiBlock.ensureSize(midiBufferSize);
+        hostMidiRemaining.ensureSize(midiBufferSize);
+        for (auto& buffer : deviceMidiInput)
+            buffer.ensureSize(midiBufferSize);
+
+        startThread(Thread::Priority::highest);
     }
 
     ~MidiDeviceManager()
     {
+        stopThread(-1);
         saveMidiSettings();
     }
 
-    void prepareToPlay(float sampleRate)
+    // sampleRate and samplesPerBlock are the host's, oversampleFactor converts them to Pd's rate
+    void prepareToPlay(float sampleRate, int samplesPerBlock, int oversampleFactor)
     {
         currentSampleRate = sampleRate;
-        for (auto& [port, collector] : midiMessageCollector)
-            collector->reset(sampleRate);
+        pdSampleRate = sampleRate * oversampleFactor;
+        deviceInputLatency = samplesPerBlock * oversampleFactor;
+        hostMidiInput.clear();
+        for (auto& buffer : deviceMidiInput)
+            buffer.clear();
     }
 
     void updateMidiDevices()
@@ -85,6 +183,7 @@ public:
 
     String getPortDescription(bool isInput, int port)
     {
+        ScopedLock lock(portsLock);
         if (isInput) {
             auto portIter = inputPorts.find(port);
             if (portIter != inputPorts.end()) {
@@ -119,6 +218,7 @@ public:
             isInput = true;
         }
 
+        ScopedLock lock(portsLock);
         if (isInput) {
             for (auto& [port, devices] : inputPorts) {
                 auto hasDevice = std::find_if(devices.begin(), devices.end(), [identifier](MidiInput* input) { return input->getIdentifier() == identifier; }) != devices.end();
@@ -155,86 +255,125 @@ public:
 
     void setMidiDevicePort(bool isInput, String const& identifier, int port)
     {
+        JUCE_ASSERT_MESSAGE_THREAD;
+
+        // Opening a device can take a while, so we only hold the lock while changing the port tables
         bool shouldBeEnabled = port >= 0;
         if (isInput) {
-            auto* device = moveMidiDevice(inputPorts, identifier, port);
+            MidiInput* device;
+            {
+                ScopedLock lock(portsLock);
+                device = moveMidiDevice(inputPorts, identifier, port);
+            }
             if (!device && shouldBeEnabled) {
                 if (auto midiIn = MidiInput::openDevice(identifier, this)) {
-                    auto* input = inputPorts[port].add(midiIn.release());
-                    input->start();
+                    ScopedLock lock(portsLock);
+                    device = inputPorts[port].add(midiIn.release());
                 }
-            } else if (device && shouldBeEnabled) {
+            }
+
+            if (device && shouldBeEnabled) {
                 device->start();
             } else if (device && !shouldBeEnabled) {
                 device->stop();
             }
         } else {
+            auto midiOut = shouldBeEnabled && !hasMidiDevice(outputPorts, identifier) ? MidiOutput::openDevice(identifier) : nullptr;
+
+            ScopedLock lock(portsLock);
             auto* device = moveMidiDevice(outputPorts, identifier, port);
-            if (!device && shouldBeEnabled) {
-                if (auto midiOut = MidiOutput::openDevice(identifier)) {
-                    auto* output = outputPorts[port].add(midiOut.release());
-                    output->startBackgroundThread();
-                }
-            } else if (device && shouldBeEnabled) {
-                device->startBackgroundThread();
-            } else if (device && !shouldBeEnabled) {
-                device->stopBackgroundThread();
+            if (midiOut) {
+                outputPorts[port].add(midiOut.release());
+            }
+
+            // Disabled outputs are closed, only our own virtual output stays open when it's disabled
+            if (device && !shouldBeEnabled && device != fromPlugdata) {
+                outputPorts[port].removeObject(device);
+            }
+
+            for (int i = 0; i < numPorts; i++) {
+                auto portIter = outputPorts.find(i);
+                outputPortEnabled[i] = portIter != outputPorts.end() && !portIter->second.isEmpty();
             }
         }
         triggerAsyncUpdate();
     }
 
-    // Function to enqueue external MIDI (like the DAW's MIDI coming in with processBlock)
-    void enqueueMidiInput(int port, MidiBuffer& buffer)
+    template<typename T>
+    static bool hasMidiDevice(UnorderedSegmentedMap<int, OwnedArray<T>>& ports, String const& identifier)
     {
-        auto collectorIter = midiMessageCollector.find(port);
-        if (collectorIter == midiMessageCollector.end()) {
-            midiMessageCollector[port] = std::make_unique<MidiMessageCollector>();
-            collectorIter = midiMessageCollector.find(port);
-            (*collectorIter).second->reset(currentSampleRate);
+        for (auto& [port, devices] : ports) {
+            if (std::find_if(devices.begin(), devices.end(), [identifier](auto* device) { return device && (device->getIdentifier() == identifier); }) != devices.end())
+                return true;
         }
+        return false;
+    }
+
+    // Function to enqueue external MIDI (like the DAW's MIDI coming in with processBlock)
+    // We keep its sample positions, instead of re-timing it by wall-clock like MidiMessageCollector does
+    // sampleOffset is the number of samples that Pd will process before reaching this block, sampleScale is the oversampling factor
+    void enqueueHostMidiInput(MidiBuffer const& buffer, int sampleOffset, int sampleScale)
+    {
         for (auto event : buffer) {
-            (*collectorIter).second->addMessageToQueue(event.getMessage());
+            addEventWithoutAllocating(hostMidiInput, event.data, event.numBytes, sampleOffset + event.samplePosition * sampleScale);
         }
     }
 
     // Handle midi input events in a callback
     void dequeueMidiInput(int blockSize, std::function<void(int, int, MidiBuffer&)> inputCallback)
     {
-        for (auto& [port, collector] : midiMessageCollector) {
-            if (port < 0)
-                continue;
-            midiBufferIn.clear();
-            collector->removeNextBlockOfMessages(midiBufferIn, blockSize);
-            inputCallback(port, blockSize, midiBufferIn);
+        // Pass on the DAW's MIDI that falls within this Pd block, and move the rest closer by one block
+        if (takeBlock(hostMidiInput, hostMidiBlock, blockSize))
+            inputCallback(0, blockSize, hostMidiBlock);
+
+        // Device MIDI is timestamped by wall-clock, so like MidiMessageCollector, we play it back one host block later
+        // This keeps the spacing between events, instead of bunching up everything that arrived since the last callback
+        auto const now = Time::getMillisecondCounterHiRes() * 0.001;
+        for (int port = 0; port < numPorts; port++) {
+            auto& pending = deviceMidiInput[port];
+            midiInputRings[port].popAll([this, &pending, now](uint8 const* data, int numBytes, double timestamp) {
+                auto const samplePosition = deviceInputLatency + roundToInt((timestamp - now) * pdSampleRate);
+                addEventWithoutAllocating(pending, data, numBytes, jlimit(0, deviceInputLatency, samplePosition));
+            });
+
+            if (takeBlock(pending, midiBufferIn, blockSize))
+                inputCallback(port, blockSize, midiBufferIn);
         }
     }
 
     // Adds output message to buffer
     void enqueueMidiOutput(int port, MidiMessage const& message, int samplePosition)
     {
-        midiBufferOut[port].addEvent(message, samplePosition);
+        if (!isPositiveAndBelow(port, numPorts))
+            return;
+
+        addEventWithoutAllocating(midiBufferOut[port], message.getRawData(), message.getRawDataSize(), samplePosition);
     }
 
     // Read output buffer for a port. Used to pass back into the DAW or into the internal GM synth
     void dequeueMidiOutput(int port, MidiBuffer& buffer, int numSamples)
     {
-        auto& outputBuffer = midiBufferOut[port];
-        buffer.addEvents(outputBuffer, 0, numSamples, 0);
+        if (!isPositiveAndBelow(port, numPorts))
+            return;
+
+        buffer.addEvents(midiBufferOut[port], 0, numSamples, 0);
     }
 
-    // Send all MIDI output to target devices
+    // Pass all MIDI output to the output thread, which will send it to the target devices
     void sendMidiOutput()
     {
-        for (auto& [port, events] : midiBufferOut) {
-            if (port < 0)
-                continue;
-
-            for (auto* device : outputPorts[port]) {
-                device->sendBlockOfMessages(events, Time::getMillisecondCounterHiRes(), currentSampleRate);
+        auto const blockStartTime = Time::getMillisecondCounterHiRes();
+        for (int port = 0; port < numPorts; port++) {
+            auto& events = midiBufferOut[port];
+            if (outputPortEnabled[port]) {
+                for (auto event : events) {
+                    midiOutputRings[port].push(event.data, event.numBytes, blockStartTime + 1000.0 * event.samplePosition / currentSampleRate);
+                }
             }
             events.clear();
         }
+
+        // We don't wake the output thread from here, because that would take a lock; it polls the rings instead
     }
 
     // Load last MIDI settings from our settings file
@@ -274,6 +413,7 @@ public:
     // Store current MIDI settings in our settings file
     void saveMidiSettings()
     {
+        ScopedLock lock(portsLock);
         auto midiOutputsTree = SettingsFile::getInstance()->getValueTree().getChildWithName("EnabledMidiOutputPorts");
 
         midiOutputsTree.removeAllChildren(nullptr);
@@ -305,33 +445,88 @@ public:
 
     void getLastMidiOutputEvents(MidiBuffer& buffer, int numSamples)
     {
-        for (auto& [port, events] : midiBufferOut) {
-            if (port < 0)
-                continue;
-
+        for (auto& events : midiBufferOut) {
             buffer.addEvents(events, 0, numSamples, 0);
         }
     }
 
 private:
+    // MidiBuffers are preallocated, so instead of letting them grow on the audio thread, we drop events that don't fit anymore
+    static void addEventWithoutAllocating(MidiBuffer& buffer, uint8 const* data, int numBytes, int samplePosition)
+    {
+        auto const requiredSize = buffer.data.size() + static_cast<int>(sizeof(int32) + sizeof(uint16)) + numBytes;
+        if (requiredSize <= buffer.data.getNumAllocated())
+            buffer.addEvent(data, numBytes, samplePosition);
+    }
+
+    // Moves the events of the next Pd block from pending into block, and moves the rest of pending closer by one block
+    bool takeBlock(MidiBuffer& pending, MidiBuffer& block, int blockSize)
+    {
+        block.clear();
+        if (pending.isEmpty())
+            return false;
+
+        hostMidiRemaining.clear();
+        for (auto event : pending) {
+            if (event.samplePosition < blockSize)
+                addEventWithoutAllocating(block, event.data, event.numBytes, event.samplePosition);
+            else
+                addEventWithoutAllocating(hostMidiRemaining, event.data, event.numBytes, event.samplePosition - blockSize);
+        }
+        pending.swapWith(hostMidiRemaining);
+        return !block.isEmpty();
+    }
+
     void handleIncomingMidiMessage(MidiInput* input, MidiMessage const& message) override
     {
-        auto port = [this, input]() {
-            for (auto& [port, devices] : inputPorts) {
-                if (devices.contains(input))
-                    return port;
+        // Multiple devices can be assigned to the same port, and they may call back from different threads
+        // Holding the ports lock makes sure there's only one producer for each ring
+        ScopedLock lock(portsLock);
+        for (auto& [port, devices] : inputPorts) {
+            if (devices.contains(input)) {
+                if (isPositiveAndBelow(port, numPorts))
+                    midiInputRings[port].push(message.getRawData(), message.getRawDataSize(), message.getTimeStamp());
+                return;
             }
-            return -1;
-        }();
-
-        if (port >= 0) {
-            auto collectorIter = midiMessageCollector.find(port);
-            if (collectorIter == midiMessageCollector.end()) {
-                midiMessageCollector[port] = std::make_unique<MidiMessageCollector>();
-                collectorIter = midiMessageCollector.find(port);
-                (*collectorIter).second->reset(currentSampleRate);
+        }
+    }
+
+    void run() override
+    {
+        struct ScheduledMessage {
+            int port;
+            double timestamp;
+            MidiMessage message;
+        };
+        HeapArray<ScheduledMessage> scheduledMessages;
+
+        while (!threadShouldExit()) {
+            for (int port = 0; port < numPorts; port++) {
+                midiOutputRings[port].popAll([&scheduledMessages, port](uint8 const* data, int numBytes, double timestamp) {
+                    scheduledMessages.add({ port, timestamp, MidiMessage(data, numBytes) });
+                });
+            }
+
+            if (scheduledMessages.not_empty()) {
+                auto const now = Time::getMillisecondCounterHiRes();
+
+                ScopedLock lock(portsLock);
+                scheduledMessages.erase(std::remove_if(scheduledMessages.begin(), scheduledMessages.end(), [this, now](ScheduledMessage const& scheduled) {
+                    if (scheduled.timestamp > now)
+                        return false;
+
+                    auto portIter = outputPorts.find(scheduled.port);
+                    if (portIter != outputPorts.end()) {
+                        for (auto* device : portIter->second)
+                            device->sendMessageNow(scheduled.message);
+                    }
+                    return true;
+                }),
+                    scheduledMessages.end());
             }
-            collectorIter->second->addMessageToQueue(message);
+
+            // Messages are due with millisecond precision, so polling at that interval also picks up new output in time
+            wait(outputPollInterval);
         }
     }
 
@@ -345,11 +540,23 @@ private:
         updateMidiDevices();
     }
 
+    static constexpr int midiBufferSize = 8192;
+
     float currentSampleRate = 44100.f;
+    double pdSampleRate = 44100.0;
+    int deviceInputLatency = 512;
 
     MidiBuffer midiBufferIn;
-    UnorderedSegmentedMap<int, MidiBuffer> midiBufferOut;
-    UnorderedSegmentedMap<int, std::unique_ptr<MidiMessageCollector>> midiMessageCollector;
+    MidiBuffer hostMidiInput, hostMidiBlock, hostMidiRemaining;
+    StackArray<MidiBuffer, numPorts> midiBufferOut;
+
+    StackArray<MidiEventRing, numPorts> midiInputRings;
+    StackArray<MidiEventRing, numPorts> midiOutputRings;
+    StackArray<MidiBuffer, numPorts> deviceMidiInput;
+    StackArray<std::atomic<bool>, numPorts> outputPortEnabled = {};
+
+    // Protects the port tables. Never taken on the audio thread
+    CriticalSection portsLock;
     UnorderedSegmentedMap<int, OwnedArray<MidiInput>> inputPorts;
     UnorderedSegmentedMap<int, OwnedArray<MidiOutput>> outputPorts;
 
@@ -296,9 +296,11 @@ SmallArray<Rectangle<int>> OfflineObjectRenderer::getObjectBoundsForPatch(String
     return objectBounds;
 }
 
-String OfflineObjectRenderer::patchToSVG(String const& patch)
+String OfflineObjectRenderer::patchToSVG(String const& patch, int* numObjects)
 {
     auto objectRects = getObjectBoundsForPatch(patch);
+    if (numObjects)
+        *numObjects = objectRects.size();
 
     String svgContent;
     auto regionOfInterest = Rectangle<int>();
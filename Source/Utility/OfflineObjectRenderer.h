@@ -23,7 +23,7 @@ public:
 
 class OfflineObjectRenderer {
 public:
-    static String patchToSVG(String const& patch);
+    static String patchToSVG(String const& patch, int* numObjects = nullptr);
     static ImageWithOffset patchToMaskedImage(String const& patch, float scale, bool makeInvalidImage = false);
 
     static std::pair<SmallArray<bool>, SmallArray<bool>> countIolets(String const& patch);
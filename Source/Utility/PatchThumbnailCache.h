@@ -0,0 +1,239 @@
+/*
+ // Copyright (c) 2024 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+*/
+
+#pragma once
+#include "Utility/OfflineObjectRenderer.h"
+
+// Persistent cache of the welcome panel tile data for recently opened patches
+// Entries are keyed by patch path, and are only regenerated when the modification time or size of the patch changes
+// The cache file is read in one pass at startup, everything else happens on a background thread
+class PatchThumbnailCache : public Thread
+    , public ChangeBroadcaster
+    , public DeletedAtShutdown {
+
+    static inline PatchThumbnailCache* instance = nullptr;
+
+public:
+    struct Entry {
+        String path;
+        int64 modificationTime = 0;
+        int64 fileSize = 0;
+        String silhouetteSvg;
+        int numObjects = 0;
+        String thumbnailPath;
+
+        // Decoded thumbnail image, only kept in memory
+        Image thumbnailImage;
+    };
+
+    PatchThumbnailCache()
+        : Thread("Patch Thumbnail Thread")
+    {
+        readCacheFile();
+        startThread(Thread::Priority::background);
+    }
+
+    ~PatchThumbnailCache() override
+    {
+        instance = nullptr;
+        signalThreadShouldExit();
+        notify();
+        stopThread(-1);
+    }
+
+    static PatchThumbnailCache* getInstance()
+    {
+        if (!instance)
+            instance = new PatchThumbnailCache();
+        return instance;
+    }
+
+    // Returns the last known entry for a patch without touching the filesystem
+    // It might be outdated: call requestEntries to get it validated
+    std::optional<Entry> getEntry(File const& patchFile)
+    {
+        ScopedLock lock(entriesLock);
+        auto it = entries.find(patchFile.getFullPathName());
+        if (it != entries.end())
+            return it->second;
+
+        return std::nullopt;
+    }
+
+    // Queue patches to be checked against their cached entries. When any entry changed, a change message is sent
+    void requestEntries(StringArray const& patchPaths)
+    {
+        {
+            ScopedLock lock(entriesLock);
+            requestedPaths = patchPaths;
+        }
+        notify();
+    }
+
+private:
+    static constexpr int cacheMagic = 0x50445443; // "PDTC"
+    static constexpr int cacheVersion = 1;
+
+    void run() override
+    {
+        while (!threadShouldExit()) {
+            wait(-1);
+
+            StringArray pathsToCheck;
+            {
+                ScopedLock lock(entriesLock);
+                pathsToCheck.swapWith(requestedPaths);
+            }
+
+            if (pathsToCheck.isEmpty())
+                continue;
+
+            bool entriesChanged = false;
+            for (auto& path : pathsToCheck) {
+                if (threadShouldExit())
+                    return;
+
+                auto patchFile = File(path);
+                if (!patchFile.existsAsFile())
+                    continue;
+
+                auto modificationTime = patchFile.getLastModificationTime().toMilliseconds();
+                auto fileSize = patchFile.getSize();
+
+                auto cachedEntry = getEntry(patchFile);
+                if (cachedEntry.has_value() && cachedEntry->modificationTime == modificationTime && cachedEntry->fileSize == fileSize) {
+                    // Metadata is still valid, but thumbnail images are not persisted
+                    if (cachedEntry->thumbnailPath.isNotEmpty() && !cachedEntry->thumbnailImage.isValid()) {
+                        cachedEntry->thumbnailImage = loadThumbnailImage(File(cachedEntry->thumbnailPath));
+                        if (cachedEntry->thumbnailImage.isValid()) {
+                            setEntry(*cachedEntry);
+                            entriesChanged = true;
+                        }
+                    }
+                    continue;
+                }
+
+                setEntry(generateEntry(patchFile, modificationTime, fileSize));
+                entriesChanged = true;
+            }
+
+            if (entriesChanged) {
+                pruneEntries(pathsToCheck);
+                writeCacheFile();
+                sendChangeMessage();
+            }
+        }
+    }
+
+    static Entry generateEntry(File const& patchFile, int64 modificationTime, int64 fileSize)
+    {
+        Entry entry;
+        entry.path = patchFile.getFullPathName();
+        entry.modificationTime = modificationTime;
+        entry.fileSize = fileSize;
+
+        auto patchThumbnailBase = File(patchFile.getParentDirectory().getFullPathName() + "\\" + patchFile.getFileNameWithoutExtension() + "_thumb");
+        for (auto& ext : StringArray { ".png", ".jpg", ".jpeg", ".gif" }) {
+            auto patchThumbnail = patchThumbnailBase.withFileExtension(ext);
+            if (patchThumbnail.existsAsFile()) {
+                entry.thumbnailPath = patchThumbnail.getFullPathName();
+                entry.thumbnailImage = loadThumbnailImage(patchThumbnail);
+                break;
+            }
+        }
+
+        // We still generate the silhouette when there is a thumbnail, for when the thumbnail fails to load
+        entry.silhouetteSvg = OfflineObjectRenderer::patchToSVG(patchFile.loadFileAsString(), &entry.numObjects);
+        return entry;
+    }
+
+    static Image loadThumbnailImage(File const& thumbnailFile)
+    {
+        FileInputStream fileStream(thumbnailFile);
+        if (fileStream.openedOk()) {
+            return ImageFileFormat::loadFrom(fileStream).convertedToFormat(Image::ARGB);
+        }
+        return {};
+    }
+
+    void setEntry(Entry const& entry)
+    {
+        ScopedLock lock(entriesLock);
+        entries[entry.path] = entry;
+    }
+
+    // Only keep entries that were part of the last request, so the cache doesn't keep growing
+    void pruneEntries(StringArray const& pathsToKeep)
+    {
+        ScopedLock lock(entriesLock);
+        for (auto it = entries.begin(); it != entries.end();) {
+            if (!pathsToKeep.contains(it->first))
+                it = entries.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    void readCacheFile()
+    {
+        if (!cacheFile.existsAsFile())
+            return;
+
+        // Read the whole file at once, instead of seeking through it
+        MemoryBlock cacheData;
+        if (!cacheFile.loadFileAsData(cacheData))
+            return;
+
+        MemoryInputStream istream(cacheData, false);
+        if (istream.readInt() != cacheMagic || istream.readInt() != cacheVersion)
+            return;
+
+        auto numEntries = istream.readInt();
+
+        ScopedLock lock(entriesLock);
+        for (int i = 0; i < numEntries && !istream.isExhausted(); i++) {
+            Entry entry;
+            entry.path = istream.readString();
+            entry.modificationTime = istream.readInt64();
+            entry.fileSize = istream.readInt64();
+            entry.silhouetteSvg = istream.readString();
+            entry.numObjects = istream.readInt();
+            entry.thumbnailPath = istream.readString();
+            entries[entry.path] = entry;
+        }
+    }
+
+    void writeCacheFile()
+    {
+        MemoryOutputStream ostream;
+        ostream.writeInt(cacheMagic);
+        ostream.writeInt(cacheVersion);
+        {
+            ScopedLock lock(entriesLock);
+            ostream.writeInt(static_cast<int>(entries.size()));
+            for (auto& [path, entry] : entries) {
+                ostream.writeString(entry.path);
+                ostream.writeInt64(entry.modificationTime);
+                ostream.writeInt64(entry.fileSize);
+                ostream.writeString(entry.silhouetteSvg);
+                ostream.writeInt(entry.numObjects);
+                ostream.writeString(entry.thumbnailPath);
+            }
+        }
+
+        // Write to a temporary file first, so a crash can't leave a half-written cache behind
+        TemporaryFile tempFile(cacheFile);
+        if (tempFile.getFile().replaceWithData(ostream.getData(), ostream.getDataSize())) {
+            tempFile.overwriteTargetFileWithTemporary();
+        }
+    }
+
+    static inline File const cacheFile = ProjectInfo::appDataDir.getChildFile(".thumbnail_cache");
+
+    CriticalSection entriesLock;
+    UnorderedMap<String, Entry> entries;
+    StringArray requestedPaths;
+};
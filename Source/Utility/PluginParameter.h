@@ -82,8 +82,11 @@ public:
 
     void setName(String const& newName)
     {
-        ScopedLock lock(nameLock);
-        parameterName = newName;
+        {
+            ScopedLock lock(nameLock);
+            parameterName = newName;
+        }
+        processor.invalidateParameterIndex();
     }
 
     String getName(int maximumStringLength) const override
@@ -105,6 +108,7 @@ public:
     void setEnabled(bool shouldBeEnabled)
     {
         enabled = shouldBeEnabled;
+        processor.invalidateParameterIndex();
     }
 
     NormalisableRange<float> const& getNormalisableRange() const override
@@ -125,10 +129,15 @@ public:
         return value;
     }
 
-    void setUnscaledValueNotifyingHost(float newValue)
+    void setUnscaledValue(float newValue)
     {
         auto range = getNormalisableRange();
         value = std::clamp(newValue, range.start, range.end);
+    }
+
+    void setUnscaledValueNotifyingHost(float newValue)
+    {
+        setUnscaledValue(newValue);
         sendValueChangedMessageToListeners(getValue());
     }
 
@@ -16,13 +16,36 @@
 #include "Sidebar/CommandInput.h"
 
 SettingsFileListener::SettingsFileListener()
+    : keySubscriptions(1)
 {
-    SettingsFile::getInstance()->listeners.add(this);
+    auto* settingsFile = SettingsFile::getInstance();
+    settingsFile->subscribe(settingsFile->reloadSubscribers, reloadSubscription, this);
+    settingsFile->subscribe(settingsFile->allKeySubscribers, keySubscriptions[0], this);
+}
+
+SettingsFileListener::SettingsFileListener(std::initializer_list<char const*> keys)
+    : keySubscriptions(keys.size())
+{
+    auto* settingsFile = SettingsFile::getInstance();
+    settingsFile->subscribe(settingsFile->reloadSubscribers, reloadSubscription, this);
+
+    int i = 0;
+    for (auto* key : keys) {
+        auto& list = settingsFile->keySubscribers[String(key)];
+        if (!list)
+            list = std::make_unique<SettingsSubscriberList>();
+
+        settingsFile->subscribe(*list, keySubscriptions[i++], this);
+    }
 }
 
 SettingsFileListener::~SettingsFileListener()
 {
-    SettingsFile::getInstance()->listeners.remove_one(this);
+    auto* settingsFile = SettingsFile::getInstance();
+    settingsFile->unsubscribe(reloadSubscription);
+    for (auto& subscription : keySubscriptions) {
+        settingsFile->unsubscribe(subscription);
+    }
 }
 
 JUCE_IMPLEMENT_SINGLETON(SettingsFile)
@@ -554,9 +577,63 @@ void SettingsFile::reloadSettings()
 
     settingsTree.copyPropertiesFrom(newTree, nullptr);
 
-    for (auto* listener : listeners) {
+    notify(reloadSubscribers, [](SettingsFileListener* listener) {
         listener->settingsFileReloaded();
+    });
+}
+
+void SettingsFile::subscribe(SettingsSubscriberList& list, SettingsFileListener::Subscription& subscription, SettingsFileListener* listener)
+{
+    subscription.listener = listener;
+    subscription.list = &list;
+    subscription.previous = list.last;
+    subscription.next = nullptr;
+
+    if (list.last)
+        list.last->next = &subscription;
+    else
+        list.first = &subscription;
+
+    list.last = &subscription;
+}
+
+void SettingsFile::unsubscribe(SettingsFileListener::Subscription& subscription)
+{
+    auto* list = subscription.list;
+    if (!list)
+        return;
+
+    // Make sure notifications that are in progress don't visit this listener anymore
+    for (auto* notification = activeNotifications; notification; notification = notification->outer) {
+        if (notification->next == &subscription)
+            notification->next = subscription.next;
+    }
+
+    if (subscription.previous)
+        subscription.previous->next = subscription.next;
+    else
+        list->first = subscription.next;
+
+    if (subscription.next)
+        subscription.next->previous = subscription.previous;
+    else
+        list->last = subscription.previous;
+
+    subscription = {};
+}
+
+template<typename Callback>
+void SettingsFile::notify(SettingsSubscriberList const& list, Callback&& callback)
+{
+    Notification notification { list.first, activeNotifications };
+    activeNotifications = &notification;
+
+    while (auto* subscription = notification.next) {
+        notification.next = subscription->next;
+        callback(subscription->listener);
     }
+
+    activeNotifications = notification.outer;
 }
 
 void SettingsFile::fileChanged(File const file, FileSystemWatcher::FileSystemEvent fileEvent)
@@ -568,8 +645,16 @@ void SettingsFile::fileChanged(File const file, FileSystemWatcher::FileSystemEve
 
 void SettingsFile::valueTreePropertyChanged(ValueTree& treeWhosePropertyHasChanged, Identifier const& property)
 {
-    for (auto* listener : listeners) {
-        listener->settingsChanged(property.toString(), treeWhosePropertyHasChanged.getProperty(property));
+    auto name = property.toString();
+    auto value = treeWhosePropertyHasChanged.getProperty(property);
+
+    auto notifyListener = [&name, &value](SettingsFileListener* listener) {
+        listener->settingsChanged(name, value);
+    };
+
+    notify(allKeySubscribers, notifyListener);
+    if (auto it = keySubscribers.find(name); it != keySubscribers.end()) {
+        notify(*it->second, notifyListener);
     }
 
     if (!settingsChangedExternally)
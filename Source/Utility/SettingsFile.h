@@ -7,15 +7,41 @@
 #pragma once
 #include "Pd/Library.h"
 
+struct SettingsSubscriberList;
+
+// Listeners that pass a list of keys are only notified when one of those keys changes, other listeners are notified about every change
 class SettingsFileListener {
 public:
     SettingsFileListener();
 
+    explicit SettingsFileListener(std::initializer_list<char const*> keys);
+
     ~SettingsFileListener();
 
     virtual void settingsChanged(String const& name, var const& value) { }
 
     virtual void settingsFileReloaded() { }
+
+    // Node in one of the subscriber lists of the settings file
+    // The listener owns its nodes, so unsubscribing only has to unlink them
+    struct Subscription {
+        SettingsFileListener* listener = nullptr;
+        Subscription* previous = nullptr;
+        Subscription* next = nullptr;
+        SettingsSubscriberList* list = nullptr;
+    };
+
+private:
+    Subscription reloadSubscription;
+    HeapArray<Subscription> keySubscriptions;
+
+    // The subscriber lists point to the subscriptions of this listener, so a copy would unlink nodes it doesn't own
+    JUCE_DECLARE_NON_COPYABLE(SettingsFileListener)
+};
+
+struct SettingsSubscriberList {
+    SettingsFileListener::Subscription* first = nullptr;
+    SettingsFileListener::Subscription* last = nullptr;
 };
 
 // Class that manages the settings file
@@ -109,7 +135,22 @@ private:
 
     FileSystemWatcher settingsFileWatcher;
 
-    HeapArray<SettingsFileListener*> listeners;
+    void subscribe(SettingsSubscriberList& list, SettingsFileListener::Subscription& subscription, SettingsFileListener* listener);
+    void unsubscribe(SettingsFileListener::Subscription& subscription);
+
+    template<typename Callback>
+    void notify(SettingsSubscriberList const& list, Callback&& callback);
+
+    // Notifications that are in progress, listeners that get removed while being notified are skipped
+    struct Notification {
+        SettingsFileListener::Subscription* next;
+        Notification* outer;
+    };
+
+    SettingsSubscriberList reloadSubscribers;
+    SettingsSubscriberList allKeySubscribers;
+    UnorderedMap<String, std::unique_ptr<SettingsSubscriberList>> keySubscribers;
+    Notification* activeNotifications = nullptr;
 
     File settingsFile = ProjectInfo::appDataDir.getChildFile(".settings");
     ValueTree settingsTree = ValueTree("SettingsTree");
@@ -154,6 +195,10 @@ private:
         { "search_xy_show", var(true) },
         { "search_index_show", var(false) },
         { "open_patches_in_window", var(false) },
+        { "console_capacity", var(100000) },
+        { "deken_repository", var("") }, // Empty for plugdata's deken server, can be set to a local mirror or file:// URL
+        { "tab_hibernate_time", var(300) },    // Seconds before a hidden tab releases its GUI, 0 to disable
+        { "canvas_memory_budget", var(512) }, // Estimated GUI memory in MB that open tabs may use before hidden tabs are hibernated, 0 to disable
     };
 
     StringArray childTrees {
@@ -436,7 +436,8 @@ class ValueTreeViewerComponent : public Component
     , public SettingsFileListener {
 public:
     explicit ValueTreeViewerComponent(String prepend = String())
-        : tooltipPrepend(std::move(prepend))
+        : SettingsFileListener({ "search_order", "search_xy_show", "search_index_show" })
+        , tooltipPrepend(std::move(prepend))
     {
         if (tooltipPrepend == "(Subpatch)") { // FIXME: this is horrible
             sortLayerOrder = SettingsFile::getInstance()->getProperty<bool>("search_order");
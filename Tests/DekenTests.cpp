@@ -0,0 +1,173 @@
+#include <juce_gui_basics/juce_gui_basics.h>
+#include <juce_gui_extra/juce_gui_extra.h>
+#include <juce_cryptography/juce_cryptography.h>
+
+#include "Utility/Config.h"
+#include "Utility/Fonts.h"
+#include "Utility/SettingsFile.h"
+#include "LookAndFeel.h"
+#include "Components/Buttons.h"
+#include "Components/SearchEditor.h"
+#include "Dialogs/Dialogs.h"
+#include "Dialogs/Deken.h"
+
+#include "Tests.h"
+
+// Installs a package from a file:// URL, like a local mirror for offline use would
+// The package manager installs into a temporary directory, so the user's externals are left alone
+void testLocalPackageInstall(std::function<void()> onFinish)
+{
+    auto testDirectory = File::getSpecialLocation(File::tempDirectory).getChildFile("plugdata-package-test");
+    testDirectory.deleteRecursively();
+
+    auto sourceDirectory = testDirectory.getChildFile("source");
+    sourceDirectory.createDirectory();
+
+    auto abstraction = sourceDirectory.getChildFile("test-abstraction.pd");
+    abstraction.replaceWithText("#N canvas 0 50 450 300 12;\n#X obj 10 10 inlet;\n#X obj 10 40 outlet;\n#X connect 0 0 1 0;\n");
+
+    // Package it like deken does, with the package folder at the root of the archive and a checksum next to it
+    auto archive = testDirectory.getChildFile("plugdata-test-package.zip");
+    {
+        FileOutputStream output(archive);
+        ZipFile::Builder builder;
+        builder.addFile(abstraction, 9, "plugdata-test-package/test-abstraction.pd");
+        builder.writeToStream(output, nullptr);
+    }
+    archive.getSiblingFile(archive.getFileName() + ".sha256").replaceWithText(SHA256(archive).toHexString());
+
+    auto info = PackageInfo("plugdata-test-package", "plugdata", "2024.01.01-00.00.00", URL(archive).toString(false), "Package for testing local installs", "1.0", {});
+
+    struct TestState {
+        std::unique_ptr<PackageManager> packageManager;
+        bool finished = false;
+    };
+
+    auto installDirectory = testDirectory.getChildFile("externals");
+    auto state = std::make_shared<TestState>();
+    state->packageManager = std::make_unique<PackageManager>(installDirectory);
+    auto startTime = Time::getMillisecondCounterHiRes();
+
+    // Finishes the test once, either when the install is done or when it timed out
+    auto finishTest = [state, testDirectory, onFinish](bool completed) {
+        if (std::exchange(state->finished, true))
+            return;
+
+        expectTrue(completed, "package install finishes within 30 seconds");
+
+        // Delete the package manager after its download callback has returned
+        MessageManager::callAsync([state, testDirectory, onFinish]() {
+            state->packageManager.reset();
+            testDirectory.deleteRecursively();
+            onFinish();
+        });
+    };
+
+    auto* packageManager = state->packageManager.get();
+    auto* download = packageManager->install(info);
+    download->onFinish = [packageManager, info, installDirectory, startTime, finishTest](Result result) {
+        expectTrue(result.wasOk(), "package installs from file://: " + result.getErrorMessage());
+        expectTrue(installDirectory.getChildFile(info.name).getChildFile("test-abstraction.pd").existsAsFile(), "installed package is extracted into the install directory");
+        expectTrue(packageManager->packageExists(info), "installed package is registered");
+        expectTrue(!installDirectory.getChildFile(".downloads").getChildFile(String::toHexString(info.packageId.hashCode64()) + ".partial").exists(), "finished download is removed");
+
+        std::cout << "PACKAGE INSTALL TEST: installed from file:// in " << Time::getMillisecondCounterHiRes() - startTime << " ms" << std::endl;
+        finishTest(true);
+    };
+
+    Timer::callAfterDelay(30000, [finishTest]() {
+        finishTest(false);
+    });
+}
+
+// Builds the package index from the catalog in Fixtures/deken-catalog.json, checks the ranking and measures searching a catalog of deken's size
+void testPackageIndex()
+{
+    auto fixtureFile = File(__FILE__).getSiblingFile("Fixtures").getChildFile("deken-catalog.json");
+    auto fixture = JSON::parse(fixtureFile);
+    expectTrue(fixture.isArray() && fixture.size() == 5, "package index fixture can be read from " + fixtureFile.getFullPathName());
+    if (!fixture.isArray())
+        return;
+
+    auto toPackageList = [](var const& catalog, int copies) {
+        PackageList packages;
+        for (int copy = 0; copy < copies; copy++) {
+            for (auto const& package : *catalog.getArray()) {
+                StringArray objects;
+                for (auto const& object : *package["objects"].getArray())
+                    objects.add(object.toString());
+
+                auto suffix = copy ? String(copy) : String();
+                packages.add(PackageInfo(package["name"].toString() + suffix, package["author"].toString(), "2024.01.01-00.00.00", "", package["description"].toString(), "1.0", objects));
+            }
+        }
+        return packages;
+    };
+
+    auto packages = toPackageList(fixture, 1);
+    PackageIndex index(packages);
+
+    auto expect = [&packages, &index](String const& query, StringArray const& expectedNames) {
+        StringArray names;
+        for (auto result : index.search(query))
+            names.add(packages[result].name);
+
+        expectTrue(names == expectedNames, "package search for \"" + query + "\" finds \"" + expectedNames.joinIntoString(", ") + "\", not \"" + names.joinIntoString(", ") + "\"");
+    };
+
+    expect("else", { "else" });
+    expect("ELSE", { "else" });
+    expect("reverb", { "freeverb~" });
+    expect("meta", { "iemguts" });
+    expect("limiter~", { "zexy" });
+    expect("iem", { "iemguts", "zexy" });
+    expect("porres", { "else", "cyclone" });
+    expect("no such package", {});
+
+    // The catalog cache must survive a round trip, and data that isn't a catalog must be rejected so it gets downloaded again
+    ValueTree catalog("Catalog");
+    for (auto const& package : packages) {
+        ValueTree version("Version");
+        version.setProperty("Author", package.author, nullptr);
+        version.setProperty("Timestamp", package.timestamp, nullptr);
+        version.setProperty("URL", package.url, nullptr);
+        version.setProperty("Description", package.description, nullptr);
+        version.setProperty("Version", package.version, nullptr);
+
+        ValueTree objects("Objects");
+        for (auto const& object : package.objects) {
+            ValueTree objectTree("Object");
+            objectTree.setProperty("Name", object, nullptr);
+            objects.appendChild(objectTree, nullptr);
+        }
+        version.appendChild(objects, nullptr);
+
+        ValueTree packageTree("Package");
+        packageTree.setProperty("Name", package.name, nullptr);
+        packageTree.appendChild(version, nullptr);
+        catalog.appendChild(packageTree, nullptr);
+    }
+
+    MemoryBlock block;
+    MemoryOutputStream stream(block, false);
+    catalog.writeToStream(stream);
+    stream.flush();
+
+    PackageList parsed;
+    expectTrue(PackageManager::parsePackageList(block, parsed) && parsed.size() == packages.size() && parsed[0] == packages[0], "package catalog survives a round trip through the cache format");
+
+    auto corrupted = MemoryBlock("this is not a catalog", 21);
+    expectTrue(!PackageManager::parsePackageList(corrupted, parsed), "corrupted package catalog is rejected");
+
+    // Benchmark with a catalog of a few thousand packages, searching as if the query is being typed
+    auto largeCatalog = toPackageList(fixture, 2000);
+    auto startTime = Time::getMillisecondCounterHiRes();
+    PackageIndex largeIndex(largeCatalog);
+    std::cout << "PACKAGE INDEX BENCHMARK: indexed " << largeCatalog.size() << " packages in " << Time::getMillisecondCounterHiRes() - startTime << " ms" << std::endl;
+
+    String const query = "freeverb";
+    startTime = Time::getMillisecondCounterHiRes();
+    for (int length = 1; length <= query.length(); length++)
+        largeIndex.search(query.substring(0, length));
+    std::cout << "PACKAGE INDEX BENCHMARK: " << (Time::getMillisecondCounterHiRes() - startTime) / query.length() << " ms per keystroke" << std::endl;
+}
@@ -5,8 +5,40 @@
 #include "Sidebar/Sidebar.h" // So we can read and clear the console
 #include "Objects/ObjectBase.h" // So we can interact with object GUIs
 #include "PluginEditor.h"
+#include "Canvas.h"
+#include "Object.h"
+
+#include <m_pd.h>
+#include <g_canvas.h>
+
+#include "Tests.h"
 
 String loggedErrors;
+int numFailedChecks = 0;
+
+void expectTrue(bool condition, String const& description)
+{
+    if(condition)
+        return;
+
+    numFailedChecks++;
+    std::cerr << "TEST FAILED: " << description << std::endl;
+    jassertfalse;
+}
+
+// Reports the failed checks, and makes the test run exit with an error if there were any
+void finishChecks()
+{
+    if(numFailedChecks == 0)
+    {
+        std::cout << "ALL CHECKS PASSED" << std::endl;
+        return;
+    }
+
+    std::cerr << "CHECKS FAILED: " << numFailedChecks << std::endl;
+    if(auto* app = JUCEApplicationBase::getInstance())
+        app->setApplicationReturnValue(1);
+}
 
 void openHelpfilesRecursively(TabComponent& tabbar, std::vector<File>& helpFiles)
 {
@@ -178,6 +210,140 @@ void exportHelpFileImages(TabComponent& tabbar, File outputFileDir)
     }
 }
 
+// Opens a patch with 10k scalars that share a template, and measures building, rendering and updating their geometry
+void benchmarkScalarGeometry(TabComponent& tabbar)
+{
+    constexpr int numScalars = 10000;
+
+    String patch = "#N struct bench-note float x float y float w;\n#N canvas 0 50 1200 800 12;\n";
+    patch += "#X obj 10 10 struct bench-note float x float y float w;\n";
+    patch += "#X obj 10 40 filledpolygon 900 0 1 0 0 w 0 w 8 0 8;\n";
+
+    Random random(1);
+    for(int i = 0; i < numScalars; i++)
+    {
+        patch += "#X scalar bench-note " + String(random.nextInt(1100)) + " " + String(random.nextInt(780)) + " " + String(8 + random.nextInt(64)) + " \\;;\n";
+    }
+
+    // Drawables build their geometry in an async update, so flush those before measuring
+    auto flushUpdates = [](Canvas* cnv) {
+        for(auto* child : cnv->getChildren())
+        {
+            if(auto* updater = dynamic_cast<AsyncUpdater*>(child))
+                updater->handleUpdateNowIfNeeded();
+        }
+    };
+
+    auto renderFrame = [](Canvas* cnv) {
+        cnv->editor->nvgSurface.invalidateAll();
+        cnv->editor->nvgSurface.render();
+    };
+
+    auto startTime = Time::getMillisecondCounterHiRes();
+    auto* cnv = tabbar.openPatch(patch);
+    tabbar.handleUpdateNowIfNeeded();
+    flushUpdates(cnv);
+    renderFrame(cnv);
+    std::cout << "SCALAR BENCHMARK: opened and rendered " << numScalars << " scalars in " << Time::getMillisecondCounterHiRes() - startTime << " ms" << std::endl;
+
+    constexpr int numFrames = 20;
+    startTime = Time::getMillisecondCounterHiRes();
+    for(int i = 0; i < numFrames; i++)
+        renderFrame(cnv);
+    std::cout << "SCALAR BENCHMARK: " << (Time::getMillisecondCounterHiRes() - startTime) / numFrames << " ms per frame" << std::endl;
+
+    // Redraw without changes: the retained geometry should be reused
+    startTime = Time::getMillisecondCounterHiRes();
+    for(auto* object : cnv->objects)
+        object->gui->updateDrawables();
+    flushUpdates(cnv);
+    std::cout << "SCALAR BENCHMARK: unchanged update in " << Time::getMillisecondCounterHiRes() - startTime << " ms" << std::endl;
+
+    // Move every scalar in Pd, so all geometry has to be rebuilt
+    cnv->pd->setThis();
+    cnv->pd->lockAudioThread();
+    if(auto glist = cnv->patch.getPointer())
+    {
+        for(auto* y = glist->gl_list; y; y = y->g_next)
+        {
+            if(pd_class(&y->g_pd)->c_name != gensym("scalar"))
+                continue;
+
+            auto* scalar = reinterpret_cast<t_scalar*>(y);
+            auto* templ = template_findbyname(scalar->sc_template);
+            template_setfloat(templ, gensym("x"), scalar->sc_vec, template_getfloat(templ, gensym("x"), scalar->sc_vec, 0) + 1, 0);
+        }
+    }
+    cnv->pd->unlockAudioThread();
+
+    startTime = Time::getMillisecondCounterHiRes();
+    for(auto* object : cnv->objects)
+        object->gui->updateDrawables();
+    flushUpdates(cnv);
+    renderFrame(cnv);
+    std::cout << "SCALAR BENCHMARK: changed update and render in " << Time::getMillisecondCounterHiRes() - startTime << " ms" << std::endl;
+
+    tabbar.closeTab(cnv);
+}
+
+// Prints 100k messages per second into a console queue from another thread, while the message thread drains it once per frame like the console does
+void benchmarkConsoleThroughput()
+{
+    constexpr int numMessages = 100000;
+
+    auto queue = std::make_shared<pd::ConsoleMessageQueue>();
+    auto producerFinished = std::make_shared<WaitableEvent>();
+
+    Thread::launch([queue, producerFinished]() {
+        auto startTime = Time::getMillisecondCounterHiRes();
+        for(int i = 0; i < numMessages; i++)
+        {
+            auto message = "print: message " + String(i);
+            queue->push(nullptr, i % 10 == 0, message.toRawUTF8(), static_cast<int>(message.getNumBytesAsUTF8()));
+
+            // Keep the rate at 100 messages per millisecond
+            if(i % 1000 == 999)
+            {
+                auto ahead = i / 100.0 - (Time::getMillisecondCounterHiRes() - startTime);
+                if(ahead >= 1.0)
+                    Thread::sleep(static_cast<int>(ahead));
+            }
+        }
+        producerFinished->signal();
+    });
+
+    pd::ConsoleMessageStore store;
+    store.setCapacity(numMessages);
+
+    int numReceived = 0;
+    double longestFrame = 0.0;
+    auto drain = [&]() {
+        auto frameStart = Time::getMillisecondCounterHiRes();
+        numReceived += queue->popAll([&store](void* object, int type, char const* text, int length) {
+            store.add(object, String::fromUTF8(text, length), type);
+        });
+        longestFrame = std::max(longestFrame, Time::getMillisecondCounterHiRes() - frameStart);
+    };
+
+    auto startTime = Time::getMillisecondCounterHiRes();
+    while(!producerFinished->wait(16))
+        drain();
+    drain();
+
+    auto numDropped = queue->getAndResetNumDropped();
+    std::cout << "CONSOLE BENCHMARK: received " << numReceived << " and dropped " << numDropped << " of " << numMessages << " messages in " << Time::getMillisecondCounterHiRes() - startTime << " ms, longest frame: " << longestFrame << " ms" << std::endl;
+
+    expectTrue(numReceived + numDropped == numMessages && store.size() == numReceived, "console queue doesn't lose messages");
+
+    // Messages that are too long are truncated, but a multi-byte character at the cut must not be split
+    auto longMessage = String::repeatedString("a", pd::ConsoleMessageQueue::maxMessageLength - 1) + String(CharPointer_UTF8("\xc3\xa9"));
+    queue->push(nullptr, 0, longMessage.toRawUTF8(), static_cast<int>(longMessage.getNumBytesAsUTF8()));
+    auto numTruncated = queue->popAll([](void*, int, char const* text, int length) {
+        expectTrue(length == pd::ConsoleMessageQueue::maxMessageLength - 1 && CharPointer_UTF8::isValidString(text, length), "console truncation doesn't split a UTF-8 sequence");
+    });
+    expectTrue(numTruncated == 1, "console keeps a message that is too long");
+}
+
 void runTests(PluginEditor* editor)
 {
     static std::vector<File> allHelpfiles = {};
@@ -193,6 +359,16 @@ void runTests(PluginEditor* editor)
     }
 
     auto& tabbar = editor->getTabComponent();
+
+    benchmarkScalarGeometry(tabbar);
+    benchmarkTextEditor();
+    benchmarkConsoleThroughput();
+    testPackageIndex();
+
+    // The install finishes on the message thread, so the checks are reported once it's done
+    testLocalPackageInstall([]() {
+        finishChecks();
+    });
     
     //editor->getTopLevelComponent()->getPeer()->setBounds(Desktop::getInstance().getDisplays().getPrimaryDisplay()->userArea, false);
 
@@ -0,0 +1,10 @@
+#pragma once
+
+// Records a failed check, so the test run reports it and exits with an error code when it's done
+void expectTrue(bool condition, String const& description);
+
+void benchmarkTextEditor();
+void testPackageIndex();
+
+// Installs asynchronously, onFinish is called on the message thread once the install is done or timed out
+void testLocalPackageInstall(std::function<void()> onFinish);
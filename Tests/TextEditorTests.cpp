@@ -0,0 +1,68 @@
+#include <juce_gui_basics/juce_gui_basics.h>
+#include <juce_gui_extra/juce_gui_extra.h>
+
+#include "Utility/Config.h"
+#include "Utility/Fonts.h"
+#include "LookAndFeel.h"
+#include "Components/Buttons.h"
+#include "Components/SearchEditor.h"
+#include "Dialogs/TextEditorDialog.h"
+
+#include "Tests.h"
+
+// Loads a 100k-line Lua document into the text editor, then searches it and types at the end
+void benchmarkTextEditor()
+{
+    constexpr int numLines = 100000;
+
+    StringArray lines;
+    lines.ensureStorageAllocated(numLines);
+    for (int i = 0; i < numLines; i++) {
+        lines.add("local value" + String(i) + " = math.sin(" + String(i) + ") -- line " + String(i));
+    }
+
+    PlugDataTextEditor editor;
+    editor.setEnableSyntaxHighlighting(true);
+    editor.setBounds(0, 0, 800, 600);
+
+    Image frame(Image::ARGB, editor.getWidth(), editor.getHeight(), true);
+    auto paintFrame = [&editor, &frame]() {
+        Graphics g(frame);
+        editor.paintEntireComponent(g, false);
+    };
+
+    auto startTime = Time::getMillisecondCounterHiRes();
+    editor.setText(lines.joinIntoString("\n"));
+    paintFrame();
+    std::cout << "TEXT EDITOR BENCHMARK: loaded and painted " << numLines << " lines in " << Time::getMillisecondCounterHiRes() - startTime << " ms" << std::endl;
+
+    expectTrue(StringArray::fromLines(editor.getText()) == lines, "text editor returns the document it was given");
+
+    startTime = Time::getMillisecondCounterHiRes();
+    editor.setSearchText("value9");
+    paintFrame();
+    std::cout << "TEXT EDITOR BENCHMARK: searched and highlighted in " << Time::getMillisecondCounterHiRes() - startTime << " ms" << std::endl;
+    editor.setSearchText("");
+
+    expectTrue(!editor.hasChanged(), "searching doesn't change the document");
+
+    // Jump to the end of the document and type a line there
+    editor.keyPressed(KeyPress(KeyPress::downKey, ModifierKeys::commandModifier, 0));
+    editor.keyPressed(KeyPress(KeyPress::returnKey));
+
+    String const typed = "print(\"typed at the end\")";
+    startTime = Time::getMillisecondCounterHiRes();
+    for (auto ptr = typed.getCharPointer(); !ptr.isEmpty();) {
+        auto character = ptr.getAndAdvance();
+        editor.keyPressed(KeyPress(static_cast<int>(character), ModifierKeys::noModifiers, character));
+        paintFrame();
+    }
+    std::cout << "TEXT EDITOR BENCHMARK: " << (Time::getMillisecondCounterHiRes() - startTime) / typed.length() << " ms per typed character" << std::endl;
+
+    auto editedLines = StringArray::fromLines(editor.getText());
+    expectTrue(editedLines.size() == numLines + 1 && editedLines[numLines] == typed, "typed text ends up on a new line at the end of the document");
+
+    editedLines.removeRange(numLines, editedLines.size() - numLines);
+    expectTrue(editedLines == lines, "typing at the end leaves the rest of the document intact");
+    expectTrue(editor.hasChanged(), "typing marks the document as changed");
+}